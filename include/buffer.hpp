@@ -23,8 +23,8 @@ namespace vke
     auto mapMemory(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) -> VkResult;
     void unmapMemory();
 
-    void write(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
-    void writeByIndex(void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize index = 0);
+    void write(const void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0);
+    void writeByIndex(const void* data, VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize index = 0);
 
     auto flush(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) -> VkResult;
     auto invalidate(VkDeviceSize size = VK_WHOLE_SIZE, VkDeviceSize offset = 0) -> VkResult;
@@ -27,10 +27,26 @@ namespace vke
     {
       return viewMatrix;
     }
+    glm::vec3 const& position() const
+    {
+      return viewPosition;
+    }
+    // of the perspective projection, view space depths
+    float nearPlane() const
+    {
+      return nearZ;
+    }
+    float farPlane() const
+    {
+      return farZ;
+    }
 
   private:
     glm::mat4 viewMatrix{1.f};
     glm::mat4 projectionMatrix{1.f};
+    glm::vec3 viewPosition{0.f};
+    float nearZ{0.1f};
+    float farZ{10.f};
   };
 
   inline void Camera::setViewTarget(glm::vec3 position, glm::vec3 target, glm::vec3 up)
@@ -32,8 +32,13 @@ namespace vke::cmp
     Model* model() { return m_model; }
     void setModel(Model* model) { m_model = model; }
 
+    // the level of detail drawn last frame, see Model::selectLod()
+    uint32_t lod() const { return m_lod; }
+    void setLod(uint32_t lod) { m_lod = lod; }
+
   private:
     Model* m_model{};
+    uint32_t m_lod{};
   };
 
   struct Color
@@ -47,6 +52,14 @@ namespace vke::cmp
   struct PointLight
   {
     glm::vec3 position{};
-    glm::vec3 intensity{};
+    glm::vec3 color{1.f, 1.f, 1.f};
+    float intensity{1.f};
+    float radius{1.f}; // no light reaches past it, see LightClusters
+  };
+
+  // the entity's shading parameters, an id of the MaterialLibrary
+  struct Material
+  {
+    uint32_t id{}; // MaterialLibrary::defaultMaterial
   };
 } // namespace vke::component
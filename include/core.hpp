@@ -1,6 +1,8 @@
 #pragma once
 
 #include "stdLibraries.hpp"
+//
+#include "profiler.hpp"
 
 // others
 #include <glm/glm.hpp>
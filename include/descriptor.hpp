@@ -5,15 +5,26 @@
 
 namespace vke
 {
+  class DescriptorLayoutCache;
+
+  // one descriptor's info, as update templates read them (see DescriptorSetLayout::updateTemplate)
+  union DescriptorInfo
+  {
+    VkDescriptorBufferInfo buffer;
+    VkDescriptorImageInfo image;
+  };
+
   class DescriptorSetLayout
   {
     friend class DescriptorWriter;
+    friend class DescriptorLayoutCache;
 
   public:
     class Builder;
     class Writer;
 
-    DescriptorSetLayout(Device& device, std::vector<VkDescriptorSetLayoutBinding>* bindings);
+    // bindingFlags, when given, match the bindings one to one. update after bind ones make an update after bind layout
+    DescriptorSetLayout(Device& device, std::vector<VkDescriptorSetLayoutBinding>* bindings, std::vector<VkDescriptorBindingFlags> bindingFlags = {});
     ~DescriptorSetLayout();
 
     DescriptorSetLayout(DescriptorSetLayout const&) = delete;
@@ -24,15 +35,27 @@ namespace vke
       return m_descriptorSetLayout;
     }
 
+    // writes a whole set from one DescriptorInfo per binding, in binding order. made on the first call, null
+    // without VK_KHR_descriptor_update_template or when a binding isn't a single buffer or image descriptor
+    auto updateTemplate() -> VkDescriptorUpdateTemplate;
+    auto bindings() const -> std::span<const VkDescriptorSetLayoutBinding>
+    {
+      return m_bindings;
+    }
+
   private:
     Device& m_device;
     VkDescriptorSetLayout m_descriptorSetLayout{};
     std::vector<VkDescriptorSetLayoutBinding> m_bindings{};
+
+    VkDescriptorUpdateTemplate m_updateTemplate{};
+    bool m_updateTemplateChecked{};
   };
 
   class DescriptorPool
   {
     friend class DescriptorWriter;
+    friend class DescriptorAllocator;
 
   public:
     class Builder;
@@ -57,6 +80,7 @@ namespace vke
 
   private:
     void allocate(VkDescriptorSetLayout const* descriptorSetLayouts, uint32_t count, VkDescriptorSet* descriptors);
+    auto tryAllocate(VkDescriptorSetLayout const* descriptorSetLayouts, uint32_t count, VkDescriptorSet* descriptors) -> VkResult;
     void free(uint32_t count, VkDescriptorSet const* descriptorSets);
 
     Device& m_device;
@@ -91,27 +115,296 @@ namespace vke
       uint32_t binding,
       VkDescriptorType descriptorType,
       VkShaderStageFlags stageFlags,
-      uint32_t count = 1);
+      uint32_t count = 1,
+      VkDescriptorBindingFlags flags = 0);
 
     void clear()
     {
       m_bindings.clear();
+      m_bindingFlags.clear();
     }
     auto build() -> std::unique_ptr<DescriptorSetLayout>;
+    // the cache's layout with these bindings, created on the first request. binding flags aren't cached
+    auto build(DescriptorLayoutCache& cache) -> DescriptorSetLayout&;
 
   private:
     Device& m_device;
     std::vector<VkDescriptorSetLayoutBinding> m_bindings{};
+    std::vector<VkDescriptorBindingFlags> m_bindingFlags{};
+  };
+
+  // descriptor set layouts shared by their bindings: the same bindings, in any order, give back the same
+  // layout. they live as long as the cache
+  class DescriptorLayoutCache
+  {
+  public:
+    DescriptorLayoutCache(Device& device);
+
+    DescriptorLayoutCache(DescriptorLayoutCache const&) = delete;
+    DescriptorLayoutCache& operator=(DescriptorLayoutCache const&) = delete;
+
+    auto get(std::vector<VkDescriptorSetLayoutBinding> bindings) -> DescriptorSetLayout&;
+
+    auto size() const -> size_t
+    {
+      return m_size;
+    }
+
+  private:
+    static auto hash(std::span<const VkDescriptorSetLayoutBinding> bindings) -> size_t;
+    static bool equal(std::span<const VkDescriptorSetLayoutBinding> a, std::span<const VkDescriptorSetLayoutBinding> b);
+
+    Device& m_device;
+    std::unordered_map<size_t, std::vector<std::unique_ptr<DescriptorSetLayout>>> m_layouts; // by hash, the colliding ones side by side
+    size_t m_size{};
+  };
+
+  // hands out descriptor sets without planning the pool sizes up front. sets come from the current pool, a full
+  // one (VK_ERROR_OUT_OF_POOL_MEMORY) is set aside for a new one, each bigger than the last up to maxSetsPerPool.
+  // reset() recycles every set at once: one allocator per frame in flight, reset once its fence signaled, gives
+  // the frame transient sets (see Renderer::frameDescriptors)
+  class DescriptorAllocator
+  {
+  public:
+    // descriptors of the type per set, a pool for n sets holds ceil(n * ratio) of them
+    struct PoolRatio
+    {
+      VkDescriptorType type;
+      float ratio;
+    };
+
+    static constexpr uint32_t maxSetsPerPool{4096};
+
+    static auto defaultRatios() -> std::vector<PoolRatio>
+    {
+      return {
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, 1.f},
+        {VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC, 0.5f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, 2.f},
+        {VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, 2.f},
+        {VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE, 0.5f},
+        {VK_DESCRIPTOR_TYPE_STORAGE_IMAGE, 0.5f},
+      };
+    }
+
+    DescriptorAllocator(Device& device, std::vector<PoolRatio> ratios = defaultRatios(), uint32_t setsPerPool = 64);
+
+    DescriptorAllocator(DescriptorAllocator const&) = delete;
+    DescriptorAllocator& operator=(DescriptorAllocator const&) = delete;
+
+    auto allocate(VkDescriptorSetLayout descriptorSetLayout) -> VkDescriptorSet;
+    // in one call when they fit in a pool
+    void allocate(std::span<const VkDescriptorSetLayout> descriptorSetLayouts, VkDescriptorSet* descriptorSets);
+    // every set allocated so far becomes invalid, none of them may still be in use by the gpu
+    void reset();
+
+    auto poolCount() const -> size_t
+    {
+      return m_fullPools.size() + m_readyPools.size();
+    }
+
+  private:
+    auto takePool() -> std::unique_ptr<DescriptorPool>;
+
+    Device& m_device;
+    std::vector<PoolRatio> m_ratios;
+    uint32_t m_setsPerPool;
+
+    std::vector<std::unique_ptr<DescriptorPool>> m_fullPools{};
+    std::vector<std::unique_ptr<DescriptorPool>> m_readyPools{}; // the last one is the current
+  };
+
+  // hands out the indices of a fixed size table, the released ones first (last released, first reused)
+  class SlotAllocator
+  {
+  public:
+    static constexpr uint32_t invalidSlot{std::numeric_limits<uint32_t>::max()};
+
+    explicit SlotAllocator(uint32_t capacity = 0) :
+        m_capacity{capacity}
+    {
+    }
+
+    // invalidSlot when they're all taken
+    auto acquire() -> uint32_t
+    {
+      if(!m_free.empty()) {
+        uint32_t slot{m_free.back()};
+        m_free.pop_back();
+        return slot;
+      }
+
+      return m_next < m_capacity ? m_next++ : invalidSlot;
+    }
+
+    void release(uint32_t slot)
+    {
+      assert(slot < m_next && "Releasing a slot that was never acquired");
+      m_free.push_back(slot);
+    }
+
+    auto capacity() const -> uint32_t
+    {
+      return m_capacity;
+    }
+    auto used() const -> uint32_t
+    {
+      return m_next - static_cast<uint32_t>(m_free.size());
+    }
+
+  private:
+    uint32_t m_capacity;
+    uint32_t m_next{}; // past the highest slot handed out so far
+    std::vector<uint32_t> m_free{};
+  };
+
+  // bindless resources (needs Device::bindlessSupported): one update after bind descriptor set holding every
+  // registered storage buffer and sampled image, for all stages. shaders declare the arrays as
+  //   layout(set = N, binding = 0) readonly buffer X { ... } buffers[];
+  //   layout(set = N, binding = 1) uniform sampler2D images[];
+  // and index them with the slots handed out here, passed as per draw or per instance data. the set is bound
+  // once and never rewritten as a whole, so draws don't depend on which resources they read. slots may be
+  // registered and changed while it's bound, as long as the gpu isn't reading the ones being changed.
+  // the capacities are clamped to the device's update after bind limits, see bufferSlots().capacity()
+  class BindlessTable
+  {
+  public:
+    static constexpr uint32_t bufferBinding{0};
+    static constexpr uint32_t imageBinding{1};
+    static constexpr uint32_t invalidSlot{SlotAllocator::invalidSlot};
+
+    BindlessTable(Device& device, uint32_t bufferCapacity = 4096, uint32_t imageCapacity = 4096);
+
+    BindlessTable(BindlessTable const&) = delete;
+    BindlessTable& operator=(BindlessTable const&) = delete;
+
+    auto addBuffer(const VkDescriptorBufferInfo& bufferInfo) -> uint32_t;
+    auto addImage(const VkDescriptorImageInfo& imageInfo) -> uint32_t;
+    // points a slot at another resource
+    void setBuffer(uint32_t slot, const VkDescriptorBufferInfo& bufferInfo);
+    void setImage(uint32_t slot, const VkDescriptorImageInfo& imageInfo);
+    // the slot is reused by the next add, the gpu must be done with it
+    void releaseBuffer(uint32_t slot);
+    void releaseImage(uint32_t slot);
+
+    auto descriptorSetLayout() -> VkDescriptorSetLayout
+    {
+      return *m_setLayout;
+    }
+    auto descriptorSet() const -> VkDescriptorSet
+    {
+      return m_descriptorSet;
+    }
+    auto bufferSlots() const -> const SlotAllocator&
+    {
+      return m_bufferSlots;
+    }
+    auto imageSlots() const -> const SlotAllocator&
+    {
+      return m_imageSlots;
+    }
+
+  private:
+    Device& m_device;
+    std::unique_ptr<DescriptorSetLayout> m_setLayout;
+    std::unique_ptr<DescriptorPool> m_pool;
+    VkDescriptorSet m_descriptorSet{};
+
+    SlotAllocator m_bufferSlots;
+    SlotAllocator m_imageSlots;
+  };
+
+  // writes many sets at once, e.g. materials at load: the queued sets are allocated together and written with a
+  // single vkUpdateDescriptorSets. a layout with templateThreshold or more sets in the batch, each writing every
+  // binding once, goes through its update template instead. the infos are copied, they don't need to outlive it
+  //   DescriptorBatch batch{device};
+  //   batch.add(layout, &set).addBuffer(0, bufferInfo).addImage(1, imageInfo);
+  //   batch.flush(allocator);
+  class DescriptorBatch
+  {
+  public:
+    class Set;
+
+    static constexpr uint32_t templateThreshold{8};
+
+    DescriptorBatch(Device& device, bool useTemplates = true);
+
+    DescriptorBatch(DescriptorBatch const&) = delete;
+    DescriptorBatch& operator=(DescriptorBatch const&) = delete;
+
+    // *descriptorSet is set by flush()
+    auto add(DescriptorSetLayout& descriptorSetLayout, VkDescriptorSet* descriptorSet) -> Set;
+
+    void flush(DescriptorPool& descriptorPool);
+    void flush(DescriptorAllocator& descriptorAllocator);
+
+    auto size() const -> size_t
+    {
+      return m_sets.size();
+    }
+    // of the last flush
+    auto templatedSets() const -> uint32_t
+    {
+      return m_templatedSets;
+    }
+
+  private:
+    struct PendingSet
+    {
+      DescriptorSetLayout* layout;
+      VkDescriptorSet* result;
+    };
+
+    struct PendingWrite
+    {
+      uint32_t set; // into m_sets
+      uint32_t binding;
+      uint32_t arrayElement;
+      DescriptorInfo info;
+      bool image;
+    };
+
+    void write(std::span<const VkDescriptorSet> descriptorSets);
+    // the set's info per binding in binding order, when its writes cover each binding once
+    bool templateData(uint32_t set, std::span<const PendingWrite> writes, std::vector<DescriptorInfo>* data) const;
+
+    Device& m_device;
+    bool m_useTemplates;
+
+    std::vector<PendingSet> m_sets{};
+    std::vector<PendingWrite> m_writes{};
+    uint32_t m_templatedSets{};
+  };
+
+  class DescriptorBatch::Set
+  {
+  public:
+    Set(DescriptorBatch& batch, uint32_t index) :
+        m_batch{batch},
+        m_index{index}
+    {
+    }
+
+    Set& addBuffer(uint32_t binding, const VkDescriptorBufferInfo& bufferInfo, uint32_t arrayElement = 0);
+    Set& addImage(uint32_t binding, const VkDescriptorImageInfo& imageInfo, uint32_t arrayElement = 0);
+
+  private:
+    DescriptorBatch& m_batch;
+    uint32_t m_index;
   };
 
   class DescriptorWriter
   {
   public:
     DescriptorWriter(DescriptorSetLayout& descriptorSetLayout, DescriptorPool& descriptorPool);
+    DescriptorWriter(DescriptorSetLayout& descriptorSetLayout, DescriptorAllocator& descriptorAllocator);
 
     // TODO: writeImages() and writeBuffers() (rename those below to that too)
     DescriptorWriter& addBuffer(uint32_t binding, VkDescriptorBufferInfo* bufferInfo);
     DescriptorWriter& addImage(uint32_t binding, VkDescriptorImageInfo* imageInfo);
+    // a single element of an array binding
+    DescriptorWriter& addBuffer(uint32_t binding, uint32_t arrayElement, VkDescriptorBufferInfo* bufferInfo);
+    DescriptorWriter& addImage(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo* imageInfo);
     // TODO: DescriptorWriter& writeTexelBufferView();
 
     void allocAndUpdate(VkDescriptorSet* descriptorSet);
@@ -121,7 +414,8 @@ namespace vke
     void add(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo* pImageInfo, VkDescriptorBufferInfo* pBufferInfo, VkBufferView* pTexelBufferView);
 
     DescriptorSetLayout& m_descriptorSetLayout;
-    DescriptorPool& m_descriptorPool;
+    DescriptorPool* m_descriptorPool{};           // allocAndUpdate() takes the set from one of them
+    DescriptorAllocator* m_descriptorAllocator{};
     std::vector<VkWriteDescriptorSet> m_writes;
   };
 } // namespace vke
@@ -6,6 +6,16 @@
 
 namespace vke
 {
+  class PipelineCache;
+
+  // VK_KHR_descriptor_update_template's entry points, all null when the device doesn't have it
+  struct DescriptorUpdateTemplateFunctions
+  {
+    PFN_vkCreateDescriptorUpdateTemplateKHR create{};
+    PFN_vkDestroyDescriptorUpdateTemplateKHR destroy{};
+    PFN_vkUpdateDescriptorSetWithTemplateKHR update{};
+  };
+
   class PhysicalDeviceInfo
   {
   public:
@@ -14,8 +24,13 @@ namespace vke
     std::vector<VkExtensionProperties> availableExtensions;
     VkPhysicalDeviceMemoryProperties memoryProperties;
     VkPhysicalDeviceProperties deviceProperties;
+    VkPhysicalDeviceFeatures features;
+    VkPhysicalDeviceDescriptorIndexingFeatures descriptorIndexing{}; // all false without VK_EXT_descriptor_indexing
+    VkPhysicalDeviceDescriptorIndexingProperties descriptorIndexingProperties{}; // its update after bind limits, 0 without it
     std::vector<VkFormatProperties> formatProperties;
 
+    bool hasExtension(const char* name) const;
+
     PhysicalDeviceInfo& operator=(PhysicalDeviceInfo&&) = default;
     // PhysicalDeviceInfo& operator=(PhysicalDeviceInfo& device) = delete;
   };
@@ -139,6 +154,7 @@ namespace vke
     void choosePhysicalDevice();
     void createLogicalDevice();
     void createCommandPools();
+    void createPipelineCache();
 
     bool checkValidationLayersSupport();
     bool checkDeviceExtensionsSupport();
@@ -158,6 +174,11 @@ namespace vke
     auto queues() const -> const Queues& { return m_queues; }
     auto commandPools() const -> const CommmandPools& { return m_commandPools; };
     auto assetsPath() const -> const std::filesystem::path { return m_rootPath; };
+    auto enabledFeatures() const -> const VkPhysicalDeviceFeatures& { return m_enabledFeatures; }
+    // update after bind, partially bound runtime arrays of storage buffers and sampled images, see BindlessTable
+    bool bindlessSupported() const { return m_bindlessSupported; }
+    auto descriptorUpdateTemplates() const -> const DescriptorUpdateTemplateFunctions& { return m_descriptorUpdateTemplates; }
+    auto pipelineCache() const -> VkPipelineCache;
 
     operator VkDevice() { return m_device; }
 
@@ -170,11 +191,19 @@ namespace vke
     PhysicalDeviceInfo m_physicalDeviceInfo;
     VkPhysicalDevice m_physicalDevice{VK_NULL_HANDLE};
     CommmandPools m_commandPools;
+    VkPhysicalDeviceFeatures m_enabledFeatures{};
+    VkPhysicalDeviceDescriptorIndexingFeatures m_enabledDescriptorIndexing{};
+    bool m_bindlessSupported{};
+    DescriptorUpdateTemplateFunctions m_descriptorUpdateTemplates{};
+    bool m_hasPhysicalDeviceProperties2{}; // the instance extension, to query the descriptor indexing features and limits
+    std::unique_ptr<PipelineCache> m_pipelineCache;
 
     bool enableValidationLayers{true};
     std::filesystem::path m_rootPath;
 
     static constexpr std::array m_deviceExtensions{VK_KHR_SWAPCHAIN_EXTENSION_NAME};
+    static constexpr const char* m_updateTemplateExtension{VK_KHR_DESCRIPTOR_UPDATE_TEMPLATE_EXTENSION_NAME}; // optional
+    static constexpr std::array m_bindlessExtensions{VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME, VK_KHR_MAINTENANCE_3_EXTENSION_NAME}; // optional
     static constexpr std::array m_validationLayers{"VK_LAYER_KHRONOS_validation"};
   };
 }
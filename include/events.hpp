@@ -28,10 +28,10 @@ namespace vke::event
   struct InvalidPipeline : RenderEvent
   {
     InvalidPipeline() = default;
-    InvalidPipeline(VkRenderPass renderPass, VkExtent2D extent);
+    InvalidPipeline(VkRenderPass renderPass, VkRenderPass depthRenderPass);
 
     VkRenderPass renderPass;
-    VkExtent2D extent;
+    VkRenderPass depthRenderPass; // see Swapchain::depthRenderPass
 
     static constexpr Event::TypeID ID{Event::invalidPipeline};
   };
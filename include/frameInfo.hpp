@@ -2,8 +2,10 @@
 
 #include "camera.hpp"
 #include "core.hpp"
+#include "descriptor.hpp"
 #include "eventListeners.hpp"
 #include "ecs.hpp"
+#include "gpuProfiler.hpp"
 
 namespace vke
 {
@@ -14,10 +16,15 @@ namespace vke
     uint32_t frameIndex{};
     TimeStep timeStep{};
     VkCommandBuffer commandBuffer{};
+    VkExtent2D extent{}; // of the frame being recorded
     Camera& camera;
     Coordinator& ecs;
+    GpuProfiler& gpuProfiler;
+    DescriptorAllocator& descriptors; // the frame's, for sets it alone uses, see Renderer::frameDescriptors
     VkDescriptorSet globalDescriptorSet{};
+    VkDescriptorSet lightDescriptorSet{}; // the frame's LightClusters, set 1
 
     std::span<EntityID> entities{}; // TODO: find a way to pass entities to render systems according to the requested 'renderSystem entity signature'.
+    std::span<EntityID> lights{};   // with a cmp::PointLight
   };
 } // namespace vke
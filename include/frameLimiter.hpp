@@ -0,0 +1,34 @@
+#pragma once
+
+#include "core.hpp"
+
+namespace vke
+{
+  // paces the main loop to a target frame rate. the os sleep overshoots by up to a scheduler tick, so it
+  // only sleeps until a margin before the deadline and spins the rest. the margin follows the overshoot
+  // actually seen: it grows right away and shrinks slowly.
+  // deadlines advance by whole frame times, a late frame doesn't make the next ones shorter unless it's
+  // more than a frame behind, then the schedule restarts from now
+  class FrameLimiter
+  {
+  public:
+    using Clock = std::chrono::steady_clock;
+
+    static constexpr Clock::duration minSpinMargin{std::chrono::microseconds{100}};
+    static constexpr Clock::duration maxSpinMargin{std::chrono::milliseconds{4}};
+
+    explicit FrameLimiter(double targetFps = 0.0);
+
+    void setTarget(double fps); // 0: uncapped
+    auto target() const -> double { return m_targetFps; }
+
+    // blocks until the next deadline, returns right away when uncapped
+    void wait();
+
+  private:
+    double m_targetFps{};
+    Clock::duration m_frameTime{};
+    Clock::time_point m_deadline{};
+    Clock::duration m_spinMargin{std::chrono::milliseconds{1}};
+  };
+} // namespace vke
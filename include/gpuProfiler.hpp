@@ -0,0 +1,114 @@
+#pragma once
+
+#include "core.hpp"
+#include "device.hpp"
+
+namespace vke
+{
+  // GPU timings per pass/system with timestamp queries.
+  // there is a query pool per frame in flight; a frame's pool is read back (without waiting) the next time
+  // the same frame index starts, after its fence was waited, so the results are maxFramesInFlight frames old.
+  // pipeline statistics are gathered too when the device supports them (not for nested scopes).
+  class GpuProfiler
+  {
+  public:
+    static constexpr uint32_t maxScopes{32};
+    static constexpr uint32_t historySize{64}; // frames in the rolling average
+
+    enum Statistic
+    {
+      inputVertices,
+      inputPrimitives,
+      vertexInvocations,
+      clippingPrimitives,
+      fragmentInvocations,
+      statisticCount,
+    };
+
+    struct Timing
+    {
+      const char* name{};
+      double averageMs{};
+      double lastMs{};
+      std::array<uint64_t, statisticCount> statistics{}; // last frame, zero without pipeline statistics support
+    };
+
+    // RAII helper for the systems
+    class Scope
+    {
+    public:
+      Scope(GpuProfiler& profiler, VkCommandBuffer commandBuffer, const char* name, bool withStatistics = true) :
+        m_profiler{profiler},
+        m_commandBuffer{commandBuffer},
+        m_index{profiler.beginScope(commandBuffer, name, withStatistics)} {}
+
+      ~Scope() { m_profiler.endScope(m_commandBuffer, m_index); }
+
+      Scope(const Scope&) = delete;
+      Scope& operator=(const Scope&) = delete;
+
+    private:
+      GpuProfiler& m_profiler;
+      VkCommandBuffer m_commandBuffer;
+      uint32_t m_index;
+    };
+
+    GpuProfiler(Device& device, uint32_t framesInFlight);
+    ~GpuProfiler();
+
+    // reads back the frame's previous results and resets its pools, call outside of a render pass
+    void beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex);
+
+    // names must outlive the profiler (literals). returns maxScopes when the scope isn't recorded
+    auto beginScope(VkCommandBuffer commandBuffer, const char* name, bool withStatistics = true) -> uint32_t;
+    void endScope(VkCommandBuffer commandBuffer, uint32_t scope);
+
+    auto timings() const -> std::span<const Timing> { return m_timings; }
+    void report(std::ostream& out) const;
+
+    bool isEnabled() const { return m_enabled; }
+    bool hasStatistics() const { return m_statisticsPools.size(); }
+
+    GpuProfiler(const GpuProfiler&) = delete;
+    GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+  private:
+    struct ScopeRecord
+    {
+      const char* name;
+      bool hasStatistics;
+    };
+
+    struct FrameQueries
+    {
+      std::vector<ScopeRecord> scopes;
+    };
+
+    struct History
+    {
+      std::array<double, historySize> samples{};
+      uint32_t count{};
+      uint32_t next{};
+    };
+
+    void collect(uint32_t frameIndex);
+    void record(const char* name, double ms, const uint64_t* statistics);
+
+  private:
+    Device& m_device;
+
+    bool m_enabled{};
+    double m_timestampPeriod{}; // ns per tick
+    uint64_t m_timestampMask{};
+
+    std::vector<VkQueryPool> m_timestampPools;
+    std::vector<VkQueryPool> m_statisticsPools; // empty without pipelineStatisticsQuery
+    std::vector<FrameQueries> m_frames;
+
+    uint32_t m_frameIndex{};
+    bool m_statisticsActive{};
+
+    std::vector<Timing> m_timings;
+    std::vector<History> m_history; // parallel to m_timings
+  };
+} // namespace vke
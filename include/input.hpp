@@ -24,11 +24,15 @@ namespace vke
       int lookRight{GLFW_KEY_RIGHT};
       int lookUp{GLFW_KEY_UP};
       int lookDown{GLFW_KEY_DOWN};
+
+      int cyclePresentMode{GLFW_KEY_P};
     };
 
   public:
     KeyboardInput(Coordinator& coord, Window& window);
     void moveInPlaneXZ(TimeStep ts, EntityID cameraEntity);
+    // once per key press, not while it's held
+    bool presentModeCycled();
 
     //TODO:
     //void moveFlying(TimeStep ts, EntityID cameraEntity);
@@ -40,5 +44,6 @@ namespace vke
     float m_moveSpeed{1.25f};
     float m_lookSpeed{1.000f};
     std::pair<double, double> lastCursorPos{};
+    bool m_presentModeKeyDown{};
   };
 }; // namespace vke
@@ -0,0 +1,96 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "components.hpp"
+#include "core.hpp"
+#include "descriptor.hpp"
+#include "device.hpp"
+#include "frameInfo.hpp"
+
+namespace vke
+{
+  // clustered forward lighting. the view frustum is cut into a grid of froxels, gridX by gridY screen tiles
+  // and gridZ slices growing exponentially with the depth, and every point light is binned on the cpu into
+  // the froxels its sphere touches. the fragment shader finds its froxel and only loops over those lights.
+  //
+  // per frame in flight, host visible and rewritten every frame (set 1 of the scene's shaders, a set from the
+  // frame's descriptors):
+  //   binding 0: the lights
+  //   binding 1: the grid, then the froxels' ranges into binding 2
+  //   binding 2: the light indices
+  class LightClusters
+  {
+  public:
+    static constexpr uint32_t gridX{16};
+    static constexpr uint32_t gridY{9};
+    static constexpr uint32_t gridZ{24};
+    static constexpr uint32_t clusterCount{gridX * gridY * gridZ};
+    static constexpr uint32_t initialLights{256}; // the buffers grow when a frame needs more
+    static constexpr uint32_t initialIndices{16 * 1024};
+
+    // std430 layouts, mirrored in shader.frag
+    struct Light
+    {
+      glm::vec4 position; // world space, w is the radius
+      glm::vec4 color;    // w is the intensity
+    };
+
+    struct Cluster
+    {
+      uint32_t offset; // into the light indices
+      uint32_t count;
+    };
+
+    struct Grid
+    {
+      glm::uvec4 size;    // gridX, gridY, gridZ, light count
+      glm::vec4 slicing;  // the slice of a view depth is log(z) * x + y, z and w are the extent
+    };
+
+    LightClusters(Device& device, DescriptorLayoutCache& layoutCache, uint32_t framesInFlight);
+
+    // the frame's cmp::PointLight entities (FrameInfo::lights), binned from its camera. call before recording,
+    // the frame's fence must have been waited on. returns the frame's set 1 (FrameInfo::lightDescriptorSet)
+    auto update(const FrameInfo& info) -> VkDescriptorSet;
+
+    auto descriptorSetLayout() const -> VkDescriptorSetLayout { return m_setLayout; }
+
+    // the binning alone. near and far are the perspective projection's, view space looks down +z.
+    // conservative: a froxel lists every light whose sphere reaches into it, and a few more near the edges
+    static void assign(
+      std::span<const Light> lights,
+      const glm::mat4& view,
+      const glm::mat4& projection,
+      float near,
+      float far,
+      std::vector<Cluster>* clusters,
+      std::vector<uint32_t>* indices);
+
+    // the froxel a view space position falls in, what the fragment shader computes from gl_FragCoord
+    static auto clusterIndex(const glm::vec3& viewPosition, const glm::mat4& projection, float near, float far) -> uint32_t;
+
+    LightClusters(const LightClusters&) = delete;
+    LightClusters& operator=(const LightClusters&) = delete;
+
+  private:
+    struct Frame
+    {
+      std::unique_ptr<Buffer> lights;
+      std::unique_ptr<Buffer> clusters;
+      std::unique_ptr<Buffer> indices;
+    };
+
+    void createBuffers(Frame& frame, uint32_t lightCapacity, uint32_t indexCapacity);
+
+  private:
+    Device& m_device;
+
+    DescriptorSetLayout& m_setLayout;
+    std::vector<Frame> m_frames;
+
+    // reused every frame
+    std::vector<Light> m_lights;
+    std::vector<Cluster> m_clusters;
+    std::vector<uint32_t> m_indices;
+  };
+} // namespace vke
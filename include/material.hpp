@@ -0,0 +1,59 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "core.hpp"
+#include "descriptor.hpp"
+#include "device.hpp"
+#include "renderQueue.hpp"
+
+namespace vke
+{
+  // the scene's materials, referenced by entities through cmp::Material. a material is its shading
+  // parameters, a uniform buffer element set 2 of shader.frag points at:
+  //   binding 0: the Parameters
+  // materials are immutable once uploaded, their buffers and sets live as long as the library
+  class MaterialLibrary
+  {
+  public:
+    static constexpr uint32_t maxMaterials{1u << RenderQueue::materialBits}; // the id is part of the sort key
+    static constexpr uint32_t defaultMaterial{0};                            // white, created by the constructor
+
+    // std140, mirrored in shader.frag
+    struct Parameters
+    {
+      glm::vec4 baseColor{1.f, 1.f, 1.f, 1.f}; // multiplies the vertex color
+      float specular{1.f};
+      float shininess{23.f};
+      alignas(8) glm::vec2 padding{};
+    };
+
+    struct Material
+    {
+      std::string name;
+      Parameters parameters;
+      VkDescriptorSet descriptorSet{}; // set by upload()
+    };
+
+    MaterialLibrary(Device& device, DescriptorLayoutCache& layoutCache, DescriptorAllocator& descriptors);
+
+    auto create(std::string name, const Parameters& parameters) -> uint32_t;
+    // the materials created since the last call get one buffer and their sets, in one batch
+    void upload();
+
+    auto get(uint32_t id) const -> const Material& { return m_materials[id]; }
+    auto size() const -> uint32_t { return static_cast<uint32_t>(m_materials.size()); }
+    auto descriptorSetLayout() const -> VkDescriptorSetLayout { return m_setLayout; }
+
+    MaterialLibrary(const MaterialLibrary&) = delete;
+    MaterialLibrary& operator=(const MaterialLibrary&) = delete;
+
+  private:
+    Device& m_device;
+    DescriptorSetLayout& m_setLayout;
+    DescriptorAllocator& m_descriptors;
+
+    std::vector<Material> m_materials{};
+    std::vector<std::unique_ptr<Buffer>> m_buffers{}; // one per upload()
+    uint32_t m_uploaded{};
+  };
+} // namespace vke
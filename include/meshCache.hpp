@@ -0,0 +1,66 @@
+#pragma once
+
+#include "core.hpp"
+#include "model.hpp"
+
+namespace vke
+{
+  // read only mapping of a whole file, pages come straight from the page cache instead of a copy
+  class MappedFile
+  {
+  public:
+    explicit MappedFile(const std::filesystem::path& path);
+    ~MappedFile();
+
+    auto bytes() const -> std::span<const std::byte> { return {m_data, m_size}; }
+    auto size() const -> size_t { return m_size; }
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+  private:
+    const std::byte* m_data{};
+    size_t m_size{};
+#ifdef _WIN32
+    std::vector<std::byte> m_buffer; // no mmap here, read the whole file instead
+#endif
+  };
+
+  // binary copy of an imported mesh written next to its source (foo.obj -> foo.obj.vkmesh).
+  // the vertex and index streams are stored exactly as they're uploaded (the lods and meshlets are index ranges),
+  // so a cached load is a mmap plus one memcpy into the staging buffer: no parsing, no vertex dedup, no simplification.
+  // the cache is stale as soon as the source's size, write time or content changes.
+  class MeshCache
+  {
+  public:
+    static auto cachePath(const std::filesystem::path& source) -> std::filesystem::path;
+
+    // maps the cache into the builder, false when it's missing, unreadable, stale, damaged or from another version
+    static bool load(const std::filesystem::path& source, Model::Builder* builder);
+    static void store(const std::filesystem::path& source, const Model::Builder& builder);
+
+  private:
+    struct Header
+    {
+      char magic[4]{'V', 'K', 'E', 'M'};
+      uint32_t version{5}; // 2: optimized vertex and index order, 3: lods, 4: meshlets, 5: source hash
+      uint64_t sourceSize{};
+      int64_t sourceTime{};
+      uint64_t sourceHash{}; // of the source file, a rewrite may keep its size and write time
+      uint64_t contentHash{}; // of both streams, identifies the mesh regardless of its path
+      uint32_t vertexSize{sizeof(Model::Vertex)};
+      uint32_t vertexCount{};
+      uint32_t indexCount{};
+      uint32_t lodCount{}; // the Model::Lod table follows the indices
+      glm::vec3 boundsMin{};
+      glm::vec3 boundsMax{};
+      uint32_t meshletCount{}; // the Model::Meshlet table follows the lods
+      uint32_t reserved{};
+    };
+
+    static_assert(sizeof(Header) % alignof(Model::Vertex) == 0, "vertex stream must stay aligned");
+
+    static auto sourceTime(const std::filesystem::path& source) -> int64_t;
+    static auto sourceHash(const std::filesystem::path& source) -> uint64_t;
+  };
+} // namespace vke
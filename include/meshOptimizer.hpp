@@ -0,0 +1,56 @@
+#pragma once
+
+#include "core.hpp"
+#include "model.hpp"
+
+namespace vke
+{
+  struct MeshOptimizerOptions
+  {
+    bool vertexCache{true};
+    bool overdraw{true};
+    float overdrawThreshold{1.05f}; // roughly how much the ACMR may grow for the sake of overdraw
+    bool vertexFetch{true};
+  };
+
+  // import time reordering of indexed triangle lists, cpu only.
+  //
+  // - vertex cache: tipsify (Sander, Nehab, Barczak 2007), triangles are emitted around the vertex that is
+  //   most likely still in a fifo post transform cache of cacheSize entries. linear time.
+  // - overdraw: the tipsify output is cut into clusters (where it had to jump, and again wherever the cache
+  //   hit rate allows it within threshold), which are sorted to draw outward facing ones first.
+  // - vertex fetch: vertices are renumbered in order of first use, unused ones are dropped.
+  //
+  // ACMR is the average cache miss ratio (transformed vertices per triangle, 0.5 at best for big grids),
+  // ATVR the same per vertex (1 at best).
+  class MeshOptimizer
+  {
+  public:
+    using Options = MeshOptimizerOptions;
+
+    static constexpr uint32_t cacheSize{16};
+
+    struct Report
+    {
+      float acmrBefore{};
+      float acmrAfter{};
+      float atvrBefore{};
+      float atvrAfter{};
+    };
+
+    // all enabled stages, before compact() and splitStreams(). non indexed builders are left alone
+    static auto optimize(Model::Builder* builder, const Options& options = {}) -> Report;
+
+    // hardBoundaries gets the first triangle of every tipsify restart, the input of optimizeOverdraw
+    static void optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount, std::vector<uint32_t>* hardBoundaries = nullptr);
+    // without boundaries they are guessed from the cache misses
+    static void optimizeOverdraw(std::span<uint32_t> indices, std::span<const Model::Vertex> vertices, float threshold = 1.05f, std::span<const uint32_t> hardBoundaries = {});
+    static void optimizeVertexFetch(Model::Builder* builder);
+
+    static auto acmr(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t fifoSize = cacheSize) -> float;
+    static auto atvr(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t fifoSize = cacheSize) -> float;
+
+  private:
+    static auto cacheMisses(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t fifoSize) -> uint32_t;
+  };
+} // namespace vke
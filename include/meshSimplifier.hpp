@@ -0,0 +1,36 @@
+#pragma once
+
+#include "core.hpp"
+#include "model.hpp"
+
+namespace vke
+{
+  // quadric error metric simplification (Garland, Heckbert 1997) restricted to half edge collapses: a vertex
+  // is merged into one of its neighbours, so every lod indexes the original vertices and shares their buffer.
+  //
+  // collapses run in passes, cheapest first, at most one per vertex neighbourhood per pass, and are refused
+  // when they'd flip a triangle. vertices on open borders and on attribute seams (several vertices at the
+  // same position) never move, which keeps uv and normal seams intact but also means a fully flat shaded mesh
+  // can't be simplified at all.
+  class MeshSimplifier
+  {
+  public:
+    // the indices of a triangle list with at most targetIndexCount indices, or as close as maxError allows.
+    // error gets the largest distance (object space) between a removed vertex and the surface it merged into
+    static auto simplify(std::span<const uint32_t> indices, std::span<const Model::Vertex> vertices, size_t targetIndexCount, float maxError = std::numeric_limits<float>::max(), float* error = nullptr) -> std::vector<uint32_t>;
+
+  private:
+    // the plane distances squared, area weighted: p^T A p + 2 b.p + c
+    struct Quadric
+    {
+      double a00{}, a01{}, a02{}, a11{}, a12{}, a22{};
+      double b0{}, b1{}, b2{};
+      double c{};
+      double weight{};
+
+      void addPlane(glm::vec3 normal, float distance, float area);
+      auto evaluate(glm::vec3 position) const -> double; // mean squared distance
+      Quadric& operator+=(const Quadric& other);
+    };
+  };
+} // namespace vke
@@ -0,0 +1,25 @@
+#pragma once
+
+#include "core.hpp"
+#include "model.hpp"
+
+namespace vke
+{
+  // partitions a triangle list into meshlets of at most maxVertices vertices and maxTriangles triangles.
+  // greedy: a meshlet grows by the adjacent triangle adding the fewest new vertices, and starts over from
+  // the next triangle in the input order once it's full or runs out of neighbours, so feed it a cache
+  // optimized order. the indices are rewritten so every meshlet is a contiguous range.
+  class MeshletBuilder
+  {
+  public:
+    static constexpr uint32_t maxVertices{64};
+    static constexpr uint32_t maxTriangles{124};
+    // below that a mesh is drawn whole, culling can't save more than the extra draws cost
+    static constexpr uint32_t minTriangles{4096};
+
+    static auto build(std::span<uint32_t> indices, std::span<const Model::Vertex> vertices) -> std::vector<Model::Meshlet>;
+
+  private:
+    static void computeBounds(std::span<const uint32_t> indices, std::span<const Model::Vertex> vertices, Model::Meshlet* meshlet);
+  };
+} // namespace vke
@@ -5,30 +5,112 @@
 #include "device.hpp"
 #include "utils.hpp"
 #include "buffer.hpp"
+#include "threadPool.hpp"
 
 namespace vke
 {
+  class MappedFile;
+  class UploadBatch;
+
   class Model
   {
   public:
     struct Vertex;
+    struct CompactVertex;
     struct UniformBufferObject;
     struct Builder;
 
+    // a draw range addressing at most 65536 vertices from vertexOffset on, for 16 bit index buffers
+    struct Submesh
+    {
+      uint32_t firstIndex{};
+      uint32_t indexCount{};
+      int32_t vertexOffset{};
+    };
+
+    static constexpr size_t maxShortIndexVertices{1 << 16};
+
+    // a level of detail, an index range of the shared index buffer over the same vertices.
+    // error is how far (object space) its surface strays from lod 0
+    struct Lod
+    {
+      uint32_t firstIndex{};
+      uint32_t indexCount{};
+      float error{};
+    };
+
+    // a cluster of lod 0, at most 64 vertices and 124 triangles in a contiguous index range. the cone holds
+    // every triangle normal: from a point p the whole meshlet faces away when
+    // dot(normalize(coneApex - p), coneAxis) >= coneCutoff
+    struct Meshlet
+    {
+      glm::vec3 center{};
+      float radius{};
+      glm::vec3 coneApex{};
+      float coneCutoff{1.f}; // 1: never back facing
+      glm::vec3 coneAxis{};
+      uint32_t firstIndex{};
+      uint32_t triangleCount{};
+      uint32_t vertexCount{};
+      int32_t vertexOffset{}; // of the submesh holding it
+    };
+
+    enum class VertexFormat : uint8_t
+    {
+      standard, // Vertex, 44 bytes
+      compact,  // CompactVertex, 20 bytes, needs the compact shader variant
+    };
+
+    enum class VertexLayout : uint8_t
+    {
+      interleaved, // one stream, binding 0
+      split,       // positions in binding 0, everything else in binding 1 (same buffer, after the positions)
+    };
+
     Model(Device& device, Builder& builder);
+    // only creates the buffers, the copies are recorded into the batch
+    Model(Device& device, const Builder& builder, UploadBatch* upload);
     ~Model();
 
     // << // void updateUniformBuffers(uint32_t currentImage, VkExtent2D swapChainExtent);
     // << // void recreateUniformBuffers(uint32_t swapChainImageCount);
 
-    void createVertexBuffer(std::span<Model::Vertex> vertices);
-    void createIndexBuffer(std::span<uint32_t> indices);
+    void createVertexBuffer(std::span<const Model::Vertex> vertices);
+    void createIndexBuffer(std::span<const uint32_t> indices);
 
     void bindBuffers(VkCommandBuffer commandBuffer);
+    // binding 0 only, for pipelines made with positionsOnly. a split model then fetches nothing but positions
+    void bindPositions(VkCommandBuffer commandBuffer);
     //  void bindVertexBuffer(VkCommandBuffer commandBuffer);
     //  void bindIndexBuffer(VkCommandBuffer commandBuffer);
 
-    void draw(VkCommandBuffer commandBuffer);
+    void draw(VkCommandBuffer commandBuffer, uint32_t lod = 0);
+
+    auto vertexCount() const -> uint32_t { return m_vertexBuffer->elementCount(); }
+    auto indexCount() const -> uint32_t { return m_hasIndexBuffer ? m_indexBuffer->elementCount() : 0; }
+    auto indexType() const -> VkIndexType { return m_indexType; }
+    auto submeshes() const -> std::span<const Submesh> { return m_submeshes; }
+    auto lodCount() const -> uint32_t { return std::max(static_cast<uint32_t>(m_lods.size()), 1u); }
+    auto boundingSphere() const -> const glm::vec4& { return m_boundingSphere; } // center, radius
+    auto meshlets() const -> std::span<const Meshlet> { return m_meshlets; }
+
+    // the coarsest lod whose error, at pixelsPerUnit, stays under maxPixelError. lods coarser than current
+    // have to stay under (1 - hysteresis) times that, so a model sitting on a threshold doesn't flicker
+    auto selectLod(float pixelsPerUnit, uint32_t current, float maxPixelError = 1.f, float hysteresis = 0.25f) const -> uint32_t;
+    auto memorySize() const -> VkDeviceSize;
+
+    auto vertexFormat() const -> VertexFormat { return m_vertexFormat; }
+    auto vertexLayout() const -> VertexLayout { return m_vertexLayout; }
+    // maps the compact [0, 1] positions back into the mesh bounds, goes in front of the model matrix
+    auto dequantization() const -> const glm::mat4& { return m_dequantization; }
+
+    static auto vertexSize(VertexFormat format) -> uint32_t;
+    static auto positionSize(VertexFormat format) -> uint32_t; // the position always leads the vertex
+
+    // what a pipeline drawing this kind of model needs. depth, shadow and culling passes only read
+    // positions, which works with either layout but is only cheaper with the split one
+    static auto vertexBindings(VertexFormat format, VertexLayout layout, bool positionsOnly = false) -> std::vector<VkVertexInputBindingDescription>;
+    static auto vertexAttributes(VertexFormat format, VertexLayout layout, bool positionsOnly = false) -> std::vector<VkVertexInputAttributeDescription>;
 
     // std::span<Buffer> uniformBuffers() { return m_uniformBuffers; }
 
@@ -50,6 +132,16 @@ namespace vke
 
     // TODO: optimize
     bool m_hasIndexBuffer{};
+    VkIndexType m_indexType{VK_INDEX_TYPE_UINT32};
+    std::vector<Submesh> m_submeshes{}; // empty: a single draw of everything
+    std::vector<Lod> m_lods{};           // empty: lod 0 is everything
+    std::vector<Meshlet> m_meshlets{};   // empty: lod 0 can't be culled per cluster
+    glm::vec4 m_boundingSphere{};
+
+    VertexFormat m_vertexFormat{VertexFormat::standard};
+    VertexLayout m_vertexLayout{VertexLayout::interleaved};
+    VkDeviceSize m_attributeOffset{}; // where the split attribute stream starts
+    glm::mat4 m_dequantization{1.f};
 
     // std::vector<Buffer> m_uniformBuffers;
     // Memory m_uniformBuffersMemory;
@@ -82,6 +174,20 @@ namespace vke
     }
   };
 
+  // positions are unorm16 inside the mesh bounds, normals octahedral snorm16, uvs half floats and the color rgba8
+  struct Model::CompactVertex
+  {
+    uint16_t position[4]{}; // w is padding, three component 16 bit formats are rarely supported
+    int16_t normal[2]{};
+    uint32_t uv{};
+    uint32_t color{};
+
+    static std::vector<VkVertexInputAttributeDescription> getVertexInputAttributeDescription();
+    static std::vector<VkVertexInputBindingDescription> getVertexInputBindingDescription();
+  };
+
+  static_assert(sizeof(Model::CompactVertex) == 20);
+
   struct alignas(16) Model::UniformBufferObject
   {
     glm::mat4 model;
@@ -96,14 +202,86 @@ namespace vke
   struct Model::Builder
   {
     Builder() = default;
-    Builder(std::filesystem::path path)
+    Builder(std::filesystem::path path, ThreadPool* threadPool = nullptr)
     {
-      loadModel(path);
+      loadModel(path, threadPool);
     }
 
     std::vector<Vertex> vertices{};
     std::vector<uint32_t> indices{};
 
-    void loadModel(std::filesystem::path path);
+    glm::vec3 boundsMin{};
+    glm::vec3 boundsMax{};
+    uint64_t contentHash{};
+
+    // imports through the mesh cache, the obj is only parsed when there's no valid .vkmesh for it.
+    // the parse is spread over the pool when one is given
+    void loadModel(std::filesystem::path path, ThreadPool* threadPool = nullptr);
+
+    // what gets uploaded: the vectors, or the cache file's mapping when it was loaded from one
+    auto vertexData() const -> std::span<const Vertex>;
+    auto indexData() const -> std::span<const uint32_t>;
+
+    void computeBounds();
+    void computeContentHash();
+
+    // appends up to count - 1 simplified index ranges, each aiming for ratio times the triangles of the one
+    // before. run it after MeshOptimizer::optimize() and before shortenIndices()
+    void generateLods(uint32_t count = 4, float ratio = 0.5f);
+
+    std::vector<Lod> lods{}; // empty: only lod 0, all the indices
+
+    // splits lod 0 into meshlets, reordering its triangles so each one is a contiguous range. does nothing
+    // below MeshletBuilder::minTriangles. run it after MeshOptimizer::optimize() and before generateLods()
+    void buildMeshlets();
+
+    std::vector<Meshlet> meshlets{};
+
+    // switches to the compact format when it loses nothing visible: colors in [0, 1] and uvs in [-1, 1],
+    // where half floats still resolve a texel of a 1k texture. returns whether it did
+    bool compact();
+
+    VertexFormat format{VertexFormat::standard};
+    std::vector<CompactVertex> compactVertices{};
+
+    // 16 bit indices when the mesh has at most 65536 vertices. bigger ones are cut into submeshes that each
+    // address 65536 (the vertices on the cuts are duplicated) when allowed, otherwise they keep 32 bit
+    // indices. call it before compact(), returns whether the indices are 16 bit
+    bool shortenIndices(bool allowSubmeshes = true);
+
+    VkIndexType indexType{VK_INDEX_TYPE_UINT32};
+    std::vector<uint16_t> shortIndices{};
+    std::vector<Submesh> submeshes{};
+
+    // rewrites the vertices of the current format as two streams, call it after compact()
+    void splitStreams();
+
+    VertexLayout layout{VertexLayout::interleaved};
+    std::vector<std::byte> splitVertices{}; // all positions, then all the other attributes
+
+  private:
+    void importObj(const std::filesystem::path& path, ThreadPool* threadPool);
+    void ownData(); // copies a mapped cache file into the vectors, before editing them
+
+    friend class MeshCache;
+    friend class MeshOptimizer;
+
+    std::shared_ptr<const MappedFile> m_mapping{};
+    std::span<const Vertex> m_mappedVertices{};
+    std::span<const uint32_t> m_mappedIndices{};
   };
 } // namespace vke
+
+namespace std
+{
+  template<>
+  struct hash<vke::Model::Vertex>
+  {
+    std::size_t operator()(vke::Model::Vertex const& vertex) const
+    {
+      std::size_t seed{};
+      vke::hash_combine(&seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
+      return seed;
+    }
+  };
+} // namespace std
@@ -5,43 +5,139 @@
 #include "allocator.hpp"
 #include "ecs.hpp"
 #include "model.hpp"
+#include "threadPool.hpp"
+#include "uploadBatch.hpp"
 
 namespace vke
 {
-  // TODO: make this a system in the ecs, and add a component with a shared model managed be this system. futurely, this could become some sort of asset manager (for textures, models, etc, that are shared between entities)
+  struct ModelHandle
+  {
+    static constexpr uint32_t invalidIndex{~0u};
+
+    uint32_t index{invalidIndex};
+
+    bool isValid() const { return index != invalidIndex; }
+  };
+
+  // the asset manager for meshes, shared between entities.
+  //
+  // models are loaded in the background: load() returns at once and gives the entities a placeholder cube,
+  // a pool task reads and decodes the file, and update() (once per frame, main thread) uploads whatever
+  // finished in a single UploadBatch. once that batch's fence signals, the entities get their real model.
+  //
+  // a path always maps to the same handle, and builders with the same content (hash of the vertex and index
+  // data) share one gpu model. every entity using a handle is a reference. models nobody references stay
+  // resident until the gpu memory budget is exceeded, then the least recently used ones are evicted
+  // (and reloaded, through the mesh cache, if somebody asks for them again).
   class ModelManager
   {
-    struct Builder : public Model::Builder
+  public:
+    using Handle = ModelHandle;
+
+    static constexpr VkDeviceSize defaultMemoryBudget{256ull << 20};
+
+    ModelManager(Device& device, Coordinator& ecs, ThreadPool& threadPool);
+    ~ModelManager();
+
+    auto load(std::filesystem::path path, std::vector<EntityID> entities = {}) -> Handle;
+    // already built on the caller's side, only the upload is deferred. never evicted, it can't be reloaded
+    auto give(Model::Builder builder, std::vector<EntityID> entities = {}) -> Handle;
+
+    // the entity references the handle's model (and drops whatever it referenced before)
+    void acquire(Handle handle, EntityID entity);
+    // the entity's model pointer is cleared, the systems skip it
+    void release(EntityID entity);
+
+    void update();
+    void waitIdle(); // until everything requested so far is on the gpu
+
+    bool isReady(Handle handle) const;
+    // the placeholder while loading (or when loading failed), and for released entities
+    auto get(Handle handle) -> Model&;
+    auto get(EntityID entity) -> Model&;
+
+    auto placeholder() -> Model& { return *m_placeholder; }
+
+    void setMemoryBudget(VkDeviceSize bytes) { m_memoryBudget = bytes; }
+    // meshes whose attributes fit are uploaded as Model::CompactVertex, for loads started afterwards
+    void setCompactVertices(bool enabled) { m_compactVertices = enabled; }
+    // 16 bit indices, big meshes are cut into submeshes for them
+    void setShortIndices(bool enabled) { m_shortIndices = enabled; }
+    // split keeps the positions in their own stream, for the passes that read nothing else
+    void setVertexLayout(Model::VertexLayout layout) { m_vertexLayout = layout; }
+    // evicted models are destroyed this many update()s later, once no frame can still draw them
+    void setFramesInFlight(uint32_t frames) { m_framesInFlight = frames; }
+
+    auto residentMemory() const -> VkDeviceSize { return m_residentMemory; }
+    auto modelCount() const -> size_t { return m_contents.size(); }
+
+    ModelManager(const ModelManager&) = delete;
+    ModelManager& operator=(const ModelManager&) = delete;
+
+  private:
+    struct Slot
     {
+      std::filesystem::path path; // empty for given builders
       std::vector<EntityID> entities;
+      std::shared_ptr<Model> model{}; // null while loading or evicted
+      uint64_t contentKey{};
+      uint64_t lastUsed{}; // frame its last reference was dropped
+      bool loading{};
     };
 
-  public:
-    ModelManager(Device& device, Coordinator& ecs);
-    ~ModelManager();
+    struct Loaded
+    {
+      uint32_t slot;
+      std::optional<Model::Builder> builder; // empty when loading failed
+    };
+
+    // what a batch in flight is uploading, builders stay alive until its fence
+    struct Upload
+    {
+      std::unique_ptr<UploadBatch> batch;
+      std::vector<std::pair<uint32_t, std::shared_ptr<Model>>> models;
+    };
+
+    struct Retired
+    {
+      std::shared_ptr<Model> model;
+      uint64_t frame;
+    };
 
-    void give(Model::Builder builder, std::vector<EntityID> entities);
-    Model& get(EntityID entity);
+    auto createSlot(std::filesystem::path path) -> Handle;
+    void startLoad(uint32_t slot);
+    void finishUpload();
+    void startUpload();
+    void evict();
 
-    void createModels();
-    void loadModel(std::filesystem::path path);
+    static auto contentKey(const Model::Builder& builder) -> uint64_t;
+    static auto placeholderBuilder() -> Model::Builder;
 
   private:
     Device& m_device;
-
-    std::unordered_map<EntityID, size_t> m_modelIndexes;
-    std::unordered_map<EntityID, size_t> m_modelCount;
-    std::list<Model> m_models;
     Coordinator& m_ecs;
+    ThreadPool& m_threadPool;
+
+    std::unique_ptr<Model> m_placeholder;
+
+    // main thread only
+    std::deque<Slot> m_slots;
+    std::unordered_map<std::string, uint32_t> m_pathSlots;
+    std::unordered_map<EntityID, uint32_t> m_entitySlots;
+    std::unordered_map<uint64_t, std::weak_ptr<Model>> m_contents; // content key -> resident model
+    std::vector<std::future<void>> m_tasks;
+    std::optional<Upload> m_upload;
+    std::deque<Retired> m_retired;
 
-//  Buffer  m_vertexBuffer{};
-//  Memory  m_vertexMemory{};
-//
-//  Buffer  m_indexBuffer{};
-//  Memory  m_indexMemory{};
+    VkDeviceSize m_memoryBudget{defaultMemoryBudget};
+    VkDeviceSize m_residentMemory{};
+    uint32_t m_framesInFlight{3};
+    bool m_compactVertices{true};
+    bool m_shortIndices{true};
+    Model::VertexLayout m_vertexLayout{Model::VertexLayout::split};
+    uint64_t m_frame{};
 
-//    std::vector<Model2DCreateInfo> m_model2DCreateInfo;
-//    std::vector<Model3DCreateInfo> m_model3DCreateInfo;
-    std::vector<Builder> m_modelBuilders{};
+    std::mutex m_mutex;
+    std::vector<Loaded> m_loaded; // filled by the workers
   };
 } // namespace vke
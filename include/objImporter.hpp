@@ -0,0 +1,65 @@
+#pragma once
+
+#include "core.hpp"
+#include "model.hpp"
+#include "threadPool.hpp"
+
+namespace vke
+{
+  // parallel obj reader, fills Model::Builder with the same vertices and indices as the tinyobjloader path.
+  // the file is mapped and split into line aligned chunks parsed on the pool with std::from_chars, a prefix
+  // sum over the per chunk counts resolves the (relative) indices, then identical corners are welded through
+  // a lock free open addressing table. welding keeps first occurrence order, so the result never depends on
+  // scheduling.
+  // reads v (plus the rgb extension), vt, vn and f, everything else is skipped. quads are split along their
+  // shorter diagonal like tinyobjloader does, larger polygons are fan triangulated.
+  class ObjImporter
+  {
+  public:
+    explicit ObjImporter(ThreadPool* threadPool = nullptr); // single threaded without a pool
+
+    void import(const std::filesystem::path& path, Model::Builder* builder);
+
+    // tinyobjloader + hash map dedup, what the importer is checked and benchmarked against
+    static void importReference(const std::filesystem::path& path, Model::Builder* builder);
+
+    static constexpr size_t minChunkSize{1 << 20};
+    static constexpr uint32_t weldBlockSize{1 << 16}; // corners per welding task
+
+  private:
+    struct Corner
+    {
+      int32_t position{-1};
+      int32_t uv{-1};
+      int32_t normal{-1};
+      uint8_t relative{}; // bit per index, negative obj indices still local to the chunk
+    };
+
+    struct Chunk
+    {
+      std::string_view text;
+
+      std::vector<glm::vec3> positions;
+      std::vector<glm::vec3> colors;
+      std::vector<glm::vec3> normals;
+      std::vector<glm::vec2> uvs;
+      std::vector<Corner> corners; // three per triangle
+      std::vector<uint32_t> quads; // first corner of every quad
+
+      // prefix sums over the previous chunks
+      uint32_t positionOffset{};
+      uint32_t normalOffset{};
+      uint32_t uvOffset{};
+      uint32_t cornerOffset{};
+    };
+
+    auto split(std::string_view text) const -> std::vector<Chunk>;
+    static void parse(Chunk* chunk);
+    static void parseLine(const char* begin, const char* end, Chunk* chunk, std::vector<Corner>* polygon);
+
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& body);
+
+  private:
+    ThreadPool* m_threadPool;
+  };
+} // namespace vke
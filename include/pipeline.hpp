@@ -4,6 +4,7 @@
 
 #include "device.hpp"
 #include "swapchain.hpp"
+#include "utils.hpp"
 
 namespace vke
 {
@@ -17,9 +18,12 @@ namespace vke
     struct ShaderPaths;
 
     Pipeline(Device& device, const ShaderPaths shaderPaths, const Config& config);
+    // the modules are not owned, see PipelineRegistry. without a fragment module only depth is written
+    Pipeline(Device& device, VkShaderModule vertModule, VkShaderModule fragModule, const Config& config);
     ~Pipeline();
 
-    static void defaultConfig(VkExtent2D extent, bool fullscreen, Config* config);
+    // viewport and scissor are always dynamic, so pipelines survive swapchain resizes
+    static void defaultConfig(Config* config);
 
     // auto descriptorSetLayouts() -> VkDescriptorSetLayout& { return m_descriptorSetLayout; };
     void bindDescriptorSets(VkCommandBuffer commandBuffer, VkDescriptorSet* descriptorSet, VkPipelineLayout layout);
@@ -33,14 +37,15 @@ namespace vke
       return m_pipeline;
     };
 
+    static auto readFile(std::filesystem::path path) -> std::vector<char>;
+
   private:
     void createPipeline(const ShaderPaths& shaderPaths, const Config& config);
+    void createPipeline(VkShaderModule vertModule, VkShaderModule fragModule, const Config& config);
     // void createDescriptorSetLayout(const Config& config); //std::span<VkDescriptorSetLayoutBinding> uboLayoutBindings
     // void createPipelineLayout();
     void createShaderModule(std::vector<char>& buffer, VkShaderModule* module);
 
-    static auto readFile(std::filesystem::path path) -> std::vector<char>;
-
     Device& m_device;
     // VkExtent2D m_swapchainExtent;
     VkPipeline m_pipeline;
@@ -61,9 +66,12 @@ namespace vke
     Config(Config&&) = delete;
     Config& operator=(Config&&) = delete;
 
+    // covers every field that ends up in VkGraphicsPipelineCreateInfo (not the shaders)
+    auto hash() const -> size_t;
+    // compares the same fields as hash()
+    bool operator==(const Config& other) const;
+
     // std::vector<VkPipelineShaderStageCreateInfo> shaderStages{};
-    VkViewport viewport{};
-    VkRect2D scissor{};
     std::vector<VkVertexInputBindingDescription> bindingDescriptions{};
     std::vector<VkVertexInputAttributeDescription> attributeDescriptions{};
     //VkPipelineVertexInputStateCreateInfo vertexInput{};
@@ -88,6 +96,6 @@ namespace vke
   struct Pipeline::ShaderPaths
   {
     std::filesystem::path vert;
-    std::filesystem::path frag;
+    std::filesystem::path frag; // empty for depth only pipelines
   };
 } // namespace vke
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "core.hpp"
+
+namespace vke
+{
+  class PhysicalDeviceInfo;
+
+  // device wide VkPipelineCache persisted to disk, so only the first launch pays for shader compilation.
+  // one file per vendor/device/driver, the blob is only used if the driver's own header
+  // (vendor, device, pipelineCacheUUID) matches, otherwise the cache starts empty.
+  class PipelineCache
+  {
+  public:
+    PipelineCache(VkDevice device, const PhysicalDeviceInfo& info, const std::filesystem::path& directory);
+    ~PipelineCache(); // saves
+
+    void save();
+
+    auto path() const -> const std::filesystem::path& { return m_path; }
+    bool wasLoaded() const { return m_loaded; }
+
+    operator VkPipelineCache() const { return m_cache; }
+
+    PipelineCache(const PipelineCache&) = delete;
+    PipelineCache& operator=(const PipelineCache&) = delete;
+
+  private:
+    auto load() -> std::vector<char>;
+    bool isCompatible(std::span<const char> data) const;
+
+  private:
+    // written in front of the driver blob, catches truncated files and driver updates
+    struct FileHeader
+    {
+      char magic[4]{'V', 'K', 'E', 'P'};
+      uint32_t version{1};
+      uint32_t driverVersion{};
+      uint32_t dataSize{};
+      uint64_t checksum{};
+    };
+
+    static auto checksum(std::span<const char> data) -> uint64_t;
+
+    VkDevice m_device;
+    const PhysicalDeviceInfo& m_info;
+    std::filesystem::path m_path;
+    VkPipelineCache m_cache{VK_NULL_HANDLE};
+    bool m_loaded{};
+  };
+} // namespace vke
@@ -0,0 +1,92 @@
+#pragma once
+
+#include "core.hpp"
+#include "device.hpp"
+#include "pipeline.hpp"
+#include "threadPool.hpp"
+
+namespace vke
+{
+  struct PipelineHandle
+  {
+    static constexpr uint32_t invalidIndex{~0u};
+
+    uint32_t index{invalidIndex};
+
+    bool isValid() const { return index != invalidIndex; }
+  };
+
+  // owns every graphics pipeline. a pipeline is keyed by its Config and the shader modules it uses, so systems
+  // asking for the same state share it. shader modules are created once per file.
+  // missing pipelines can be compiled on the thread pool; until they're ready bind() uses the fallback
+  // given to request(), or reports that nothing can be drawn.
+  class PipelineRegistry
+  {
+  public:
+    using Handle = PipelineHandle;
+
+    enum class Mode
+    {
+      blocking, // compiled before request() returns
+      async,    // compiled on the thread pool
+    };
+
+    PipelineRegistry(Device& device, ThreadPool& threadPool);
+    ~PipelineRegistry(); // waits for pending compilations
+
+    auto request(const Pipeline::ShaderPaths& shaderPaths, const Pipeline::Config& config, Mode mode = Mode::blocking, Handle fallback = {}) -> Handle;
+
+    bool isReady(Handle handle) const;
+    // the pipeline, or the fallback's while it compiles, or VK_NULL_HANDLE
+    auto get(Handle handle) const -> VkPipeline;
+    // false when there's nothing to bind yet, the caller should skip its draws
+    bool bind(VkCommandBuffer commandBuffer, Handle handle) const;
+
+    void waitIdle();
+
+    // the render pass is being destroyed: its pipelines can't be matched anymore (a new render pass may get the
+    // same handle), and the compiled ones are destroyed. their handles then bind nothing, the gpu must be done with them
+    void retire(VkRenderPass renderPass);
+
+    auto pipelineCount() const -> size_t;
+
+    PipelineRegistry(const PipelineRegistry&) = delete;
+    PipelineRegistry& operator=(const PipelineRegistry&) = delete;
+
+  private:
+    struct ShaderModule
+    {
+      VkShaderModule module{VK_NULL_HANDLE};
+      size_t codeHash{};
+    };
+
+    struct Key
+    {
+      Pipeline::Config config;
+      VkShaderModule vert{VK_NULL_HANDLE};
+      VkShaderModule frag{VK_NULL_HANDLE};
+    };
+
+    struct Entry
+    {
+      Key key;
+      std::unique_ptr<Pipeline> pipeline;
+      std::atomic<VkPipeline> handle{VK_NULL_HANDLE}; // published once the compilation finished
+      std::shared_future<void> compilation;
+      Handle fallback{};
+    };
+
+    auto shaderModule(const std::filesystem::path& path) -> const ShaderModule&;
+    void compile(Entry& entry, VkShaderModule vert, VkShaderModule frag, const Pipeline::Config& config);
+    void forget(size_t hash, uint32_t index);
+
+  private:
+    Device& m_device;
+    ThreadPool& m_threadPool;
+
+    mutable std::mutex m_mutex;
+    std::deque<Entry> m_entries; // stable addresses, workers write into them
+    std::unordered_map<size_t, std::vector<uint32_t>> m_buckets; // key hash -> entries, retired ones removed
+    std::unordered_map<std::string, ShaderModule> m_shaderModules;
+  };
+} // namespace vke
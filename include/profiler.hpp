@@ -0,0 +1,136 @@
+#pragma once
+
+#include "stdLibraries.hpp"
+
+// CPU instrumentation. everything below compiles out unless VKE_ENABLE_PROFILER is defined
+// (xmake f --profiler=y), so zones can stay in hot paths.
+//
+//   VKE_PROFILE_FUNCTION();          // zone named after the enclosing function
+//   VKE_PROFILE_ZONE("acquire");     // zone for the rest of the scope, the name must outlive the program (a literal)
+//   VKE_PROFILE_FRAME();             // frame marker, once per loop iteration
+//   VKE_PROFILE_EXPORT(path);        // dumps every thread buffer as chrome://tracing / ui.perfetto.dev json
+
+#if defined(__x86_64__) || defined(_M_X64)
+  #include <x86intrin.h>
+#endif
+
+namespace vke::prof
+{
+  inline auto steadyNow() -> uint64_t
+  {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+
+  // raw ticks. on x86 the tsc is read directly (steady_clock alone costs ~40ns on some kernels),
+  // ticks are converted to ns when exporting with a ratio measured against steady_clock.
+  inline auto now() -> uint64_t
+  {
+#if defined(__x86_64__) || defined(_M_X64)
+    return __rdtsc();
+#else
+    return steadyNow();
+#endif
+  }
+
+  struct ZoneEvent
+  {
+    const char* name;
+    uint64_t begin; // ticks
+    uint64_t end;   // ticks, equal to begin for instant events (frame markers)
+  };
+
+  // single producer ring, only the owning thread writes. when it wraps the oldest events are dropped.
+  // the exporter reads it after the producers are done (end of Program::run), the head is atomic so a
+  // concurrent read never sees a half published index.
+  class ThreadBuffer
+  {
+  public:
+    static constexpr size_t capacity{1 << 16}; // power of two, 1.5MB per thread
+
+    explicit ThreadBuffer(uint32_t threadId) :
+      m_threadId{threadId} {}
+
+    void push(const char* name, uint64_t begin, uint64_t end)
+    {
+      uint64_t head{m_head.load(std::memory_order_relaxed)};
+      m_events[head & (capacity - 1)] = {name, begin, end};
+      m_head.store(head + 1, std::memory_order_release);
+    }
+
+    auto threadId() const -> uint32_t { return m_threadId; }
+    auto head() const -> uint64_t { return m_head.load(std::memory_order_acquire); }
+    auto at(uint64_t i) const -> const ZoneEvent& { return m_events[i & (capacity - 1)]; }
+
+  private:
+    std::array<ZoneEvent, capacity> m_events;
+    std::atomic<uint64_t> m_head{};
+    uint32_t m_threadId;
+  };
+
+  class Profiler
+  {
+  public:
+    static auto instance() -> Profiler&;
+
+    // registers the calling thread on first use, afterwards it is a thread_local read
+    static auto threadBuffer() -> ThreadBuffer&
+    {
+      thread_local ThreadBuffer* buffer{instance().registerThread()};
+      return *buffer;
+    }
+
+    static void frameMark()
+    {
+      uint64_t t{now()};
+      threadBuffer().push("frame", t, t);
+    }
+
+    void writeChromeTrace(const std::filesystem::path& path);
+
+  private:
+    Profiler();
+    auto registerThread() -> ThreadBuffer*;
+
+  private:
+    uint64_t m_startTicks;
+    uint64_t m_startNs;
+
+    std::mutex m_mutex;
+    std::vector<std::unique_ptr<ThreadBuffer>> m_buffers; // outlive their threads, so nothing is lost on exit
+  };
+
+  class ScopedZone
+  {
+  public:
+    explicit ScopedZone(const char* name) :
+      m_name{name},
+      m_begin{now()} {}
+
+    ~ScopedZone()
+    {
+      Profiler::threadBuffer().push(m_name, m_begin, now());
+    }
+
+    ScopedZone(const ScopedZone&) = delete;
+    ScopedZone& operator=(const ScopedZone&) = delete;
+
+  private:
+    const char* m_name;
+    uint64_t m_begin;
+  };
+} // namespace vke::prof
+
+#define VKE_PROFILE_CONCAT_IMPL(a, b) a##b
+#define VKE_PROFILE_CONCAT(a, b) VKE_PROFILE_CONCAT_IMPL(a, b)
+
+#ifdef VKE_ENABLE_PROFILER
+  #define VKE_PROFILE_ZONE(name) ::vke::prof::ScopedZone VKE_PROFILE_CONCAT(vkeProfileZone, __LINE__){name}
+  #define VKE_PROFILE_FUNCTION() VKE_PROFILE_ZONE(__func__)
+  #define VKE_PROFILE_FRAME() ::vke::prof::Profiler::frameMark()
+  #define VKE_PROFILE_EXPORT(path) ::vke::prof::Profiler::instance().writeChromeTrace(path)
+#else
+  #define VKE_PROFILE_ZONE(name) ((void)0)
+  #define VKE_PROFILE_FUNCTION() ((void)0)
+  #define VKE_PROFILE_FRAME() ((void)0)
+  #define VKE_PROFILE_EXPORT(path) ((void)0)
+#endif
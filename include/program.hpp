@@ -5,10 +5,15 @@
 #include "camera.hpp"
 #include "descriptor.hpp"
 #include "events.hpp"
+#include "frameLimiter.hpp"
 #include "input.hpp"
+#include "lightClusters.hpp"
+#include "material.hpp"
 #include "model.hpp"
 #include "modelManager.hpp"
+#include "pipelineRegistry.hpp"
 #include "renderer.hpp"
+#include "textureManager.hpp"
 #include "systems/pointLight.hpp"
 #include "systems/renderSystem.hpp"
 #include "window.hpp"
@@ -20,8 +25,6 @@ namespace vke
     glm::mat4 projectionMatrix{1.f};
     glm::mat4 ViewMatrix{1.f};
     glm::vec4 ambientLightColor{1.f, 1.f, 1.f, .02f};
-    glm::vec3 lightPosition{-1.f, -1.f, -1.f};
-    alignas(16) glm::vec4 lightColor{1.f, 1.f, 1.f, 1.0f};
     glm::vec4 cameraPosition{1.f};
   };
 
@@ -37,6 +40,7 @@ namespace vke
 
   private:
     void loadEntities();
+    void reportOverdraw();
 
     //   void bindListeners();
     //   void poolEvents();
@@ -47,14 +51,22 @@ namespace vke
     Window m_window;
     Device m_device;
 
+    ThreadPool m_threadPool;
+    PipelineRegistry m_pipelineRegistry;
+
     Coordinator m_ecs;
     ModelManager m_modelManager;
+    TextureManager m_textureManager;
 
     Renderer m_renderer;
     //{m_device, m_modelManager, m_renderer.renderPass(), m_renderer.swapchainExtent()};
 
-    std::unique_ptr<DescriptorPool> m_globalDescriptorPool{};
+    DescriptorAllocator m_descriptors; // sets living as long as the program, the per frame ones are the renderer's
+    MaterialLibrary m_materials;
     std::vector<EntityID> m_entities;
+    std::vector<EntityID> m_lights; // cmp::PointLight
     std::filesystem::path m_modelsPath;
+    bool m_depthPrepass{}; // chosen by the scene, see loadEntities
+
   };
 } // namespace vke
@@ -0,0 +1,232 @@
+#pragma once
+
+#include "core.hpp"
+#include "device.hpp"
+#include "gpuProfiler.hpp"
+
+namespace vke
+{
+  // the frame as a list of passes declaring the images and buffers they read and write. passes run in
+  // declaration order and read what the passes declared before them wrote.
+  //
+  // compile() does the bookkeeping once: it culls the passes nothing depends on, creates the transient images
+  // (those whose lifetimes don't overlap share memory), one render pass per pass drawing into attachments, and
+  // plans every barrier and layout transition in between. execute() replays that plan each frame, only the
+  // imported resources (the swapchain image) change. compile again after adding passes or on a resize.
+  class RenderGraph
+  {
+  public:
+    template<typename Tag>
+    struct Handle
+    {
+      static constexpr uint32_t invalidIndex{~0u};
+
+      uint32_t index{invalidIndex};
+
+      bool isValid() const { return index != invalidIndex; }
+    };
+
+    using ImageHandle = Handle<struct ImageTag>;
+    using BufferHandle = Handle<struct BufferTag>;
+    using PassHandle = Handle<struct PassTag>;
+
+    // transient images only live during the frame, their content never survives to the next one
+    struct ImageDesc
+    {
+      VkFormat format{VK_FORMAT_UNDEFINED};
+      VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
+    };
+
+    // what an imported resource is in before the frame, or has to be left in after it
+    struct ExternalState
+    {
+      VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+      VkPipelineStageFlags stages{VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT};
+      VkAccessFlags access{};
+    };
+
+    class PassBuilder
+    {
+    public:
+      // attachments, colors first in declaration order then the depth. without a clear value they're loaded
+      auto writeColor(ImageHandle image, std::optional<VkClearColorValue> clear = std::nullopt) -> PassBuilder&;
+      auto writeDepth(ImageHandle image, std::optional<VkClearDepthStencilValue> clear = std::nullopt) -> PassBuilder&;
+      auto readDepth(ImageHandle image) -> PassBuilder&; // depth test without writes
+
+      auto readTexture(ImageHandle image, VkPipelineStageFlags stages = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT) -> PassBuilder&;
+      auto readBuffer(BufferHandle buffer, VkPipelineStageFlags stages, VkAccessFlags access) -> PassBuilder&;
+      auto writeBuffer(BufferHandle buffer, VkPipelineStageFlags stages, VkAccessFlags access) -> PassBuilder&;
+
+      auto sideEffect() -> PassBuilder&; // never culled, for passes whose results leave the graph some other way
+      auto execute(std::function<void(VkCommandBuffer)> record) -> PassBuilder&;
+
+      auto handle() const -> PassHandle { return m_pass; }
+
+    private:
+      PassBuilder(RenderGraph& graph, PassHandle pass) : m_graph{graph}, m_pass{pass} {}
+
+      friend class RenderGraph;
+
+      RenderGraph& m_graph;
+      PassHandle m_pass;
+    };
+
+    explicit RenderGraph(Device& device);
+    ~RenderGraph();
+
+    // names must outlive the graph (literals), they're also the gpu profiler's scope names
+    auto createImage(const char* name, const ImageDesc& desc) -> ImageHandle;
+    auto importImage(const char* name, VkFormat format, ExternalState initial, ExternalState final) -> ImageHandle;
+    auto importBuffer(const char* name) -> BufferHandle;
+    auto addPass(const char* name) -> PassBuilder;
+
+    // the format of an image, takes effect with the next compile()
+    void setFormat(ImageHandle image, VkFormat format);
+    // the imported resources of the frame, before execute(). the set of views an image cycles through has to
+    // stay the same between two compile(), framebuffers are cached by them
+    void setImage(ImageHandle image, VkImage handle, VkImageView view);
+    void setBuffer(BufferHandle buffer, VkBuffer handle);
+
+    // waits for the device when it replaces resources
+    void compile(VkExtent2D extent);
+    bool isCompiled() const { return m_compiled; }
+
+    void execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler = nullptr);
+
+    // after compile(). VK_NULL_HANDLE for culled passes and the ones without attachments
+    auto renderPass(PassHandle pass) const -> VkRenderPass { return m_passes[pass.index].renderPass; }
+    bool isCulled(PassHandle pass) const { return m_passes[pass.index].culled; }
+
+    auto transientMemorySize() const -> VkDeviceSize { return m_memorySize; }
+    auto unaliasedMemorySize() const -> VkDeviceSize { return m_unaliasedSize; } // without the aliasing
+
+    RenderGraph(const RenderGraph&) = delete;
+    RenderGraph& operator=(const RenderGraph&) = delete;
+
+    // the barrier planning, exposed for the tests
+    enum class Usage : uint8_t
+    {
+      colorAttachment,
+      depthAttachment,
+      depthRead,
+      sampled,
+      buffer,
+    };
+
+    struct Access
+    {
+      Usage usage{};
+      uint32_t resource{}; // image, or buffer for Usage::buffer
+      VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+      VkPipelineStageFlags stages{};
+      VkAccessFlags access{};
+      bool write{};
+      std::optional<VkClearValue> clear{}; // attachments written without it load their content
+    };
+
+    struct Barrier
+    {
+      bool isImage{};
+      uint32_t resource{};
+      VkImageLayout oldLayout{};
+      VkImageLayout newLayout{};
+      VkPipelineStageFlags srcStages{};
+      VkPipelineStageFlags dstStages{};
+      VkAccessFlags srcAccess{};
+      VkAccessFlags dstAccess{};
+    };
+
+    // a resource between two passes: the last writes, and who already waited for them
+    struct State
+    {
+      VkImageLayout layout{VK_IMAGE_LAYOUT_UNDEFINED};
+      VkPipelineStageFlags writeStages{};
+      VkAccessFlags writeAccess{};
+      VkPipelineStageFlags readStages{};
+      VkPipelineStageFlags visibleStages{}; // the stages a barrier made the last write visible to, none right after it
+      bool dirty{}; // written or transitioned, the stages outside visibleStages have to wait
+    };
+
+    // records the barrier the access needs after what state holds (if any) and updates state
+    static void synchronize(State* state, const Access& access, bool isImage, std::vector<Barrier>* barriers);
+
+  private:
+    struct Image
+    {
+      const char* name{};
+      ImageDesc desc{};
+      bool imported{};
+      ExternalState initial{};
+      ExternalState final{};
+
+      VkImage image{VK_NULL_HANDLE};
+      VkImageView view{VK_NULL_HANDLE};
+      uint32_t block{~0u};   // transient memory
+      uint32_t firstPass{~0u}; // lifetime, in passes
+      uint32_t lastPass{};
+    };
+
+    struct Buffer
+    {
+      const char* name{};
+      VkBuffer buffer{VK_NULL_HANDLE};
+    };
+
+    struct Framebuffer
+    {
+      std::vector<VkImageView> views;
+      VkFramebuffer framebuffer{VK_NULL_HANDLE};
+    };
+
+    struct Pass
+    {
+      const char* name{};
+      std::vector<Access> accesses;
+      std::function<void(VkCommandBuffer)> record;
+      bool sideEffect{};
+
+      // compiled
+      bool culled{};
+      std::vector<Barrier> barriers; // before the pass
+      VkRenderPass renderPass{VK_NULL_HANDLE};
+      std::vector<uint32_t> attachments; // images, in render pass order
+      std::vector<VkClearValue> clearValues;
+      std::vector<Framebuffer> framebuffers;
+    };
+
+    // a transient allocation, shared by images that are never alive at the same time
+    struct Block
+    {
+      VkDeviceMemory memory{VK_NULL_HANDLE};
+      VkDeviceSize size{};
+      uint32_t memoryType{};
+      std::vector<uint32_t> images; // by first use
+    };
+
+    void addAccess(PassHandle pass, Access access);
+
+    void cullPasses();
+    void allocateImages();
+    void createRenderPasses();
+    void planBarriers();
+    void destroyResources();
+
+    auto framebuffer(Pass& pass) -> VkFramebuffer;
+    void recordBarriers(VkCommandBuffer commandBuffer, std::span<const Barrier> barriers) const;
+    auto aspectMask(const Image& image) const -> VkImageAspectFlags;
+
+  private:
+    Device& m_device;
+
+    std::vector<Image> m_images;
+    std::vector<Buffer> m_buffers;
+    std::vector<Pass> m_passes;
+    std::vector<Block> m_blocks;
+    std::vector<Barrier> m_finalBarriers; // leave the imported images as they asked
+
+    VkExtent2D m_extent{};
+    bool m_compiled{};
+    VkDeviceSize m_memorySize{};
+    VkDeviceSize m_unaliasedSize{};
+  };
+} // namespace vke
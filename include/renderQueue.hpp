@@ -0,0 +1,73 @@
+#pragma once
+
+#include "core.hpp"
+
+namespace vke
+{
+  // the frame's draws, each behind a 64 bit key ordering them by the state they need. sorted, draws sharing
+  // a pipeline are consecutive, inside it the ones sharing a material, then a mesh, front to back last. the
+  // recording only rebinds what changed from the previous key's fields.
+  //
+  // the key, most significant bits first:
+  //   pass      4 bits   opaque before the rest
+  //   pipeline  8 bits
+  //   material 16 bits
+  //   mesh     16 bits   the frame's index of the mesh, not an id of the model
+  //   depth    20 bits   view distance over the far plane, quantized
+  class RenderQueue
+  {
+  public:
+    using Key = uint64_t;
+
+    static constexpr uint32_t passBits{4};
+    static constexpr uint32_t pipelineBits{8};
+    static constexpr uint32_t materialBits{16};
+    static constexpr uint32_t meshBits{16};
+    static constexpr uint32_t depthBits{20};
+
+    static constexpr uint32_t depthShift{0};
+    static constexpr uint32_t meshShift{depthShift + depthBits};
+    static constexpr uint32_t materialShift{meshShift + meshBits};
+    static constexpr uint32_t pipelineShift{materialShift + materialBits};
+    static constexpr uint32_t passShift{pipelineShift + pipelineBits};
+    static_assert(passShift + passBits == 64);
+
+    struct Entry
+    {
+      Key key;
+      uint32_t item; // the caller's, usually an index into its draws
+    };
+
+    // the fields are masked to their width, depth is clamped to [0, 1]
+    static auto makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth) -> Key;
+
+    static auto pass(Key key) -> uint32_t { return field(key, passShift, passBits); }
+    static auto pipeline(Key key) -> uint32_t { return field(key, pipelineShift, pipelineBits); }
+    static auto material(Key key) -> uint32_t { return field(key, materialShift, materialBits); }
+    static auto mesh(Key key) -> uint32_t { return field(key, meshShift, meshBits); }
+    static auto depth(Key key) -> uint32_t { return field(key, depthShift, depthBits); }
+
+    void clear() { m_entries.clear(); }
+    void push(Key key, uint32_t item) { m_entries.push_back({key, item}); }
+
+    // stable, equal keys keep their push order
+    void sort();
+
+    auto entries() const -> std::span<const Entry> { return m_entries; }
+    auto size() const -> size_t { return m_entries.size(); }
+
+    // lsd radix sort on bytes, a pass is skipped when every key shares its byte (the pass and pipeline bytes
+    // mostly do). exposed for the tests, scratch is resized to entries' size
+    static void radixSort(std::vector<Entry>* entries, std::vector<Entry>* scratch);
+
+  private:
+    static auto field(Key key, uint32_t shift, uint32_t bits) -> uint32_t
+    {
+      return static_cast<uint32_t>((key >> shift) & ((Key{1} << bits) - 1));
+    }
+
+  private:
+    std::vector<Entry> m_entries{};
+    std::vector<Entry> m_scratch{}; // reused every frame
+  };
+} // namespace vke
@@ -3,7 +3,10 @@
 #include "core.hpp"
 //
 #include "allocator.hpp"
+#include "descriptor.hpp"
 #include "device.hpp"
+#include "gpuProfiler.hpp"
+#include "renderGraph.hpp"
 #include "systems/renderSystem.hpp"
 #include "swapchain.hpp"
 #include "window.hpp"
@@ -13,13 +16,13 @@ namespace vke
   class Renderer
   {
   public:
-    Renderer(Device& device, Window& window, EventRelayer& relayer);
+    Renderer(Device& device, Window& window, EventRelayer& relayer, VkPresentModeKHR presentMode = VK_PRESENT_MODE_FIFO_KHR);
     ~Renderer();
 
     bool beginFrame();
     void endFrame();
-    void beginRenderPass();
-    void endRenderPass();
+    // runs the render graph's passes into the current command buffer
+    void render();
     void present();
 
     bool isFrameInProgress() const
@@ -32,6 +35,15 @@ namespace vke
     {
       return m_swapchain->renderPass();
     }
+    auto depthRenderPass() const -> VkRenderPass
+    {
+      return m_swapchain->depthRenderPass();
+    }
+    // the render passes destroyed with the swapchains replaced since the last call, see PipelineRegistry::retire
+    auto takeRetiredRenderPasses() -> std::vector<VkRenderPass>
+    {
+      return std::exchange(m_retiredRenderPasses, {});
+    }
     auto swapchainAspectRatio() const -> float
     {
       return m_swapchain->aspectRatio();
@@ -52,6 +64,44 @@ namespace vke
     {
       return m_currentFrameIndex;
     }
+    // takes effect with the next present, through a swapchain recreation
+    void setPresentMode(VkPresentModeKHR presentMode);
+    auto requestedPresentMode() const -> VkPresentModeKHR
+    {
+      return m_requestedPresentMode;
+    }
+    // the one in use, which may be a fallback of the requested one
+    auto presentMode() const -> VkPresentModeKHR
+    {
+      return m_swapchain->info().presentMode;
+    }
+    auto gpuProfiler() -> GpuProfiler&
+    {
+      return *m_gpuProfiler;
+    }
+    // the current frame's, reset by beginFrame() once the frame's fence signaled. for sets used by one frame only
+    auto frameDescriptors() -> DescriptorAllocator&
+    {
+      return *m_frameDescriptors[m_currentFrameIndex];
+    }
+    auto layoutCache() -> DescriptorLayoutCache&
+    {
+      return m_layoutCache;
+    }
+    // the frame's passes are added to it, drawing into the backbuffer (the acquired swapchain image) and the depth
+    // buffer. both match the attachments of renderPass(), which the pipelines are created with
+    auto renderGraph() -> RenderGraph&
+    {
+      return m_renderGraph;
+    }
+    auto backbuffer() const -> RenderGraph::ImageHandle
+    {
+      return m_backbuffer;
+    }
+    auto depthBuffer() const -> RenderGraph::ImageHandle
+    {
+      return m_depthBuffer;
+    }
 
   private:
     void allocateCommandBuffers();
@@ -77,7 +127,16 @@ namespace vke
     EventRelayer& m_eventRelayer;
 
     std::unique_ptr<Swapchain> m_swapchain;
+    std::vector<VkRenderPass> m_retiredRenderPasses;
     std::vector<VkCommandBuffer> m_commandBuffers;
+    std::unique_ptr<GpuProfiler> m_gpuProfiler;
+
+    DescriptorLayoutCache m_layoutCache;
+    std::vector<std::unique_ptr<DescriptorAllocator>> m_frameDescriptors; // one per frame in flight
+
+    RenderGraph m_renderGraph;
+    RenderGraph::ImageHandle m_backbuffer;
+    RenderGraph::ImageHandle m_depthBuffer;
 
     // TODO: you could move the submitCommandBuffers and present functionality into the swapchain class
     std::vector<VkSemaphore> m_imageAvailableSemaphore; //  signal that an image has been acquired and is ready for rendering
@@ -85,6 +144,9 @@ namespace vke
     std::vector<VkFence> m_inFlightFences;
     std::vector<VkFence> m_imagesInFlight;
 
+    VkPresentModeKHR m_requestedPresentMode{VK_PRESENT_MODE_FIFO_KHR};
+    bool m_presentModeChanged{};
+
     uint32_t m_maxFramesInFlight{};
     uint32_t m_currentFrameIndex{};
     uint32_t m_currentImageIndex{};
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "core.hpp"
+#include "device.hpp"
+
+namespace vke
+{
+  // the part of a sampler textures differ in, the rest of its create info is fixed
+  struct SamplerState
+  {
+    VkFilter magFilter{VK_FILTER_LINEAR};
+    VkFilter minFilter{VK_FILTER_LINEAR};
+    VkSamplerMipmapMode mipmapMode{VK_SAMPLER_MIPMAP_MODE_LINEAR};
+    VkSamplerAddressMode addressModeU{VK_SAMPLER_ADDRESS_MODE_REPEAT};
+    VkSamplerAddressMode addressModeV{VK_SAMPLER_ADDRESS_MODE_REPEAT};
+    VkSamplerAddressMode addressModeW{VK_SAMPLER_ADDRESS_MODE_REPEAT};
+    float maxAnisotropy{16.f}; // clamped to the device's limit, 1 or less (or no samplerAnisotropy) turns it off
+    float maxLod{VK_LOD_CLAMP_NONE};
+
+    bool operator==(const SamplerState&) const = default;
+  };
+
+  // one VkSampler per distinct state, shared by every texture sampled that way. samplers are immutable and
+  // few (devices may cap them at 4000), so they're never destroyed before the cache. main thread only
+  class SamplerCache
+  {
+  public:
+    using State = SamplerState;
+
+    explicit SamplerCache(Device& device);
+    ~SamplerCache();
+
+    auto get(const State& state = {}) -> VkSampler;
+    auto size() const -> size_t { return m_samplers.size(); }
+
+    SamplerCache(const SamplerCache&) = delete;
+    SamplerCache& operator=(const SamplerCache&) = delete;
+
+  private:
+    struct StateHash
+    {
+      auto operator()(const State& state) const -> size_t;
+    };
+
+    Device& m_device;
+    std::unordered_map<State, VkSampler, StateHash> m_samplers{};
+  };
+} // namespace vke
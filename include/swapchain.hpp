@@ -26,9 +26,11 @@ namespace vke
       VkPresentModeKHR presentMode;
       uint32_t imageCount;
       VkExtent2D extent;
+      VkSampleCountFlagBits samples{VK_SAMPLE_COUNT_1_BIT};
     };
 
-    Swapchain(Device& device, Window& window, std::unique_ptr<Swapchain> pOldSwapchain = nullptr);
+    // the present mode is a request, it falls back to what the surface supports (see choosePresentMode)
+    Swapchain(Device& device, Window& window, VkPresentModeKHR presentMode, std::unique_ptr<Swapchain> pOldSwapchain = nullptr);
     ~Swapchain();
 
     operator VkSwapchainKHR() { return m_swapchain; }
@@ -37,8 +39,11 @@ namespace vke
     auto extent() const -> VkExtent2D { return m_info.extent; }
     auto aspectRatio() const -> float;
     auto imageCount() const -> uint32_t { return m_info.imageCount; }  //images.size()
+    // the attachments the render graph's passes draw into, pipelines are created against this render pass
     auto renderPass() const -> VkRenderPass { return m_renderPass; };
-    auto framebuffers() -> std::span<VkFramebuffer> { return m_framebuffers; }
+    auto depthRenderPass() const -> VkRenderPass { return m_depthRenderPass; } // the depth attachment alone
+    auto images() const -> std::span<const VkImage> { return m_images; }
+    auto imageViews() const -> std::span<const VkImageView> { return m_imageViews; }
     auto acquireNextImage(VkSemaphore imageAvailableSemaphore, uint32_t* imageIndex) -> VkResult;
 
     Swapchain(const Swapchain&) = delete;
@@ -46,41 +51,40 @@ namespace vke
 
     friend bool operator==(const VkSurfaceFormatKHR& first, const VkSurfaceFormatKHR& second);
     bool compareSwapchainFormats(const Info& other) const;
+    bool isRenderPassCompatible(const Info& other) const;
+    bool reusedRenderPass() const { return m_reusedRenderPass; }
 
     static bool hasStencilComponent(VkFormat format);
 
+    static auto presentModeName(VkPresentModeKHR presentMode) -> std::string_view;
+    // "fifo", "fifo_relaxed", "mailbox" or "immediate"
+    static auto parsePresentMode(std::string_view name) -> std::optional<VkPresentModeKHR>;
+
   private:
     void createSwapchain(VkSwapchainKHR oldSwapchain);
     void createImageViews();
     void createRenderPass();
-    void createFramebuffers();
 
     void querySupportDetails(VkSurfaceCapabilitiesKHR* capabilities = nullptr);
     void chooseSurfaceFormat();
-    void choosePresentMode();
+    void choosePresentMode(VkPresentModeKHR requested);
     void chooseExtent();
 
     void findDepthFormat(VkFormat* format);
-    void createDepthResources();
-    void createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageView* imageView);
 
   private:
     Device& m_device;
     Window& m_window;
 
     VkSwapchainKHR m_swapchain;
-    std::vector<VkImage> images;
-    std::vector<VkImageView> imageViews;
+    std::vector<VkImage> m_images;
+    std::vector<VkImageView> m_imageViews;
 
     supportDetails m_details;
     Info m_info;
 
-    VkRenderPass m_renderPass;
-    std::vector<VkFramebuffer> m_framebuffers;
-
-    //for 3d
-    VkImage m_depthImage;
-    VkImageView m_depthImageView;
-    VkDeviceMemory m_depthImageMemory;
+    VkRenderPass m_renderPass{VK_NULL_HANDLE};
+    VkRenderPass m_depthRenderPass{VK_NULL_HANDLE};
+    bool m_reusedRenderPass{};
   };
 }
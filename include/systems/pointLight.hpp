@@ -1,20 +1,36 @@
 #pragma once
 
+#include "buffer.hpp"
 #include "camera.hpp"
 #include "components.hpp"
 #include "core.hpp"
+#include "descriptor.hpp"
 #include "device.hpp"
 #include "ecs.hpp"
 #include "frameInfo.hpp"
 #include "modelManager.hpp"
 #include "pipeline.hpp"
+#include "pipelineRegistry.hpp"
 #include "utilities.hpp"
 
 namespace vke
 {
+  // a billboard per cmp::PointLight entity (FrameInfo::lights), all of them in one instanced draw. the instances
+  // come from set 1, a set of the frame's descriptors, or with RenderSystemContext::bindless from the bindless
+  // table, their buffer's slot pushed as a constant (pointLightBindless.vert)
   class PointLightSystem
   {
   public:
+    static constexpr float billboardRadius{0.075f}; // at intensity 1
+    static constexpr uint32_t initialInstances{256}; // per frame, grows when a frame needs more
+
+    // std430, mirrored in pointLight.vert and pointLightBindless.vert
+    struct Instance
+    {
+      glm::vec4 position; // world space, w is the billboard's radius
+      glm::vec4 color;
+    };
+
     PointLightSystem(Device& device, RenderSystemContext context);
     ~PointLightSystem();
 
@@ -25,7 +41,7 @@ namespace vke
     void recreateGraphicsPipeline(event::InvalidPipeline& event);
 
   private:
-    void createGraphicsPipeline(VkRenderPass renderPass, VkExtent2D extent);
+    void createGraphicsPipeline(VkRenderPass renderPass);
     void createPipelineLayout(VkDescriptorSetLayout globalDescriptorSetLayout);
 
     void cleanup();
@@ -33,9 +49,19 @@ namespace vke
   private:
     Device& m_device;
     EventRelayer& m_eventRelayer;
+    PipelineRegistry& m_pipelineRegistry;
     // ModelManager& m_modelManager;
 
     VkPipelineLayout m_pipelineLayout;
-    std::unique_ptr<Pipeline> m_pipeline;
+    PipelineRegistry::Handle m_pipeline;
+
+    // one buffer per frame in flight, host visible and rewritten every frame
+    DescriptorSetLayout& m_instanceSetLayout;
+    std::vector<std::unique_ptr<Buffer>> m_instanceBuffers{};
+    std::vector<Instance> m_instances{};
+
+    BindlessTable* m_bindless{};
+    std::vector<uint32_t> m_instanceSlots{}; // the buffers' in the bindless table
+
   };
 } // namespace vke
@@ -1,50 +1,110 @@
 #pragma once
 
+#include "buffer.hpp"
 #include "camera.hpp"
 #include "components.hpp"
 #include "core.hpp"
 #include "device.hpp"
 #include "ecs.hpp"
 #include "frameInfo.hpp"
+#include "material.hpp"
 #include "modelManager.hpp"
 #include "pipeline.hpp"
+#include "pipelineRegistry.hpp"
+#include "renderQueue.hpp"
 #include "utilities.hpp"
 
 namespace vke
 {
+  struct SimplePushConstantData
+  {
+    // glm::mat4 transform{1.f}; // it seems this can not be a mat3, otherwise the shader doesn't work
+    glm::mat4 modelMatrix{1.f};
+    glm::mat4 normalMatrix{1.f};
+    //  glm::vec2 offset{};
+    //  alignas(16) glm::vec3 color{1.f, 1.f, 1.f};
+  };
+
+  // draws the entities with a cmp::Common model and a cmp::Material. the frame's draws go through a RenderQueue,
+  // recorded in key order: the pipeline, the material's set (set 2) and the vertex buffers are only bound when
+  // they differ from the previous draw's
   class RenderSystem
   {
   public:
+    static constexpr float lodPixelError{1.f}; // simplification error allowed on screen
+    static constexpr float lodHysteresis{0.25f};
+    static constexpr uint32_t initialIndirectDraws{4096}; // per frame, grows when a frame needs more
+
     RenderSystem(Device& device, RenderSystemContext context);
     ~RenderSystem();
 
     // void loadModel(std::shared_ptr<Model>& models);
     void loadEntities();
     void render(FrameInfo info);
+    // with the depth pre-pass (RenderSystemContext::depthPrepass): lays down the depth of what render() draws
+    // next, which then shades only the visible surface (depth test less or equal, no depth writes). both
+    // passes draw the same lods, meshlets and matrices, picked and culled once here
+    void renderDepth(FrameInfo info);
 
     void recreateGraphicsPipeline(event::InvalidPipeline& event);
 
   private:
-    void createGraphicsPipeline(VkRenderPass renderPass, VkExtent2D extent);
-    void createPipelineLayout(VkDescriptorSetLayout globalDescriptorSetLayout);
+    // an entity's draw, shared by the depth pre-pass and the main pass
+    struct Draw
+    {
+      Model* model;
+      size_t pipeline;   // see pipelineIndex()
+      uint32_t material; // see MaterialLibrary
+      SimplePushConstantData push;
+      uint32_t lod;
+      uint32_t firstCommand; // its culled meshlets in the frame's indirect buffer
+      uint32_t commandCount; // zero: the whole lod
+    };
+
+    void createGraphicsPipeline(VkRenderPass renderPass, VkRenderPass depthRenderPass);
+    void createPipelineLayout(
+      VkDescriptorSetLayout globalDescriptorSetLayout,
+      VkDescriptorSetLayout lightDescriptorSetLayout,
+      VkDescriptorSetLayout materialDescriptorSetLayout);
+
+    static auto pipelineIndex(Model::VertexFormat format, Model::VertexLayout layout) -> size_t;
+    static auto selectLod(const FrameInfo& info, const cmp::Transform3D& transform, cmp::Common& common) -> uint32_t;
+
+    using Frustum = std::array<glm::vec4, 6>; // world space planes, normals pointing inside
+    static auto frustumPlanes(const glm::mat4& projectionView) -> Frustum;
+
+    // culls lod 0's meshlets against the frustum and their normal cones, the survivors go to the frame's
+    // indirect buffer. false when they didn't fit in it, the caller then draws the whole model
+    bool cullMeshlets(cmp::Transform3D& transform, const Model& model, const Frustum& frustum, const glm::vec3& camera, Draw* draw);
+
+    // picks the lods and culls the meshlets of the frame into m_draws, then sorts them by their keys
+    void prepare(const FrameInfo& info);
+    void record(const FrameInfo& info, std::span<const PipelineRegistry::Handle> pipelines, bool positionsOnly);
 
     void cleanup();
 
   private:
     Device& m_device;
     EventRelayer& m_eventRelayer;
+    PipelineRegistry& m_pipelineRegistry;
+    MaterialLibrary& m_materials;
     // ModelManager& m_modelManager;
 
     VkPipelineLayout m_pipelineLayout;
-    std::unique_ptr<Pipeline> m_pipeline;
-  };
+    // one per vertex format and layout, see pipelineIndex()
+    std::array<PipelineRegistry::Handle, 4> m_pipelines{};
+    std::array<PipelineRegistry::Handle, 4> m_depthPipelines{}; // positions only, no fragment shader
+    bool m_depthPrepass{};
 
-  struct SimplePushConstantData
-  {
-    // glm::mat4 transform{1.f}; // it seems this can not be a mat3, otherwise the shader doesn't work
-    glm::mat4 modelMatrix{1.f};
-    glm::mat4 normalMatrix{1.f};
-    //  glm::vec2 offset{};
-    //  alignas(16) glm::vec3 color{1.f, 1.f, 1.f};
+    std::vector<Draw> m_draws{}; // the frame's
+    RenderQueue m_queue{};       // m_draws' keys
+    std::unordered_map<const Model*, uint32_t> m_meshes{}; // the frame's mesh index of a model, for the keys
+
+    // one per frame in flight, host visible and always mapped, rewritten every frame
+    std::vector<std::unique_ptr<Buffer>> m_indirectBuffers{};
+    std::vector<VkDrawIndexedIndirectCommand> m_drawCommands{};
+    Buffer* m_indirectBuffer{}; // the current frame's
+    uint32_t m_indirectDraws{}; // used in it so far
+    uint32_t m_indirectCapacity{initialIndirectDraws};
   };
 } // namespace vke
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "allocator.hpp"
+#include "core.hpp"
+#include "device.hpp"
+
+namespace vke
+{
+  class MappedFile;
+  class UploadBatch;
+
+  // a sampled 2d image with its whole mip chain, in shader read only layout once its upload finished
+  class Texture
+  {
+  public:
+    struct Builder;
+
+    // a level of a Builder's data, the finest first
+    struct Level
+    {
+      VkDeviceSize offset{};
+      VkDeviceSize size{};
+      uint32_t width{};
+      uint32_t height{};
+    };
+
+    // only creates the image, the copies of every level are recorded into the batch
+    Texture(Device& device, const Builder& builder, UploadBatch* upload);
+    ~Texture();
+
+    auto image() const -> VkImage { return m_image; }
+    auto view() const -> VkImageView { return m_view; }
+    auto format() const -> VkFormat { return m_format; }
+    auto extent() const -> VkExtent2D { return m_extent; }
+    auto mipLevels() const -> uint32_t { return m_mipLevels; }
+    auto memorySize() const -> VkDeviceSize { return m_memorySize; }
+
+    // the device samples it with linear filtering (and the BC feature is on for block compressed formats)
+    static bool isSupported(Device& device, VkFormat format);
+    // bytes per texel block and the block's width (and height), nullopt for the formats the loader doesn't know
+    static auto blockSize(VkFormat format) -> std::optional<std::pair<uint32_t, uint32_t>>;
+    static auto mipCount(uint32_t width, uint32_t height) -> uint32_t;
+
+    Texture(const Texture&) = delete;
+    Texture& operator=(const Texture&) = delete;
+
+  private:
+    Device& m_device;
+
+    VkImage m_image{VK_NULL_HANDLE};
+    VkDeviceMemory m_memory{VK_NULL_HANDLE};
+    VkImageView m_view{VK_NULL_HANDLE};
+    VkFormat m_format{};
+    VkExtent2D m_extent{};
+    uint32_t m_mipLevels{};
+    VkDeviceSize m_memorySize{};
+  };
+
+  // the cpu side of a texture, what gets uploaded. loaded on the workers:
+  //   .ktx2: mapped, its levels uploaded as they're stored (block compressed or not, no supercompression)
+  //   anything stb_image reads (png, jpg, tga, bmp...): decoded to rgba8, the mip chain generated here
+  struct Texture::Builder
+  {
+    Builder() = default;
+    Builder(const std::filesystem::path& path, bool srgb = true)
+    {
+      load(path, srgb);
+    }
+
+    VkFormat format{VK_FORMAT_R8G8B8A8_SRGB};
+    uint32_t width{};
+    uint32_t height{};
+    std::vector<Level> levels{};
+    std::vector<std::byte> pixels{}; // the levels of decoded images, empty when mapped
+
+    // srgb picks the format of decoded images, ktx2 files name theirs
+    void load(const std::filesystem::path& path, bool srgb = true);
+
+    // rgba8 pixels, width * height of them. becomes level 0
+    void setPixels(std::span<const std::byte> rgba, uint32_t width, uint32_t height, bool srgb = true);
+    void decode(std::span<const std::byte> encoded, bool srgb = true);
+
+    // a ktx2 file's header and level index, the levels then point into file, which must outlive the builder
+    // (load() keeps its mapping alive). throws on what the loader can't upload as is
+    void parseKtx2(std::span<const std::byte> file);
+
+    // appends the levels down to 1x1 to a single level rgba8 image. a 2x2 box filter, in linear space for
+    // srgb formats, the odd rows and columns fold into the last texel (weighted by the area they cover)
+    void generateMips();
+
+    // what gets uploaded: pixels, or the ktx2 file the levels point into
+    auto data() const -> std::span<const std::byte>;
+
+  private:
+    std::shared_ptr<const MappedFile> m_mapping{};
+    std::span<const std::byte> m_mappedData{};
+  };
+} // namespace vke
@@ -0,0 +1,99 @@
+#pragma once
+
+#include "core.hpp"
+
+#include "device.hpp"
+#include "samplerCache.hpp"
+#include "texture.hpp"
+#include "threadPool.hpp"
+#include "uploadBatch.hpp"
+
+namespace vke
+{
+  struct TextureHandle
+  {
+    static constexpr uint32_t invalidIndex{~0u};
+
+    uint32_t index{invalidIndex};
+
+    bool isValid() const { return index != invalidIndex; }
+  };
+
+  // the asset manager for textures, loaded in the background like ModelManager's models: load() returns at
+  // once, a pool task reads the file (decodes it and generates its mips, or maps a ktx2 as it is), and update()
+  // (once per frame, main thread) uploads whatever finished in a single UploadBatch. until that batch's fence
+  // signals the texture is a 1x1 white placeholder, so is one that failed to load or whose format the device
+  // can't sample. a path (and color space) always maps to the same handle.
+  class TextureManager
+  {
+  public:
+    using Handle = TextureHandle;
+
+    TextureManager(Device& device, ThreadPool& threadPool);
+    ~TextureManager();
+
+    // srgb for colors, linear for data (normals, roughness...). ktx2 files name their own format
+    auto load(std::filesystem::path path, bool srgb = true) -> Handle;
+
+    void update();
+    void waitIdle(); // until everything requested so far is on the gpu
+
+    bool isReady(Handle handle) const;
+    // the placeholder while loading (or when loading failed)
+    auto get(Handle handle) -> Texture&;
+    // the texture (or the placeholder) with a sampler of the cache, for a combined image sampler
+    auto descriptorInfo(Handle handle, const SamplerState& sampler = {}) -> VkDescriptorImageInfo;
+
+    auto placeholder() -> Texture& { return *m_placeholder; }
+    auto samplers() -> SamplerCache& { return m_samplers; }
+
+    auto residentMemory() const -> VkDeviceSize { return m_residentMemory; }
+    auto textureCount() const -> size_t { return m_slots.size(); }
+
+    TextureManager(const TextureManager&) = delete;
+    TextureManager& operator=(const TextureManager&) = delete;
+
+  private:
+    struct Slot
+    {
+      std::filesystem::path path;
+      bool srgb{};
+      std::unique_ptr<Texture> texture{}; // null while loading, or when it failed
+      bool loading{};
+    };
+
+    struct Loaded
+    {
+      uint32_t slot;
+      std::optional<Texture::Builder> builder; // empty when loading failed
+    };
+
+    // what a batch in flight is uploading
+    struct Upload
+    {
+      std::unique_ptr<UploadBatch> batch;
+      std::vector<std::pair<uint32_t, std::unique_ptr<Texture>>> textures;
+    };
+
+    void startLoad(uint32_t slot);
+    void startUpload();
+    void finishUpload();
+
+  private:
+    Device& m_device;
+    ThreadPool& m_threadPool;
+
+    SamplerCache m_samplers;
+    std::unique_ptr<Texture> m_placeholder;
+
+    // main thread only
+    std::deque<Slot> m_slots;
+    std::unordered_map<std::string, uint32_t> m_pathSlots;
+    std::vector<std::future<void>> m_tasks;
+    std::optional<Upload> m_upload;
+    VkDeviceSize m_residentMemory{};
+
+    std::mutex m_mutex;
+    std::vector<Loaded> m_loaded; // filled by the workers
+  };
+} // namespace vke
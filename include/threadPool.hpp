@@ -0,0 +1,58 @@
+#pragma once
+
+#include "core.hpp"
+
+namespace vke
+{
+  // fixed set of workers pulling from a single queue. used for the cpu side work that can run
+  // next to the frame loop (pipeline compilation, asset loading).
+  class ThreadPool
+  {
+  public:
+    explicit ThreadPool(uint32_t threadCount = defaultThreadCount());
+    ~ThreadPool(); // finishes the queued tasks
+
+    template<typename F>
+    auto submit(F&& task) -> std::future<std::invoke_result_t<F>>;
+
+    // runs body(0..count-1) on the calling thread and the workers, returns once every item ran.
+    // the caller only ever waits for items somebody already started, so it's safe from inside a task.
+    // the first exception thrown by body is rethrown here
+    void parallelFor(uint32_t count, const std::function<void(uint32_t)>& body);
+
+    auto size() const -> uint32_t { return m_workers.size(); }
+
+    static auto defaultThreadCount() -> uint32_t;
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+  private:
+    void work();
+
+  private:
+    std::vector<std::thread> m_workers;
+    std::queue<std::function<void()>> m_tasks;
+    std::mutex m_mutex;
+    std::condition_variable m_condition;
+    bool m_stopping{};
+  };
+
+  template<typename F>
+  auto ThreadPool::submit(F&& task) -> std::future<std::invoke_result_t<F>>
+  {
+    using Result = std::invoke_result_t<F>;
+
+    // std::function needs a copyable callable
+    auto packaged{std::make_shared<std::packaged_task<Result()>>(std::forward<F>(task))};
+    std::future<Result> future{packaged->get_future()};
+
+    {
+      std::lock_guard lock{m_mutex};
+      m_tasks.emplace([packaged]() { (*packaged)(); });
+    }
+
+    m_condition.notify_one();
+    return future;
+  }
+} // namespace vke
@@ -0,0 +1,67 @@
+#pragma once
+
+#include "buffer.hpp"
+#include "core.hpp"
+#include "device.hpp"
+
+namespace vke
+{
+  // gathers buffer and image uploads and sends them as one staging buffer, one command buffer and one submit
+  // on the transfer queue. completion is polled through a fence, so nothing stalls the frame loop.
+  // the source data given to add() must stay alive until submit(), which copies it into the staging buffer.
+  // record and submit from the thread owning the transfer command pool (the main thread).
+  class UploadBatch
+  {
+  public:
+    explicit UploadBatch(Device& device);
+    ~UploadBatch(); // waits for the copies
+
+    void add(VkBuffer destination, std::span<const std::byte> data, VkDeviceSize destinationOffset = 0);
+    // the image's levels, their bufferOffset relative to data. the image goes from undefined to shader read
+    // only, so it must be fully written by them. images of both queue families are created concurrent
+    void add(VkImage destination, std::span<const std::byte> data, std::span<const VkBufferImageCopy> copies);
+    void submit();
+
+    bool isComplete() const;
+    void wait() const;
+
+    auto size() const -> VkDeviceSize { return m_size; }
+    bool empty() const { return m_regions.empty() && m_images.empty(); }
+
+    UploadBatch(const UploadBatch&) = delete;
+    UploadBatch& operator=(const UploadBatch&) = delete;
+
+  private:
+    // a multiple of every texel block size, and of the 4 bytes vkCmdCopyBufferToImage wants
+    static constexpr VkDeviceSize imageAlignment{16};
+
+    struct Region
+    {
+      VkBuffer destination;
+      std::span<const std::byte> data;
+      VkDeviceSize stagingOffset;
+      VkDeviceSize destinationOffset;
+    };
+
+    struct ImageRegion
+    {
+      VkImage destination;
+      std::span<const std::byte> data;
+      VkDeviceSize stagingOffset;
+      std::vector<VkBufferImageCopy> copies; // bufferOffset already in the staging buffer
+      VkImageSubresourceRange range;
+    };
+
+    void recordImageCopies();
+
+    Device& m_device;
+
+    std::vector<Region> m_regions;
+    std::vector<ImageRegion> m_images;
+    VkDeviceSize m_size{};
+
+    std::unique_ptr<Buffer> m_staging{};
+    VkCommandBuffer m_commandBuffer{VK_NULL_HANDLE};
+    VkFence m_fence{VK_NULL_HANDLE};
+  };
+} // namespace vke
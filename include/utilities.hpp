@@ -1,8 +1,11 @@
 #pragma once
 
 #include "core.hpp"
+#include "descriptor.hpp"
 #include "ecs.hpp"
+#include "material.hpp"
 #include "modelManager.hpp"
+#include "pipelineRegistry.hpp"
 
 //
 namespace vke
@@ -18,8 +21,15 @@ namespace vke
   struct RenderSystemContext
   {
     EventRelayer& eventRelayer;
+    PipelineRegistry& pipelineRegistry;
+    DescriptorLayoutCache& layoutCache;
+    MaterialLibrary& materials; // set 2 of the scene's shaders, see cmp::Material
     VkRenderPass renderPass;
-    VkExtent2D extent;
+    VkRenderPass depthRenderPass; // for the depth pre-pass
     VkDescriptorSetLayout globalDescriptorSetLayout;
+    VkDescriptorSetLayout lightDescriptorSetLayout; // set 1, see LightClusters
+    uint32_t framesInFlight{1}; // for per frame resources, indexed by FrameInfo::frameIndex
+    bool depthPrepass{};        // the scene's depth is drawn first, see RenderSystem::renderDepth
+    BindlessTable* bindless{};  // null when the device (or VKE_BINDLESS=0) doesn't allow it
   };
 };
@@ -19,4 +19,15 @@ namespace vke
   }
   //
   /////
+
+  // FNV-1a, for checksums and content hashes that end up on disk (std::hash isn't stable across runs)
+  inline auto fnv1a(std::span<const std::byte> data, uint64_t hash = 0xcbf29ce484222325) -> uint64_t
+  {
+    for(std::byte b : data) {
+      hash ^= static_cast<uint64_t>(b);
+      hash *= 0x100000001b3;
+    }
+
+    return hash;
+  }
 } // namespace vke
@@ -0,0 +1,27 @@
+#version 450
+
+// position only vertex shader for the depth pre-pass, of either vertex format: a vec3 position reads with
+// w = 1, compact positions are unorm16 and their dequantization is in the model matrix.
+// gl_Position is computed exactly like in shader.vert, the main pass tests its depth for equality
+
+layout(location = 0) in vec4 inPosition;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  vec4 ambientLightColor; // w is intensity
+  vec4 cameraPosition;
+} ubo;
+
+layout(push_constant) uniform Push {
+  mat4 modelMatrix;
+  mat4 normalMatrix;
+} push;
+
+invariant gl_Position;
+
+void main()
+{
+  vec4 worldVertPos = push.modelMatrix * vec4(inPosition.xyz, 1.0);
+  gl_Position = ubo.projection * ubo.view * worldVertPos;
+}
@@ -1,17 +1,9 @@
 #version 450
 
 layout(location = 0) in vec2 inFragOffset;
+layout(location = 1) in vec3 inFragColor;
 layout(location = 0) out vec4 outColor;
 
-layout(set = 0, binding = 0) uniform GlobalUbo {
-  mat4 projection;
-  mat4 view;
-  vec4 ambientLightColor; // w is intensity
-  vec3 lightPosition;
-  vec4 lightColor;
-  vec4 cameraPosition;
-} ubo;
-
 void main()
 {
   // Discards any pixels outside the point light radius to create a circle.
@@ -24,5 +16,5 @@ void main()
     discard;
   }
 
-  outColor = vec4(ubo.lightColor.xyz, 1.0);
+  outColor = vec4(inFragColor, 1.0);
 }
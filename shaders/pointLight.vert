@@ -11,26 +11,36 @@ const vec2 offsets[6] = {
 };
 
 layout(location = 0) out vec2 outFragOffset;
+layout(location = 1) out vec3 outFragColor;
 
 layout(set = 0, binding = 0) uniform GlobalUbo {
   mat4 projection;
   mat4 view;
   vec4 ambientLightColor; // w is intensity
-  vec3 lightPosition;
-  vec4 lightColor;
   vec4 cameraPosition;
 } ubo;
 
-const float LIGHT_RADIUS = 0.075;
+// one per light, see PointLightSystem::Instance
+struct Instance
+{
+  vec4 position; // w is the billboard's radius
+  vec4 color;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Instances {
+  Instance instances[];
+};
 
 void secondMethod()
 {
+  Instance light = instances[gl_InstanceIndex];
   outFragOffset = offsets[gl_VertexIndex];
+  outFragColor = light.color.xyz;
 
   // Transforms the light position to camera space, then apply the offset.
   // It is doing the same as the first method, but with xyzw instead of xy alone.
-  vec4 cameraSpaceLightPos = ubo.view * vec4(ubo.lightPosition.xyz, 1.0);
-  vec4 cameraSpaceVertPos = cameraSpaceLightPos + LIGHT_RADIUS * vec4(outFragOffset, 0.0, 0.0);
+  vec4 cameraSpaceLightPos = ubo.view * vec4(light.position.xyz, 1.0);
+  vec4 cameraSpaceVertPos = cameraSpaceLightPos + light.position.w * vec4(outFragOffset, 0.0, 0.0);
   gl_Position = ubo.projection * cameraSpaceVertPos, 1.0;
 }
 
@@ -43,16 +53,18 @@ void firstMethod()
 
   // To understand the calculation, simply remember how a matrix-vector multiplication takes each vector as a scalar to each column and adds them (It is doing that in the worldPos).
 
+  Instance light = instances[gl_InstanceIndex];
   outFragOffset = offsets[gl_VertexIndex];
+  outFragColor = light.color.xyz;
 
   vec3 cameraWorldRightDir = {ubo.view[0][0], ubo.view[1][0], ubo.view[2][0]};
   vec3 cameraWorldUpDir = {ubo.view[0][1], ubo.view[1][1], ubo.view[2][1]};
 
-  vec3 worldPos = ubo.lightPosition.xyz
-    + LIGHT_RADIUS * outFragOffset.x * cameraWorldRightDir
-    + LIGHT_RADIUS * outFragOffset.y * cameraWorldUpDir;
+  vec3 worldPos = light.position.xyz
+    + light.position.w * outFragOffset.x * cameraWorldRightDir
+    + light.position.w * outFragOffset.y * cameraWorldUpDir;
 
-  // outFragOffset.xy (that is in the -1 to 1 range) shrinks the cameraWorldDir.xy, while LIGHT_RADIUS scales it.
+  // outFragOffset.xy (that is in the -1 to 1 range) shrinks the cameraWorldDir.xy, while the radius (position.w) scales it.
 
   gl_Position = ubo.projection * ubo.view * vec4(worldPos, 1.0);
 }
@@ -0,0 +1,52 @@
+#version 450
+#extension GL_EXT_nonuniform_qualifier : require
+
+// pointLight.vert reading its instances from the bindless table (set 1, see BindlessTable), in the buffer at
+// the pushed slot
+
+const vec2 offsets[6] = {
+  vec2(-1.0, -1.0),
+  vec2(-1.0,  1.0),
+  vec2( 1.0, -1.0),
+
+  vec2( 1.0, -1.0),
+  vec2(-1.0,  1.0),
+  vec2( 1.0,  1.0)
+};
+
+layout(location = 0) out vec2 outFragOffset;
+layout(location = 1) out vec3 outFragColor;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  vec4 ambientLightColor; // w is intensity
+  vec4 cameraPosition;
+} ubo;
+
+// one per light, see PointLightSystem::Instance
+struct Instance
+{
+  vec4 position; // w is the billboard's radius
+  vec4 color;
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Instances {
+  Instance instances[];
+} buffers[];
+
+layout(push_constant) uniform Push {
+  uint instances; // the slot of the instances' buffer, the same for the whole draw
+} push;
+
+void main()
+{
+  Instance light = buffers[push.instances].instances[gl_InstanceIndex];
+  outFragOffset = offsets[gl_VertexIndex];
+  outFragColor = light.color.xyz;
+
+  // the light's position in camera space, then the offset
+  vec4 cameraSpaceLightPos = ubo.view * vec4(light.position.xyz, 1.0);
+  vec4 cameraSpaceVertPos = cameraSpaceLightPos + light.position.w * vec4(outFragOffset, 0.0, 0.0);
+  gl_Position = ubo.projection * cameraSpaceVertPos;
+}
@@ -10,21 +10,50 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   mat4 projection;
   mat4 view;
   vec4 ambientLightColor; // w is intensity
-  vec3 lightPosition;
-  vec4 lightColor;
   vec4 cameraPosition;
 } ubo;
 
+// the frame's point lights, binned into froxels on the cpu, see LightClusters
+struct Light
+{
+  vec4 position; // w is the radius
+  vec4 color;    // w is the intensity
+};
+
+layout(std430, set = 1, binding = 0) readonly buffer Lights {
+  Light lights[];
+};
+
+layout(std430, set = 1, binding = 1) readonly buffer Clusters {
+  uvec4 size;   // grid x, y, z, light count
+  vec4 slicing; // the slice of a view depth is log(z) * x + y, z and w are the extent
+  uvec2 clusters[]; // offset into the indices, count
+} grid;
+
+layout(std430, set = 1, binding = 2) readonly buffer LightIndices {
+  uint indices[];
+};
+
+// the entity's material, see MaterialLibrary
+layout(set = 2, binding = 0) uniform Material {
+  vec4 baseColor; // multiplies the vertex color
+  float specular;
+  float shininess;
+} material;
+
 layout(push_constant) uniform Push {
   mat4 modelMatrix;
   mat4 normalMatrix;
 } push;
 
-float lightAttenuation(vec3 dirToLight, in float intensity)
+// windowed to reach zero at the light's radius, past it the light isn't in the froxel's list
+float lightAttenuation(vec3 dirToLight, in float intensity, in float radius)
 {
   float attenuationValue = 1.0;
   float distanceToLight = dot(dirToLight, dirToLight);
-  return intensity / (1.0 + attenuationValue * distanceToLight);
+  float ratio = distanceToLight / (radius * radius);
+  float window = clamp(1.0 - ratio * ratio, 0.0, 1.0);
+  return intensity / (1.0 + attenuationValue * distanceToLight) * window * window;
 }
 
 float phongTerm(vec3 directionFromLight, vec3 surfaceNormal, float cosAngIncidence)
@@ -42,7 +71,7 @@ float phongTerm(vec3 directionFromLight, vec3 surfaceNormal, float cosAngInciden
 
 float blinnTerm(vec3 directionToLight, vec3 surfaceNormal, float cosAngIncidence)
 {
-  float shininessFactor = 23.0;
+  float shininessFactor = material.shininess;
   vec3 viewDirection = normalize(ubo.cameraPosition.xyz - inFragPosWorld); // direction to camera
   vec3 halfAngle = normalize(directionToLight + viewDirection);
   float blinnTerm = dot(surfaceNormal, halfAngle);
@@ -53,26 +82,42 @@ float blinnTerm(vec3 directionToLight, vec3 surfaceNormal, float cosAngIncidence
   return blinnTerm;
 }
 
+uint clusterIndex()
+{
+  float viewZ = (ubo.view * vec4(inFragPosWorld, 1.0)).z;
+  uint slice = min(uint(max(log(viewZ) * grid.slicing.x + grid.slicing.y, 0.0)), grid.size.z - 1);
+  uvec2 tile = min(uvec2(gl_FragCoord.xy / grid.slicing.zw * vec2(grid.size.xy)), grid.size.xy - 1);
+  return tile.x + grid.size.x * (tile.y + grid.size.y * slice);
+}
+
 void main()
 {
-  vec3 dirToLight = ubo.lightPosition - inFragPosWorld;
   vec3 surfaceNormal = normalize(inFragNormalWorld);
-  float cosAngIncidence = max(dot(inFragNormalWorld, normalize(dirToLight)), 0);
+  vec3 ambientLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w; // apply intensity
+  vec3 baseColor = inFragColor * material.baseColor.rgb;
+  vec3 ambientColor = baseColor * ambientLight;
 
-  float attenIntensity = lightAttenuation(dirToLight, ubo.lightColor.w);
-  float phongTerm = phongTerm(-dirToLight, surfaceNormal, cosAngIncidence);
-  float blinnTerm = blinnTerm(dirToLight, surfaceNormal, cosAngIncidence);
+  if(!gl_FrontFacing) {
+    outColor = vec4((ambientColor), 1.0);
+    return;
+  }
 
-  vec3 lightColor = vec3(ubo.lightColor);
-  vec3 diffuseLight = lightColor * attenIntensity * cosAngIncidence;
-  vec3 ambientLight = ubo.ambientLightColor.xyz * ubo.ambientLightColor.w; // apply intensity
+  vec3 diffuseColor = vec3(0.0);
+  vec3 specularColor = vec3(0.0);
 
-  vec3 diffuseColor = inFragColor * diffuseLight;
-  vec3 specularColor = vec3(1.00, 1.00, 1.00) * attenIntensity * blinnTerm;
-  vec3 ambientColor = inFragColor * ambientLight;
+  uvec2 cluster = grid.clusters[clusterIndex()];
+  for(uint i = 0; i < cluster.y; ++i) {
+    Light light = lights[indices[cluster.x + i]];
 
-  if(gl_FrontFacing)
-    outColor = vec4((diffuseColor + specularColor + ambientColor), 1.0);
-  else
-    outColor = vec4((ambientColor), 1.0);
+    vec3 dirToLight = light.position.xyz - inFragPosWorld;
+    float cosAngIncidence = max(dot(surfaceNormal, normalize(dirToLight)), 0);
+
+    float attenIntensity = lightAttenuation(dirToLight, light.color.w, light.position.w);
+    float blinnTerm = blinnTerm(normalize(dirToLight), surfaceNormal, cosAngIncidence);
+
+    diffuseColor += baseColor * light.color.rgb * attenIntensity * cosAngIncidence;
+    specularColor += light.color.rgb * attenIntensity * blinnTerm * material.specular;
+  }
+
+  outColor = vec4((diffuseColor + specularColor + ambientColor), 1.0);
 }
@@ -13,8 +13,6 @@ layout(set = 0, binding = 0) uniform GlobalUbo {
   mat4 projection;
   mat4 view;
   vec4 ambientLightColor; // w is intensity
-  vec3 lightPosition;
-  vec4 lightColor;
   vec4 cameraPosition;
 } ubo;
 
@@ -23,6 +21,9 @@ layout(push_constant) uniform Push {
   mat4 normalMatrix;
 } push;
 
+// the same as in depth.vert
+invariant gl_Position;
+
 void main()
 {
   vec4 worldVertPos = push.modelMatrix * vec4(inPosition, 1.0);
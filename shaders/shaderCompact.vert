@@ -0,0 +1,46 @@
+#version 450
+
+// shader.vert for Model::CompactVertex. positions come in [0, 1] inside the mesh bounds, the model matrix
+// already holds the dequantization
+
+layout(location = 0) in vec4 inPosition; // unorm16
+layout(location = 1) in vec4 inColor;    // unorm8
+layout(location = 2) in vec2 inNormal;   // octahedral snorm16
+layout(location = 3) in vec2 inUv;       // half
+
+layout(location = 0) out vec3 outFragColor;
+layout(location = 1) out vec3 outFragPosWorld;
+layout(location = 2) out vec3 outFragNormalWorld;
+
+layout(set = 0, binding = 0) uniform GlobalUbo {
+  mat4 projection;
+  mat4 view;
+  vec4 ambientLightColor; // w is intensity
+  vec4 cameraPosition;
+} ubo;
+
+layout(push_constant) uniform Push {
+  mat4 modelMatrix;
+  mat4 normalMatrix;
+} push;
+
+// the same as in depth.vert
+invariant gl_Position;
+
+vec3 decodeOctahedral(vec2 e)
+{
+  vec3 n = vec3(e, 1.0 - abs(e.x) - abs(e.y));
+  if(n.z < 0.0)
+    n.xy = (1.0 - abs(n.yx)) * vec2(n.x >= 0.0 ? 1.0 : -1.0, n.y >= 0.0 ? 1.0 : -1.0);
+  return normalize(n);
+}
+
+void main()
+{
+  vec4 worldVertPos = push.modelMatrix * vec4(inPosition.xyz, 1.0);
+  gl_Position = ubo.projection * ubo.view * worldVertPos;
+
+  outFragColor = inColor.rgb;
+  outFragPosWorld = worldVertPos.xyz;
+  outFragNormalWorld = normalize(mat3(push.normalMatrix) * decodeOctahedral(inNormal));
+}
@@ -45,7 +45,7 @@ namespace vke
     m_mappedMemory = nullptr;
   }
 
-  void Buffer::write(void* data, VkDeviceSize size, VkDeviceSize offset)
+  void Buffer::write(const void* data, VkDeviceSize size, VkDeviceSize offset)
   {
     assert("Writing to non-mapped memory" && m_mappedMemory);
 
@@ -59,9 +59,9 @@ namespace vke
     }
   }
 
-  void Buffer::writeByIndex(void* data, VkDeviceSize size, VkDeviceSize index)
+  void Buffer::writeByIndex(const void* data, VkDeviceSize size, VkDeviceSize index)
   {
-    write(data, m_alignmentSize * index);
+    write(data, size == VK_WHOLE_SIZE ? m_elementSize : size, m_alignmentSize * index);
   }
 
   // Flush a memory range of the buffer to make it visible to the device
@@ -73,6 +73,9 @@ namespace vke
       wh_aspectRatio = 1.0f;
     }
 
+    nearZ = near_z;
+    farZ = far_z;
+
     const float tanHalfFovY{std::tan(fovY / 2)};
     projectionMatrix = {
       {
@@ -110,6 +113,7 @@ namespace vke
     const glm::vec3 r{glm::normalize(glm::cross(f, up))}; // x (r-ight)
     const glm::vec3 u{glm::cross(f, r)};                  // y (u-p)
 
+    viewPosition = position;
     viewMatrix = {
       {
         r.x,
@@ -165,6 +169,7 @@ namespace vke
       (c1 * c2),
     };
 
+    viewPosition = position;
     viewMatrix = {
       {
         r.x,
@@ -220,6 +225,7 @@ namespace vke
       (c2 * c3),
     };
 
+    viewPosition = position;
     viewMatrix = {
       {
         r.x,
@@ -272,6 +278,7 @@ namespace vke
       (-s2),
       (c1 * c2)};
 
+    viewPosition = position;
     viewMatrix = {
       {
         r.x,
@@ -1,4 +1,5 @@
 #include "descriptor.hpp"
+#include "utils.hpp"
 
 #include <algorithm>
 #include <cassert>
@@ -17,7 +18,8 @@ namespace vke
     uint32_t binding,
     VkDescriptorType descriptorType,
     VkShaderStageFlags stageFlags,
-    uint32_t count)
+    uint32_t count,
+    VkDescriptorBindingFlags flags)
   {
     m_bindings.push_back(VkDescriptorSetLayoutBinding{
       .binding = binding,
@@ -26,23 +28,40 @@ namespace vke
       .stageFlags = stageFlags,
       .pImmutableSamplers = {},
     });
+    m_bindingFlags.push_back(flags);
 
     return *this;
   }
 
   auto DescriptorSetLayout::Builder::build() -> std::unique_ptr<DescriptorSetLayout>
   {
-    return std::make_unique<DescriptorSetLayout>(m_device, &m_bindings);
+    return std::make_unique<DescriptorSetLayout>(m_device, &m_bindings, std::move(m_bindingFlags));
   }
 
-  DescriptorSetLayout::DescriptorSetLayout(Device& device, std::vector<VkDescriptorSetLayoutBinding>* bindings) :
-      m_device{device},
-      m_bindings{std::move(*bindings)}
+  auto DescriptorSetLayout::Builder::build(DescriptorLayoutCache& cache) -> DescriptorSetLayout&
   {
-    std::sort(m_bindings.begin(), m_bindings.end(),
-      [](VkDescriptorSetLayoutBinding& a, VkDescriptorSetLayoutBinding& b) {
-        return a.binding < b.binding;
-      });
+    assert("Binding flags aren't part of the cache's key" && std::ranges::all_of(m_bindingFlags, [](VkDescriptorBindingFlags flags) { return flags == 0; }));
+
+    return cache.get(std::move(m_bindings));
+  }
+
+  DescriptorSetLayout::DescriptorSetLayout(Device& device, std::vector<VkDescriptorSetLayoutBinding>* bindings, std::vector<VkDescriptorBindingFlags> bindingFlags) :
+      m_device{device}
+  {
+    assert("One flags per binding" && (bindingFlags.empty() || bindingFlags.size() == bindings->size()));
+
+    // sorted by binding, the flags along
+    std::vector<uint32_t> order(bindings->size());
+    std::iota(order.begin(), order.end(), 0u);
+    std::sort(order.begin(), order.end(), [bindings](uint32_t a, uint32_t b) { return (*bindings)[a].binding < (*bindings)[b].binding; });
+
+    std::vector<VkDescriptorBindingFlags> flags;
+    for(uint32_t i : order) {
+      m_bindings.push_back((*bindings)[i]);
+      if(!bindingFlags.empty())
+        flags.push_back(bindingFlags[i]);
+    }
+    bindings->clear();
 
     assert(
       "Duplicate bindings" &&
@@ -51,10 +70,19 @@ namespace vke
           return a.binding == b.binding;
         }) == m_bindings.end());
 
+    VkDescriptorSetLayoutBindingFlagsCreateInfo flagsInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_BINDING_FLAGS_CREATE_INFO,
+      .bindingCount = static_cast<uint32_t>(flags.size()),
+      .pBindingFlags = flags.data(),
+    };
+
+    bool anyFlags{std::ranges::any_of(flags, [](VkDescriptorBindingFlags f) { return f != 0; })};
+    bool updateAfterBind{std::ranges::any_of(flags, [](VkDescriptorBindingFlags f) { return (f & VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT) != 0; })};
+
     VkDescriptorSetLayoutCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO,
-      .pNext = {},
-      .flags = {},
+      .pNext = anyFlags ? &flagsInfo : nullptr,
+      .flags = updateAfterBind ? VkDescriptorSetLayoutCreateFlags{VK_DESCRIPTOR_SET_LAYOUT_CREATE_UPDATE_AFTER_BIND_POOL_BIT} : VkDescriptorSetLayoutCreateFlags{},
       .bindingCount = static_cast<uint32_t>(m_bindings.size()),
       .pBindings = m_bindings.data(),
     };
@@ -67,14 +95,436 @@ namespace vke
 
   DescriptorSetLayout::~DescriptorSetLayout()
   {
+    if(m_updateTemplate)
+      m_device.descriptorUpdateTemplates().destroy(m_device, m_updateTemplate, nullptr);
+
     vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
   }
 
-//// DescriptorWriter ////
+  auto DescriptorSetLayout::updateTemplate() -> VkDescriptorUpdateTemplate
+  {
+    if(m_updateTemplateChecked)
+      return m_updateTemplate;
+
+    m_updateTemplateChecked = true;
+
+    const auto& functions{m_device.descriptorUpdateTemplates()};
+    if(!functions.create)
+      return nullptr;
+
+    std::vector<VkDescriptorUpdateTemplateEntry> entries;
+    for(const auto& binding : m_bindings) {
+      switch(binding.descriptorType) {
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER:
+      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER:
+      case VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC:
+      case VK_DESCRIPTOR_TYPE_STORAGE_BUFFER_DYNAMIC:
+      case VK_DESCRIPTOR_TYPE_SAMPLER:
+      case VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER:
+      case VK_DESCRIPTOR_TYPE_SAMPLED_IMAGE:
+      case VK_DESCRIPTOR_TYPE_STORAGE_IMAGE:
+        break;
+      default:
+        return nullptr;
+      }
+
+      if(binding.descriptorCount != 1)
+        return nullptr;
+
+      entries.push_back({
+        .dstBinding = binding.binding,
+        .dstArrayElement = 0,
+        .descriptorCount = 1,
+        .descriptorType = binding.descriptorType,
+        .offset = entries.size() * sizeof(DescriptorInfo),
+        .stride = sizeof(DescriptorInfo),
+      });
+    }
+
+    VkDescriptorUpdateTemplateCreateInfo createInfo{
+      .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_UPDATE_TEMPLATE_CREATE_INFO,
+      .descriptorUpdateEntryCount = static_cast<uint32_t>(entries.size()),
+      .pDescriptorUpdateEntries = entries.data(),
+      .templateType = VK_DESCRIPTOR_UPDATE_TEMPLATE_TYPE_DESCRIPTOR_SET,
+      .descriptorSetLayout = m_descriptorSetLayout,
+    };
+
+    if(functions.create(m_device, &createInfo, nullptr, &m_updateTemplate) != VK_SUCCESS)
+      throw std::runtime_error("Failed to create descriptor update template");
+
+    return m_updateTemplate;
+  }
+
+  //// DescriptorLayoutCache ////
+
+  DescriptorLayoutCache::DescriptorLayoutCache(Device& device) :
+      m_device{device}
+  {
+  }
+
+  auto DescriptorLayoutCache::get(std::vector<VkDescriptorSetLayoutBinding> bindings) -> DescriptorSetLayout&
+  {
+    std::sort(bindings.begin(), bindings.end(),
+      [](VkDescriptorSetLayoutBinding const& a, VkDescriptorSetLayoutBinding const& b) {
+        return a.binding < b.binding;
+      });
+
+    auto& bucket{m_layouts[hash(bindings)]};
+    for(auto& layout : bucket) {
+      if(equal(layout->m_bindings, bindings))
+        return *layout;
+    }
+
+    ++m_size;
+    return *bucket.emplace_back(std::make_unique<DescriptorSetLayout>(m_device, &bindings));
+  }
+
+  auto DescriptorLayoutCache::hash(std::span<const VkDescriptorSetLayoutBinding> bindings) -> size_t
+  {
+    size_t seed{};
+    for(const auto& binding : bindings)
+      hash_combine(&seed, binding.binding, static_cast<uint32_t>(binding.descriptorType), binding.descriptorCount, binding.stageFlags);
+
+    return seed;
+  }
+
+  bool DescriptorLayoutCache::equal(std::span<const VkDescriptorSetLayoutBinding> a, std::span<const VkDescriptorSetLayoutBinding> b)
+  {
+    return std::ranges::equal(a, b, [](VkDescriptorSetLayoutBinding const& x, VkDescriptorSetLayoutBinding const& y) {
+      return x.binding == y.binding && x.descriptorType == y.descriptorType && x.descriptorCount == y.descriptorCount &&
+             x.stageFlags == y.stageFlags && x.pImmutableSamplers == y.pImmutableSamplers;
+    });
+  }
+
+  //// DescriptorAllocator ////
+
+  DescriptorAllocator::DescriptorAllocator(Device& device, std::vector<PoolRatio> ratios, uint32_t setsPerPool) :
+      m_device{device},
+      m_ratios{std::move(ratios)},
+      m_setsPerPool{std::clamp(setsPerPool, 1u, maxSetsPerPool)}
+  {
+  }
+
+  auto DescriptorAllocator::allocate(VkDescriptorSetLayout descriptorSetLayout) -> VkDescriptorSet
+  {
+    if(m_readyPools.empty())
+      m_readyPools.push_back(takePool());
+
+    VkDescriptorSet descriptorSet{};
+    VkResult result{m_readyPools.back()->tryAllocate(&descriptorSetLayout, 1, &descriptorSet)};
+
+    // the pool is full, set it aside until reset() and retry once in a fresh one
+    if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+      m_fullPools.push_back(std::move(m_readyPools.back()));
+      m_readyPools.pop_back();
+      m_readyPools.push_back(takePool());
+
+      result = m_readyPools.back()->tryAllocate(&descriptorSetLayout, 1, &descriptorSet);
+    }
+
+    if(result != VK_SUCCESS)
+      throw std::runtime_error("Failed to allocate descriptor set");
+
+    return descriptorSet;
+  }
+
+  void DescriptorAllocator::allocate(std::span<const VkDescriptorSetLayout> descriptorSetLayouts, VkDescriptorSet* descriptorSets)
+  {
+    if(descriptorSetLayouts.empty())
+      return;
+
+    if(m_readyPools.empty())
+      m_readyPools.push_back(takePool());
+
+    auto count{static_cast<uint32_t>(descriptorSetLayouts.size())};
+    VkResult result{m_readyPools.back()->tryAllocate(descriptorSetLayouts.data(), count, descriptorSets)};
+
+    if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+      m_fullPools.push_back(std::move(m_readyPools.back()));
+      m_readyPools.pop_back();
+      m_readyPools.push_back(takePool());
+
+      result = m_readyPools.back()->tryAllocate(descriptorSetLayouts.data(), count, descriptorSets);
+    }
+
+    // more than a pool holds, one by one across as many as needed
+    if(result == VK_ERROR_OUT_OF_POOL_MEMORY || result == VK_ERROR_FRAGMENTED_POOL) {
+      for(uint32_t i{}; i < count; ++i)
+        descriptorSets[i] = allocate(descriptorSetLayouts[i]);
+      return;
+    }
+
+    if(result != VK_SUCCESS)
+      throw std::runtime_error("Failed to allocate descriptor sets");
+  }
+
+  // a recycled pool when there's one, a new one otherwise
+  auto DescriptorAllocator::takePool() -> std::unique_ptr<DescriptorPool>
+  {
+    if(!m_readyPools.empty()) {
+      auto pool{std::move(m_readyPools.back())};
+      m_readyPools.pop_back();
+      return pool;
+    }
+
+    std::vector<VkDescriptorPoolSize> poolSizes;
+    for(const auto& ratio : m_ratios)
+      poolSizes.push_back({ratio.type, static_cast<uint32_t>(std::ceil(ratio.ratio * m_setsPerPool))});
+
+    auto pool{std::make_unique<DescriptorPool>(m_device, m_setsPerPool, VkDescriptorPoolCreateFlags{}, poolSizes)};
+    m_setsPerPool = std::min(m_setsPerPool + m_setsPerPool / 2, maxSetsPerPool);
+    return pool;
+  }
+
+  void DescriptorAllocator::reset()
+  {
+    for(auto& pool : m_readyPools)
+      pool->reset();
+
+    for(auto& pool : m_fullPools) {
+      pool->reset();
+      m_readyPools.push_back(std::move(pool));
+    }
+
+    m_fullPools.clear();
+  }
+
+  //// BindlessTable ////
+
+  BindlessTable::BindlessTable(Device& device, uint32_t bufferCapacity, uint32_t imageCapacity) :
+      m_device{device}
+  {
+    if(!m_device.bindlessSupported())
+      throw std::runtime_error("Failed to create bindless table, descriptor indexing isn't supported");
+
+    // every graphics stage sees both arrays, so the per stage limits apply to each of them as well as the set's.
+    // a combined image sampler counts as a sampled image and as a sampler
+    const auto& limits{m_device.physicalInfo().descriptorIndexingProperties};
+    const uint32_t requestedBuffers{bufferCapacity};
+    const uint32_t requestedImages{imageCapacity};
+
+    bufferCapacity = std::min({bufferCapacity, limits.maxPerStageDescriptorUpdateAfterBindStorageBuffers, limits.maxDescriptorSetUpdateAfterBindStorageBuffers});
+    imageCapacity = std::min({imageCapacity,
+                              limits.maxPerStageDescriptorUpdateAfterBindSampledImages,
+                              limits.maxPerStageDescriptorUpdateAfterBindSamplers,
+                              limits.maxDescriptorSetUpdateAfterBindSampledImages,
+                              limits.maxDescriptorSetUpdateAfterBindSamplers});
+
+    // and both share the stage's resources, split in proportion when they don't fit together
+    if(uint64_t total{uint64_t{bufferCapacity} + imageCapacity}; total > limits.maxPerStageUpdateAfterBindResources) {
+      bufferCapacity = static_cast<uint32_t>(uint64_t{bufferCapacity} * limits.maxPerStageUpdateAfterBindResources / total);
+      imageCapacity = limits.maxPerStageUpdateAfterBindResources - bufferCapacity;
+    }
+
+    if(bufferCapacity != requestedBuffers || imageCapacity != requestedImages)
+      std::cerr << clr::sand << "[BindlessTable] " << clr::white << "capacities clamped to the device's limits: " << bufferCapacity << " buffers, " << imageCapacity << " images" << std::endl;
+
+    m_bufferSlots = SlotAllocator{bufferCapacity};
+    m_imageSlots = SlotAllocator{imageCapacity};
+
+    constexpr VkDescriptorBindingFlags flags{
+      VK_DESCRIPTOR_BINDING_UPDATE_AFTER_BIND_BIT | VK_DESCRIPTOR_BINDING_UPDATE_UNUSED_WHILE_PENDING_BIT | VK_DESCRIPTOR_BINDING_PARTIALLY_BOUND_BIT};
+
+    m_setLayout =
+      DescriptorSetLayout::Builder{m_device}
+        .addBinding(bufferBinding, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS, bufferCapacity, flags)
+        .addBinding(imageBinding, VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, VK_SHADER_STAGE_ALL_GRAPHICS, imageCapacity, flags)
+        .build();
+
+    m_pool =
+      DescriptorPool::Builder{m_device}
+        .setMaxDescriptorSets(1)
+        .setPoolFlags(VK_DESCRIPTOR_POOL_CREATE_UPDATE_AFTER_BIND_BIT)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, bufferCapacity)
+        .addPoolSize(VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, imageCapacity)
+        .build();
+
+    m_pool->allocate(*m_setLayout, &m_descriptorSet);
+  }
+
+  auto BindlessTable::addBuffer(const VkDescriptorBufferInfo& bufferInfo) -> uint32_t
+  {
+    uint32_t slot{m_bufferSlots.acquire()};
+    if(slot == invalidSlot)
+      throw std::runtime_error("Failed to add bindless buffer, the table is full");
+
+    setBuffer(slot, bufferInfo);
+    return slot;
+  }
+
+  auto BindlessTable::addImage(const VkDescriptorImageInfo& imageInfo) -> uint32_t
+  {
+    uint32_t slot{m_imageSlots.acquire()};
+    if(slot == invalidSlot)
+      throw std::runtime_error("Failed to add bindless image, the table is full");
+
+    setImage(slot, imageInfo);
+    return slot;
+  }
+
+  void BindlessTable::setBuffer(uint32_t slot, const VkDescriptorBufferInfo& bufferInfo)
+  {
+    auto info{bufferInfo};
+    DescriptorWriter{*m_setLayout, *m_pool}
+      .addBuffer(bufferBinding, slot, &info)
+      .update(m_descriptorSet);
+  }
+
+  void BindlessTable::setImage(uint32_t slot, const VkDescriptorImageInfo& imageInfo)
+  {
+    auto info{imageInfo};
+    DescriptorWriter{*m_setLayout, *m_pool}
+      .addImage(imageBinding, slot, &info)
+      .update(m_descriptorSet);
+  }
+
+  void BindlessTable::releaseBuffer(uint32_t slot)
+  {
+    m_bufferSlots.release(slot);
+  }
+
+  void BindlessTable::releaseImage(uint32_t slot)
+  {
+    m_imageSlots.release(slot);
+  }
+
+  //// DescriptorBatch ////
+
+  DescriptorBatch::DescriptorBatch(Device& device, bool useTemplates) :
+      m_device{device},
+      m_useTemplates{useTemplates && device.descriptorUpdateTemplates().create}
+  {
+  }
+
+  auto DescriptorBatch::add(DescriptorSetLayout& descriptorSetLayout, VkDescriptorSet* descriptorSet) -> Set
+  {
+    m_sets.push_back({&descriptorSetLayout, descriptorSet});
+    return Set{*this, static_cast<uint32_t>(m_sets.size() - 1)};
+  }
+
+  auto DescriptorBatch::Set::addBuffer(uint32_t binding, const VkDescriptorBufferInfo& bufferInfo, uint32_t arrayElement) -> Set&
+  {
+    m_batch.m_writes.push_back({.set = m_index, .binding = binding, .arrayElement = arrayElement, .info = {.buffer = bufferInfo}, .image = false});
+    return *this;
+  }
+
+  auto DescriptorBatch::Set::addImage(uint32_t binding, const VkDescriptorImageInfo& imageInfo, uint32_t arrayElement) -> Set&
+  {
+    m_batch.m_writes.push_back({.set = m_index, .binding = binding, .arrayElement = arrayElement, .info = {.image = imageInfo}, .image = true});
+    return *this;
+  }
+
+  void DescriptorBatch::flush(DescriptorPool& descriptorPool)
+  {
+    std::vector<VkDescriptorSetLayout> layouts;
+    for(const auto& set : m_sets)
+      layouts.push_back(*set.layout);
+
+    std::vector<VkDescriptorSet> descriptorSets(layouts.size());
+    if(!layouts.empty())
+      descriptorPool.allocate(layouts, &descriptorSets);
+
+    write(descriptorSets);
+  }
+
+  void DescriptorBatch::flush(DescriptorAllocator& descriptorAllocator)
+  {
+    std::vector<VkDescriptorSetLayout> layouts;
+    for(const auto& set : m_sets)
+      layouts.push_back(*set.layout);
+
+    std::vector<VkDescriptorSet> descriptorSets(layouts.size());
+    descriptorAllocator.allocate(layouts, descriptorSets.data());
+
+    write(descriptorSets);
+  }
+
+  void DescriptorBatch::write(std::span<const VkDescriptorSet> descriptorSets)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    for(size_t i{}; i < m_sets.size(); ++i)
+      *m_sets[i].result = descriptorSets[i];
+
+    // each set's writes side by side, in the order they were added
+    std::stable_sort(m_writes.begin(), m_writes.end(), [](const PendingWrite& a, const PendingWrite& b) { return a.set < b.set; });
+
+    std::unordered_map<DescriptorSetLayout*, uint32_t> layoutUses;
+    for(const auto& set : m_sets)
+      ++layoutUses[set.layout];
+
+    std::vector<VkWriteDescriptorSet> writes;
+    writes.reserve(m_writes.size());
+    std::vector<DescriptorInfo> data;
+    m_templatedSets = 0;
+
+    auto first{m_writes.begin()};
+    for(uint32_t set{}; set < m_sets.size(); ++set) {
+      auto last{std::find_if(first, m_writes.end(), [set](const PendingWrite& write) { return write.set != set; })};
+      std::span<const PendingWrite> setWrites{first, last};
+      first = last;
+
+      DescriptorSetLayout& layout{*m_sets[set].layout};
+      if(m_useTemplates && layoutUses[&layout] >= templateThreshold && layout.updateTemplate() && templateData(set, setWrites, &data)) {
+        m_device.descriptorUpdateTemplates().update(m_device, descriptorSets[set], layout.updateTemplate(), data.data());
+        ++m_templatedSets;
+        continue;
+      }
+
+      for(const auto& write : setWrites) {
+        const auto& binding{*std::ranges::find(layout.bindings(), write.binding, &VkDescriptorSetLayoutBinding::binding)};
+        writes.push_back({
+          .sType = VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET,
+          .dstSet = descriptorSets[set],
+          .dstBinding = write.binding,
+          .dstArrayElement = write.arrayElement,
+          .descriptorCount = 1,
+          .descriptorType = binding.descriptorType,
+          .pImageInfo = write.image ? &write.info.image : nullptr,
+          .pBufferInfo = write.image ? nullptr : &write.info.buffer,
+        });
+      }
+    }
+
+    if(!writes.empty())
+      vkUpdateDescriptorSets(m_device, static_cast<uint32_t>(writes.size()), writes.data(), 0, nullptr);
+
+    m_sets.clear();
+    m_writes.clear();
+  }
+
+  bool DescriptorBatch::templateData(uint32_t set, std::span<const PendingWrite> writes, std::vector<DescriptorInfo>* data) const
+  {
+    auto bindings{m_sets[set].layout->bindings()};
+    if(writes.size() != bindings.size())
+      return false;
+
+    data->resize(bindings.size());
+    std::vector<bool> written(bindings.size());
+    for(const auto& write : writes) {
+      auto binding{std::ranges::find(bindings, write.binding, &VkDescriptorSetLayoutBinding::binding)};
+      auto index{static_cast<size_t>(binding - bindings.begin())};
+      if(binding == bindings.end() || write.arrayElement != 0 || written[index])
+        return false;
+
+      written[index] = true;
+      (*data)[index] = write.info;
+    }
+
+    return true;
+  }
+
+  //// DescriptorWriter ////
 
   DescriptorWriter::DescriptorWriter(DescriptorSetLayout& descriptorSetLayout, DescriptorPool& descriptorPool) :
       m_descriptorSetLayout{descriptorSetLayout},
-      m_descriptorPool{descriptorPool}
+      m_descriptorPool{&descriptorPool}
+  {
+  }
+
+  DescriptorWriter::DescriptorWriter(DescriptorSetLayout& descriptorSetLayout, DescriptorAllocator& descriptorAllocator) :
+      m_descriptorSetLayout{descriptorSetLayout},
+      m_descriptorAllocator{&descriptorAllocator}
   {
   }
 
@@ -94,6 +544,22 @@ namespace vke
     return *this;
   }
 
+  DescriptorWriter& DescriptorWriter::addBuffer(uint32_t binding, uint32_t arrayElement, VkDescriptorBufferInfo* bufferInfo)
+  {
+    assert("Array element out of the binding" && arrayElement < m_descriptorSetLayout.m_bindings[binding].descriptorCount);
+
+    add(binding, arrayElement, nullptr, bufferInfo, nullptr);
+    return *this;
+  }
+
+  DescriptorWriter& DescriptorWriter::addImage(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo* imageInfo)
+  {
+    assert("Array element out of the binding" && arrayElement < m_descriptorSetLayout.m_bindings[binding].descriptorCount);
+
+    add(binding, arrayElement, imageInfo, nullptr, nullptr);
+    return *this;
+  }
+
   void DescriptorWriter::add(uint32_t binding, uint32_t arrayElement, VkDescriptorImageInfo* pImageInfo, VkDescriptorBufferInfo* pBufferInfo, VkBufferView* pTexelBufferView)
   {
     assert(
@@ -112,7 +578,7 @@ namespace vke
         .dstSet = nullptr, // specified in this->overwrite()
         .dstBinding = bindingDescription.binding,
         .dstArrayElement = arrayElement,
-        .descriptorCount = bindingDescription.descriptorCount,
+        .descriptorCount = 1, // one info each
         .descriptorType = bindingDescription.descriptorType,
         .pImageInfo = pImageInfo,
         .pBufferInfo = pBufferInfo,
@@ -122,7 +588,11 @@ namespace vke
 
   void DescriptorWriter::allocAndUpdate(VkDescriptorSet* descriptorSet)
   {
-    m_descriptorPool.allocate(m_descriptorSetLayout, descriptorSet);
+    if(m_descriptorAllocator)
+      *descriptorSet = m_descriptorAllocator->allocate(m_descriptorSetLayout);
+    else
+      m_descriptorPool->allocate(m_descriptorSetLayout, descriptorSet);
+
     update(*descriptorSet);
   }
 
@@ -202,6 +672,15 @@ namespace vke
   }
 
   void DescriptorPool::allocate(VkDescriptorSetLayout const* descriptorSetLayouts, uint32_t count, VkDescriptorSet* descriptors)
+  {
+    if(tryAllocate(descriptorSetLayouts, count, descriptors) != VK_SUCCESS)
+    {
+      // a DescriptorAllocator moves on to a new pool instead
+      throw std::runtime_error("Failed to allocate descriptor sets");
+    }
+  }
+
+  auto DescriptorPool::tryAllocate(VkDescriptorSetLayout const* descriptorSetLayouts, uint32_t count, VkDescriptorSet* descriptors) -> VkResult
   {
     VkDescriptorSetAllocateInfo allocateInfo{
       .sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO,
@@ -211,15 +690,7 @@ namespace vke
       .pSetLayouts = descriptorSetLayouts,
     };
 
-    if(vkAllocateDescriptorSets(m_device, &allocateInfo, descriptors) != VK_SUCCESS)
-    {
-      // TODO:
-      //  if the pool fills up it will crash.
-      //  A common solution is to create a DescriptorPoolManager: (see vkguide.dev)
-      //   . it keeps tracks of all pools objects
-      //   . and create a new pool whenever all pools are full
-      throw std::runtime_error("Failed to allocate descriptor sets");
-    }
+    return vkAllocateDescriptorSets(m_device, &allocateInfo, descriptors);
   }
 
   void DescriptorPool::free(std::vector<VkDescriptorSet>* descriptorSets)
@@ -1,4 +1,5 @@
 #include "device.hpp"
+#include "pipelineCache.hpp"
 
 namespace vke
 {
@@ -17,10 +18,12 @@ namespace vke
     choosePhysicalDevice();
     createLogicalDevice();
     createCommandPools();
+    createPipelineCache();
   }
 
   Device::~Device()
   {
+    m_pipelineCache.reset(); // saved to disk here, needs the device alive
     window.destroySurface(m_instance);
     vkDestroyCommandPool(m_device, m_commandPools.graphics, nullptr);
     vkDestroyCommandPool(m_device, m_commandPools.transfer, nullptr);
@@ -126,6 +129,18 @@ namespace vke
     if(enableValidationLayers)
       extensions.push_back(VK_EXT_DEBUG_UTILS_EXTENSION_NAME);
 
+    // optional, the device's descriptor indexing features are only known through it on vulkan 1.0
+    uint32_t count{};
+    vkEnumerateInstanceExtensionProperties(nullptr, &count, nullptr);
+    std::vector<VkExtensionProperties> available(count);
+    vkEnumerateInstanceExtensionProperties(nullptr, &count, available.data());
+
+    m_hasPhysicalDeviceProperties2 = std::ranges::any_of(available, [](const VkExtensionProperties& extension) {
+      return std::strcmp(extension.extensionName, VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME) == 0;
+    });
+    if(m_hasPhysicalDeviceProperties2)
+      extensions.push_back(VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+
     return extensions;
   }
 
@@ -233,6 +248,30 @@ namespace vke
 
     vkGetPhysicalDeviceMemoryProperties(physicalDevice, &info.memoryProperties);
     vkGetPhysicalDeviceProperties(physicalDevice, &info.deviceProperties);
+    vkGetPhysicalDeviceFeatures(physicalDevice, &info.features);
+
+    info.descriptorIndexing = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES};
+    auto getFeatures2{reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(vkGetInstanceProcAddr(m_instance, "vkGetPhysicalDeviceFeatures2KHR"))};
+    if(m_hasPhysicalDeviceProperties2 && getFeatures2 && info.hasExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+      VkPhysicalDeviceFeatures2 features{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2, .pNext = &info.descriptorIndexing};
+      getFeatures2(physicalDevice, &features);
+      info.descriptorIndexing.pNext = nullptr;
+    }
+
+    info.descriptorIndexingProperties = {.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_PROPERTIES};
+    auto getProperties2{reinterpret_cast<PFN_vkGetPhysicalDeviceProperties2KHR>(vkGetInstanceProcAddr(m_instance, "vkGetPhysicalDeviceProperties2KHR"))};
+    if(m_hasPhysicalDeviceProperties2 && getProperties2 && info.hasExtension(VK_EXT_DESCRIPTOR_INDEXING_EXTENSION_NAME)) {
+      VkPhysicalDeviceProperties2 properties{.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2, .pNext = &info.descriptorIndexingProperties};
+      getProperties2(physicalDevice, &properties);
+      info.descriptorIndexingProperties.pNext = nullptr;
+    }
+  }
+
+  bool PhysicalDeviceInfo::hasExtension(const char* name) const
+  {
+    return std::ranges::any_of(availableExtensions, [name](const VkExtensionProperties& extension) {
+      return std::strcmp(extension.extensionName, name) == 0;
+    });
   }
 
   void Device::createLogicalDevice()
@@ -252,17 +291,52 @@ namespace vke
       queueCreateInfos.push_back(createInfo);
     }
 
-    VkPhysicalDeviceFeatures features{};
+    // optional features, only enabled when the device has them
+    m_enabledFeatures.pipelineStatisticsQuery = m_physicalDeviceInfo.features.pipelineStatisticsQuery;
+    m_enabledFeatures.multiDrawIndirect = m_physicalDeviceInfo.features.multiDrawIndirect;
+    m_enabledFeatures.samplerAnisotropy = m_physicalDeviceInfo.features.samplerAnisotropy;
+    m_enabledFeatures.textureCompressionBC = m_physicalDeviceInfo.features.textureCompressionBC; // ktx2 textures, see Texture::isSupported
+
+    std::vector<const char*> extensions(m_deviceExtensions.begin(), m_deviceExtensions.end());
+
+    // bindless: only what BindlessTable needs, the indices it's read with are dynamically uniform
+    // (but not constant, so the core dynamic indexing features of both arrays are needed too)
+    const auto& features{m_physicalDeviceInfo.features};
+    const auto& indexing{m_physicalDeviceInfo.descriptorIndexing};
+    m_bindlessSupported =
+      std::ranges::all_of(m_bindlessExtensions, [this](const char* name) { return m_physicalDeviceInfo.hasExtension(name); }) &&
+      features.shaderStorageBufferArrayDynamicIndexing && features.shaderSampledImageArrayDynamicIndexing &&
+      indexing.runtimeDescriptorArray && indexing.descriptorBindingPartiallyBound && indexing.descriptorBindingUpdateUnusedWhilePending &&
+      indexing.descriptorBindingStorageBufferUpdateAfterBind && indexing.descriptorBindingSampledImageUpdateAfterBind;
+
+    if(m_bindlessSupported) {
+      extensions.insert(extensions.end(), m_bindlessExtensions.begin(), m_bindlessExtensions.end());
+      m_enabledFeatures.shaderStorageBufferArrayDynamicIndexing = VK_TRUE;
+      m_enabledFeatures.shaderSampledImageArrayDynamicIndexing = VK_TRUE;
+      m_enabledDescriptorIndexing = {
+        .sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_DESCRIPTOR_INDEXING_FEATURES,
+        .descriptorBindingSampledImageUpdateAfterBind = VK_TRUE,
+        .descriptorBindingStorageBufferUpdateAfterBind = VK_TRUE,
+        .descriptorBindingUpdateUnusedWhilePending = VK_TRUE,
+        .descriptorBindingPartiallyBound = VK_TRUE,
+        .runtimeDescriptorArray = VK_TRUE,
+      };
+    }
+
+    bool updateTemplates{m_physicalDeviceInfo.hasExtension(m_updateTemplateExtension)};
+    if(updateTemplates)
+      extensions.push_back(m_updateTemplateExtension);
 
     VkDeviceCreateInfo createInfo{};
     createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
+    createInfo.pNext = m_bindlessSupported ? &m_enabledDescriptorIndexing : nullptr;
     createInfo.queueCreateInfoCount = queueCreateInfos.size();
     createInfo.pQueueCreateInfos = queueCreateInfos.data();
     /*deprecated*/ createInfo.enabledLayerCount = m_validationLayers.size();
     /*deprecated*/ createInfo.ppEnabledLayerNames = m_validationLayers.data();
-    createInfo.enabledExtensionCount = m_deviceExtensions.size();
-    createInfo.ppEnabledExtensionNames = m_deviceExtensions.data();
-    createInfo.pEnabledFeatures = &features;
+    createInfo.enabledExtensionCount = extensions.size();
+    createInfo.ppEnabledExtensionNames = extensions.data();
+    createInfo.pEnabledFeatures = &m_enabledFeatures;
 
     if(vkCreateDevice(m_physicalDevice, &createInfo, nullptr, &m_device) != VK_SUCCESS)
       throw std::runtime_error("Failed to create logical device");
@@ -270,6 +344,17 @@ namespace vke
     vkGetDeviceQueue(m_device, m_queues.graphicsFamily, 0, &m_queues.graphics);
     vkGetDeviceQueue(m_device, m_queues.presentFamily, 0, &m_queues.present);
     vkGetDeviceQueue(m_device, m_queues.transferFamily, 0, &m_queues.transfer);
+
+    if(updateTemplates) {
+      m_descriptorUpdateTemplates = {
+        .create = reinterpret_cast<PFN_vkCreateDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(m_device, "vkCreateDescriptorUpdateTemplateKHR")),
+        .destroy = reinterpret_cast<PFN_vkDestroyDescriptorUpdateTemplateKHR>(vkGetDeviceProcAddr(m_device, "vkDestroyDescriptorUpdateTemplateKHR")),
+        .update = reinterpret_cast<PFN_vkUpdateDescriptorSetWithTemplateKHR>(vkGetDeviceProcAddr(m_device, "vkUpdateDescriptorSetWithTemplateKHR")),
+      };
+
+      if(!m_descriptorUpdateTemplates.create || !m_descriptorUpdateTemplates.destroy || !m_descriptorUpdateTemplates.update)
+        m_descriptorUpdateTemplates = {};
+    }
   }
 
   void Device::findQueueIndices()
@@ -320,6 +405,16 @@ namespace vke
     }
   }
 
+  void Device::createPipelineCache()
+  {
+    m_pipelineCache = std::make_unique<PipelineCache>(m_device, m_physicalDeviceInfo, m_rootPath / "build" / "cache");
+  }
+
+  auto Device::pipelineCache() const -> VkPipelineCache
+  {
+    return *m_pipelineCache;
+  }
+
   VkFormat Device::findSupportedFormat(std::span<VkFormat> candidates, VkImageTiling tiling, VkFormatFeatureFlags features)
   {
     for(VkFormat format : candidates) {
@@ -7,8 +7,9 @@ namespace vke::event
   {
   }
 
-  InvalidPipeline::InvalidPipeline(VkRenderPass renderPass, VkExtent2D extent) :
-      renderPass{renderPass}, extent{extent}
+  InvalidPipeline::InvalidPipeline(VkRenderPass renderPass, VkRenderPass depthRenderPass) :
+      renderPass{renderPass},
+      depthRenderPass{depthRenderPass}
   {
   }
 } // namespace vke::event
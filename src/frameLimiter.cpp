@@ -0,0 +1,44 @@
+#include "frameLimiter.hpp"
+
+namespace vke
+{
+  FrameLimiter::FrameLimiter(double targetFps)
+  {
+    setTarget(targetFps);
+  }
+
+  void FrameLimiter::setTarget(double fps)
+  {
+    m_targetFps = std::max(fps, 0.0);
+    m_frameTime = m_targetFps > 0.0 ? std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>{1.0 / m_targetFps}) : Clock::duration{};
+    m_deadline = Clock::now();
+  }
+
+  void FrameLimiter::wait()
+  {
+    VKE_PROFILE_FUNCTION();
+
+    auto now{Clock::now()};
+    if(m_frameTime == Clock::duration::zero()) {
+      m_deadline = now;
+      return;
+    }
+
+    m_deadline += m_frameTime;
+    if(m_deadline + m_frameTime < now) {
+      m_deadline = now;
+      return;
+    }
+
+    auto wake{m_deadline - m_spinMargin};
+    if(wake > now) {
+      std::this_thread::sleep_until(wake);
+
+      auto overshoot{Clock::now() - wake};
+      m_spinMargin = std::clamp(std::max(overshoot + minSpinMargin, m_spinMargin * 15 / 16), minSpinMargin, maxSpinMargin);
+    }
+
+    while(Clock::now() < m_deadline)
+      std::this_thread::yield();
+  }
+} // namespace vke
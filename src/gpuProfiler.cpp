@@ -0,0 +1,206 @@
+#include "gpuProfiler.hpp"
+
+namespace vke
+{
+  GpuProfiler::GpuProfiler(Device& device, uint32_t framesInFlight) :
+    m_device{device},
+    m_frames(framesInFlight)
+  {
+    const auto& info{m_device.physicalInfo()};
+    uint32_t validBits{info.queueFamilyProperties[static_cast<uint32_t>(m_device.queues().graphicsFamily)].timestampValidBits};
+
+    m_enabled = validBits != 0 && info.deviceProperties.limits.timestampPeriod > 0.f;
+    if(!m_enabled)
+      return;
+
+    m_timestampPeriod = info.deviceProperties.limits.timestampPeriod;
+    m_timestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+    VkQueryPoolCreateInfo timestampInfo{
+      .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .queryType = VK_QUERY_TYPE_TIMESTAMP,
+      .queryCount = maxScopes * 2,
+    };
+
+    m_timestampPools.resize(framesInFlight);
+    for(auto& pool : m_timestampPools) {
+      if(vkCreateQueryPool(m_device, &timestampInfo, nullptr, &pool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create timestamp query pool");
+    }
+
+    if(!m_device.enabledFeatures().pipelineStatisticsQuery)
+      return;
+
+    // the order of the bits is the order of the results (Statistic)
+    VkQueryPoolCreateInfo statisticsInfo{
+      .sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO,
+      .queryType = VK_QUERY_TYPE_PIPELINE_STATISTICS,
+      .queryCount = maxScopes,
+      .pipelineStatistics = VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_VERTICES_BIT |
+                            VK_QUERY_PIPELINE_STATISTIC_INPUT_ASSEMBLY_PRIMITIVES_BIT |
+                            VK_QUERY_PIPELINE_STATISTIC_VERTEX_SHADER_INVOCATIONS_BIT |
+                            VK_QUERY_PIPELINE_STATISTIC_CLIPPING_PRIMITIVES_BIT |
+                            VK_QUERY_PIPELINE_STATISTIC_FRAGMENT_SHADER_INVOCATIONS_BIT,
+    };
+
+    m_statisticsPools.resize(framesInFlight);
+    for(auto& pool : m_statisticsPools) {
+      if(vkCreateQueryPool(m_device, &statisticsInfo, nullptr, &pool) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create pipeline statistics query pool");
+    }
+  }
+
+  GpuProfiler::~GpuProfiler()
+  {
+    for(auto& pool : m_timestampPools)
+      vkDestroyQueryPool(m_device, pool, nullptr);
+
+    for(auto& pool : m_statisticsPools)
+      vkDestroyQueryPool(m_device, pool, nullptr);
+  }
+
+  void GpuProfiler::beginFrame(VkCommandBuffer commandBuffer, uint32_t frameIndex)
+  {
+    if(!m_enabled)
+      return;
+
+    m_frameIndex = frameIndex;
+    collect(frameIndex);
+
+    vkCmdResetQueryPool(commandBuffer, m_timestampPools[frameIndex], 0, maxScopes * 2);
+    if(hasStatistics())
+      vkCmdResetQueryPool(commandBuffer, m_statisticsPools[frameIndex], 0, maxScopes);
+  }
+
+  auto GpuProfiler::beginScope(VkCommandBuffer commandBuffer, const char* name, bool withStatistics) -> uint32_t
+  {
+    auto& scopes{m_frames[m_frameIndex].scopes};
+    if(!m_enabled || scopes.size() == maxScopes)
+      return maxScopes;
+
+    uint32_t scope = scopes.size();
+
+    // statistics queries of the same type can't be nested, only the outermost scope gets them
+    withStatistics = withStatistics && hasStatistics() && !m_statisticsActive;
+    scopes.push_back({name, withStatistics});
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_timestampPools[m_frameIndex], scope * 2);
+
+    if(withStatistics) {
+      vkCmdBeginQuery(commandBuffer, m_statisticsPools[m_frameIndex], scope, 0);
+      m_statisticsActive = true;
+    }
+
+    return scope;
+  }
+
+  void GpuProfiler::endScope(VkCommandBuffer commandBuffer, uint32_t scope)
+  {
+    if(scope >= maxScopes)
+      return;
+
+    if(m_frames[m_frameIndex].scopes[scope].hasStatistics) {
+      vkCmdEndQuery(commandBuffer, m_statisticsPools[m_frameIndex], scope);
+      m_statisticsActive = false;
+    }
+
+    vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_timestampPools[m_frameIndex], scope * 2 + 1);
+  }
+
+  // the frame's fence has been waited when this runs, so the results should be there; WITH_AVAILABILITY
+  // is used anyway (no WAIT bit) so a late query is skipped instead of stalling the cpu.
+  void GpuProfiler::collect(uint32_t frameIndex)
+  {
+    auto& scopes{m_frames[frameIndex].scopes};
+    if(scopes.empty())
+      return;
+
+    uint32_t scopeCount = scopes.size();
+
+    // [value, availability] per query
+    std::array<uint64_t, maxScopes * 2 * 2> timestamps{};
+    vkGetQueryPoolResults(
+      m_device, m_timestampPools[frameIndex],
+      0, scopeCount * 2,
+      sizeof(timestamps), timestamps.data(), sizeof(uint64_t) * 2,
+      VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+
+    // [statistics..., availability] per query
+    constexpr uint32_t statisticsStride{statisticCount + 1};
+    std::array<uint64_t, maxScopes * statisticsStride> statistics{};
+    if(hasStatistics()) {
+      vkGetQueryPoolResults(
+        m_device, m_statisticsPools[frameIndex],
+        0, scopeCount,
+        sizeof(statistics), statistics.data(), sizeof(uint64_t) * statisticsStride,
+        VK_QUERY_RESULT_64_BIT | VK_QUERY_RESULT_WITH_AVAILABILITY_BIT);
+    }
+
+    for(uint32_t i{}; i < scopeCount; ++i) {
+      uint64_t begin{timestamps[i * 4]};
+      uint64_t end{timestamps[i * 4 + 2]};
+      bool available{timestamps[i * 4 + 1] && timestamps[i * 4 + 3]};
+
+      if(!available)
+        continue;
+
+      double ms{static_cast<double>((end - begin) & m_timestampMask) * m_timestampPeriod / 1'000'000.0};
+
+      const uint64_t* scopeStatistics{&statistics[i * statisticsStride]};
+      bool hasScopeStatistics{scopes[i].hasStatistics && scopeStatistics[statisticCount]};
+
+      record(scopes[i].name, ms, hasScopeStatistics ? scopeStatistics : nullptr);
+    }
+
+    scopes.clear();
+  }
+
+  void GpuProfiler::record(const char* name, double ms, const uint64_t* statistics)
+  {
+    auto it{std::find_if(m_timings.begin(), m_timings.end(), [name](const Timing& timing) {
+      return timing.name == name || std::strcmp(timing.name, name) == 0;
+    })};
+
+    if(it == m_timings.end()) {
+      m_timings.push_back({.name = name});
+      m_history.emplace_back();
+      it = std::prev(m_timings.end());
+    }
+
+    History& history{m_history[std::distance(m_timings.begin(), it)]};
+    history.samples[history.next] = ms;
+    history.next = (history.next + 1) % historySize;
+    history.count = std::min(history.count + 1, historySize);
+
+    it->lastMs = ms;
+    it->averageMs = std::accumulate(history.samples.begin(), history.samples.begin() + history.count, 0.0) / history.count;
+
+    if(statistics)
+      std::copy_n(statistics, statisticCount, it->statistics.begin());
+  }
+
+  void GpuProfiler::report(std::ostream& out) const
+  {
+    if(!m_enabled) {
+      out << "[GPU] timestamps are not supported on the graphics queue\n";
+      return;
+    }
+
+    out << "[GPU] average of the last " << historySize << " frames\n";
+    for(const auto& timing : m_timings) {
+      out << "  " << std::left << std::setw(24) << timing.name
+          << std::right << std::fixed << std::setprecision(3) << std::setw(9) << timing.averageMs << " ms"
+          << std::setw(9) << timing.lastMs << " ms (last)";
+
+      if(hasStatistics()) {
+        out << "  vertices " << timing.statistics[inputVertices]
+            << ", primitives " << timing.statistics[inputPrimitives]
+            << ", vs " << timing.statistics[vertexInvocations]
+            << ", clipped " << timing.statistics[clippingPrimitives]
+            << ", fs " << timing.statistics[fragmentInvocations];
+      }
+
+      out << '\n';
+    }
+  }
+} // namespace vke
@@ -66,4 +66,12 @@ namespace vke
       transform.translation += m_moveSpeed * static_cast<float>(ts.count()) * glm::normalize(moveDir);
     }
   }
+
+  bool KeyboardInput::presentModeCycled()
+  {
+    bool down{glfwGetKey(m_window, m_keys.cyclePresentMode) == GLFW_PRESS};
+    bool pressed{down && !m_presentModeKeyDown};
+    m_presentModeKeyDown = down;
+    return pressed;
+  }
 }; // namespace vke
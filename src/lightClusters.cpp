@@ -0,0 +1,206 @@
+#include "lightClusters.hpp"
+
+namespace vke
+{
+  namespace
+  {
+    auto slice(float depth, float near, float far) -> uint32_t
+    {
+      float k{std::log(std::max(depth, near) / near) * LightClusters::gridZ / std::log(far / near)};
+      return std::min(static_cast<uint32_t>(k), LightClusters::gridZ - 1);
+    }
+
+    // the tiles covering [min, max] in ndc, none when it's off screen
+    auto tiles(float min, float max, uint32_t count) -> std::optional<std::pair<uint32_t, uint32_t>>
+    {
+      if(max < -1.f || min > 1.f)
+        return std::nullopt;
+
+      auto tile = [count](float ndc) { return std::min(static_cast<uint32_t>(std::max((ndc * 0.5f + 0.5f) * count, 0.f)), count - 1); };
+      return std::pair{tile(min), tile(max)};
+    }
+
+    // calls visit with every froxel the sphere may reach into. per slice, the sphere's widest cross section
+    // inside it is a disc whose square projects between the slice's near and far depths
+    template<typename Visit>
+    void forEachCluster(const glm::vec3& center, float radius, const glm::mat4& projection, std::span<const float> depths, Visit&& visit)
+    {
+      float near{depths.front()};
+      float far{depths.back()};
+      if(center.z + radius <= near || center.z - radius >= far)
+        return;
+
+      uint32_t first{slice(center.z - radius, near, far)};
+      uint32_t last{slice(center.z + radius, near, far)};
+
+      for(uint32_t k{first}; k <= last; ++k) {
+        float sliceNear{depths[k]};
+        float sliceFar{depths[k + 1]};
+        float dz{center.z < sliceNear ? sliceNear - center.z : center.z > sliceFar ? center.z - sliceFar : 0.f};
+        if(dz >= radius)
+          continue;
+
+        float r{std::sqrt(radius * radius - dz * dz)};
+
+        auto range = [&](float c, float scale, uint32_t count) {
+          std::array ndc{(c - r) / sliceNear, (c - r) / sliceFar, (c + r) / sliceNear, (c + r) / sliceFar};
+          auto [min, max]{std::ranges::minmax(ndc)};
+          return scale > 0.f ? tiles(min * scale, max * scale, count) : tiles(max * scale, min * scale, count);
+        };
+
+        auto x{range(center.x, projection[0][0], LightClusters::gridX)};
+        auto y{range(center.y, projection[1][1], LightClusters::gridY)};
+        if(!x || !y)
+          continue;
+
+        for(uint32_t j{y->first}; j <= y->second; ++j) {
+          for(uint32_t i{x->first}; i <= x->second; ++i)
+            visit(i + LightClusters::gridX * (j + LightClusters::gridY * k));
+        }
+      }
+    }
+  } // namespace
+
+  LightClusters::LightClusters(Device& device, DescriptorLayoutCache& layoutCache, uint32_t framesInFlight) :
+    m_device{device},
+    m_setLayout{
+      DescriptorSetLayout::Builder{device}
+        .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .addBinding(1, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .addBinding(2, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .build(layoutCache)}
+  {
+    m_frames.resize(std::max(framesInFlight, 1u));
+    for(Frame& frame : m_frames)
+      createBuffers(frame, initialLights, initialIndices);
+  }
+
+  void LightClusters::createBuffers(Frame& frame, uint32_t lightCapacity, uint32_t indexCapacity)
+  {
+    if(!frame.lights || frame.lights->elementCount() < lightCapacity) {
+      frame.lights = std::make_unique<Buffer>(m_device, lightCapacity, sizeof(Light), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+      frame.lights->mapMemory();
+    }
+
+    if(!frame.clusters) {
+      frame.clusters = std::make_unique<Buffer>(m_device, 1, sizeof(Grid) + sizeof(Cluster) * clusterCount, VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+      frame.clusters->mapMemory();
+    }
+
+    if(!frame.indices || frame.indices->elementCount() < indexCapacity) {
+      frame.indices = std::make_unique<Buffer>(m_device, indexCapacity, sizeof(uint32_t), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+      frame.indices->mapMemory();
+    }
+  }
+
+  auto LightClusters::update(const FrameInfo& info) -> VkDescriptorSet
+  {
+    VKE_PROFILE_FUNCTION();
+
+    m_lights.clear();
+    for(EntityID entity : info.lights) {
+      const auto& light{info.ecs.getComponent<cmp::PointLight>(entity)};
+      m_lights.push_back({
+        .position = {light.position, light.radius},
+        .color = {light.color, light.intensity},
+      });
+    }
+
+    const Camera& camera{info.camera};
+    assign(m_lights, camera.view(), camera.projection(), camera.nearPlane(), camera.farPlane(), &m_clusters, &m_indices);
+
+    // the frame's fence was waited on, its buffers are free to be rewritten or replaced
+    Frame& frame{m_frames[info.frameIndex % m_frames.size()]};
+    auto lightCapacity{std::max<uint32_t>(frame.lights->elementCount(), std::bit_ceil(static_cast<uint32_t>(m_lights.size())))};
+    auto indexCapacity{std::max<uint32_t>(frame.indices->elementCount(), std::bit_ceil(static_cast<uint32_t>(m_indices.size())))};
+    if(lightCapacity > frame.lights->elementCount() || indexCapacity > frame.indices->elementCount())
+      createBuffers(frame, lightCapacity, indexCapacity);
+
+    float logRatio{std::log(camera.farPlane() / camera.nearPlane())};
+    Grid grid{
+      .size = {gridX, gridY, gridZ, static_cast<uint32_t>(m_lights.size())},
+      .slicing = {
+        gridZ / logRatio,
+        -(gridZ * std::log(camera.nearPlane())) / logRatio,
+        static_cast<float>(info.extent.width),
+        static_cast<float>(info.extent.height),
+      },
+    };
+
+    frame.clusters->write(&grid, sizeof(Grid));
+    frame.clusters->write(m_clusters.data(), sizeof(Cluster) * clusterCount, sizeof(Grid));
+    frame.clusters->flush();
+
+    if(!m_lights.empty()) {
+      frame.lights->write(m_lights.data(), sizeof(Light) * m_lights.size());
+      frame.lights->flush();
+    }
+
+    if(!m_indices.empty()) {
+      frame.indices->write(m_indices.data(), sizeof(uint32_t) * m_indices.size());
+      frame.indices->flush();
+    }
+
+    auto lightsInfo{frame.lights->descriptorInfo()};
+    auto clustersInfo{frame.clusters->descriptorInfo()};
+    auto indicesInfo{frame.indices->descriptorInfo()};
+
+    VkDescriptorSet descriptorSet{};
+    DescriptorWriter{m_setLayout, info.descriptors}
+      .addBuffer(0, &lightsInfo)
+      .addBuffer(1, &clustersInfo)
+      .addBuffer(2, &indicesInfo)
+      .allocAndUpdate(&descriptorSet);
+
+    return descriptorSet;
+  }
+
+  // a counting sort: the froxels' light counts first, their offsets from those, then the indices
+  void LightClusters::assign(
+    std::span<const Light> lights,
+    const glm::mat4& view,
+    const glm::mat4& projection,
+    float near,
+    float far,
+    std::vector<Cluster>* clusters,
+    std::vector<uint32_t>* indices)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    std::array<float, gridZ + 1> depths;
+    for(uint32_t k{}; k <= gridZ; ++k)
+      depths[k] = near * std::pow(far / near, static_cast<float>(k) / gridZ);
+
+    std::vector<glm::vec3> centers(lights.size());
+    for(size_t i{}; i < lights.size(); ++i)
+      centers[i] = glm::vec3{view * glm::vec4{glm::vec3{lights[i].position}, 1.f}};
+
+    clusters->assign(clusterCount, {});
+    for(size_t i{}; i < lights.size(); ++i)
+      forEachCluster(centers[i], lights[i].position.w, projection, depths, [&](uint32_t cluster) { ++(*clusters)[cluster].count; });
+
+    uint32_t offset{};
+    for(Cluster& cluster : *clusters) {
+      cluster.offset = offset;
+      offset += cluster.count;
+      cluster.count = 0;
+    }
+
+    indices->resize(offset);
+    for(size_t i{}; i < lights.size(); ++i) {
+      forEachCluster(centers[i], lights[i].position.w, projection, depths, [&](uint32_t cluster) {
+        Cluster& range{(*clusters)[cluster]};
+        (*indices)[range.offset + range.count++] = static_cast<uint32_t>(i);
+      });
+    }
+  }
+
+  auto LightClusters::clusterIndex(const glm::vec3& viewPosition, const glm::mat4& projection, float near, float far) -> uint32_t
+  {
+    glm::vec4 clip{projection * glm::vec4{viewPosition, 1.f}};
+    glm::vec2 ndc{glm::vec2{clip.x, clip.y} / clip.w};
+
+    auto tile = [](float ndc, uint32_t count) { return std::min(static_cast<uint32_t>(std::max((ndc * 0.5f + 0.5f) * count, 0.f)), count - 1); };
+    return tile(ndc.x, gridX) + gridX * (tile(ndc.y, gridY) + gridY * slice(viewPosition.z, near, far));
+  }
+} // namespace vke
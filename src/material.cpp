@@ -0,0 +1,57 @@
+#include "material.hpp"
+
+namespace vke
+{
+  MaterialLibrary::MaterialLibrary(Device& device, DescriptorLayoutCache& layoutCache, DescriptorAllocator& descriptors) :
+    m_device{device},
+    m_setLayout{
+      DescriptorSetLayout::Builder{device}
+        .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_FRAGMENT_BIT)
+        .build(layoutCache)},
+    m_descriptors{descriptors}
+  {
+    create("default", {});
+  }
+
+  auto MaterialLibrary::create(std::string name, const Parameters& parameters) -> uint32_t
+  {
+    if(m_materials.size() >= maxMaterials)
+      throw std::runtime_error("Failed to create material " + name + ", too many materials");
+
+    m_materials.push_back({.name = std::move(name), .parameters = parameters});
+    return static_cast<uint32_t>(m_materials.size() - 1);
+  }
+
+  void MaterialLibrary::upload()
+  {
+    VKE_PROFILE_FUNCTION();
+
+    auto pending{static_cast<uint32_t>(m_materials.size()) - m_uploaded};
+    if(!pending)
+      return;
+
+    auto& limits{m_device.physicalInfo().deviceProperties.limits};
+    auto& buffer{m_buffers.emplace_back(std::make_unique<Buffer>(
+      m_device,
+      pending,
+      sizeof(Parameters),
+      VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT,
+      0,
+      std::lcm(limits.minUniformBufferOffsetAlignment, limits.nonCoherentAtomSize)))};
+
+    buffer->mapMemory();
+
+    DescriptorBatch batch{m_device};
+    for(uint32_t i{}; i < pending; ++i) {
+      Material& material{m_materials[m_uploaded + i]};
+      buffer->writeByIndex(&material.parameters, sizeof(Parameters), i);
+      batch.add(m_setLayout, &material.descriptorSet).addBuffer(0, buffer->descriptorInfoByIndex(i));
+    }
+
+    buffer->flush();
+    batch.flush(m_descriptors);
+
+    m_uploaded += pending;
+  }
+} // namespace vke
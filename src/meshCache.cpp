@@ -0,0 +1,200 @@
+#include "meshCache.hpp"
+#include "utils.hpp"
+
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace vke
+{
+#ifndef _WIN32
+  MappedFile::MappedFile(const std::filesystem::path& path)
+  {
+    int fd{open(path.c_str(), O_RDONLY)};
+    if(fd < 0)
+      throw std::runtime_error("Failed to open file: " + path.string());
+
+    struct stat status{};
+    if(fstat(fd, &status) != 0) {
+      close(fd);
+      throw std::runtime_error("Failed to stat file: " + path.string());
+    }
+
+    m_size = static_cast<size_t>(status.st_size);
+    if(m_size) {
+      void* data{mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0)};
+      if(data == MAP_FAILED) {
+        close(fd);
+        throw std::runtime_error("Failed to map file: " + path.string());
+      }
+
+      // the whole file is about to be copied, start paging it in now
+      madvise(data, m_size, MADV_WILLNEED);
+      m_data = static_cast<const std::byte*>(data);
+    }
+
+    close(fd); // the mapping keeps its own reference
+  }
+
+  MappedFile::~MappedFile()
+  {
+    if(m_data)
+      munmap(const_cast<std::byte*>(m_data), m_size);
+  }
+#else
+  MappedFile::MappedFile(const std::filesystem::path& path)
+  {
+    std::ifstream file{path, std::ios::binary | std::ios::ate};
+    if(!file.is_open())
+      throw std::runtime_error("Failed to open file: " + path.string());
+
+    m_buffer.resize(file.tellg());
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(m_buffer.data()), m_buffer.size());
+
+    m_data = m_buffer.data();
+    m_size = m_buffer.size();
+  }
+
+  MappedFile::~MappedFile()
+  {
+  }
+#endif
+
+  auto MeshCache::cachePath(const std::filesystem::path& source) -> std::filesystem::path
+  {
+    auto path{source};
+    path += ".vkmesh";
+    return path;
+  }
+
+  auto MeshCache::sourceTime(const std::filesystem::path& source) -> int64_t
+  {
+    return static_cast<int64_t>(std::filesystem::last_write_time(source).time_since_epoch().count());
+  }
+
+  auto MeshCache::sourceHash(const std::filesystem::path& source) -> uint64_t
+  {
+    MappedFile file{source};
+    return fnv1a(file.bytes());
+  }
+
+  bool MeshCache::load(const std::filesystem::path& source, Model::Builder* builder)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    std::error_code error;
+    auto path{cachePath(source)};
+    if(!std::filesystem::exists(path, error))
+      return false;
+
+    // an unreadable cache is only a missed one, the source gets imported again
+    std::shared_ptr<MappedFile> file;
+    try {
+      file = std::make_shared<MappedFile>(path);
+    } catch(const std::exception& e) {
+      std::cerr << clr::sand << "[MeshCache] " << clr::white << e.what() << std::endl;
+      return false;
+    }
+
+    auto bytes{file->bytes()};
+    if(bytes.size() < sizeof(Header))
+      return false;
+
+    Header header{};
+    std::memcpy(&header, bytes.data(), sizeof(header));
+
+    size_t vertexBytes{size_t{header.vertexCount} * sizeof(Model::Vertex)};
+    size_t indexBytes{size_t{header.indexCount} * sizeof(uint32_t)};
+    size_t lodBytes{size_t{header.lodCount} * sizeof(Model::Lod)};
+    size_t meshletBytes{size_t{header.meshletCount} * sizeof(Model::Meshlet)};
+
+    if(std::memcmp(header.magic, Header{}.magic, sizeof(header.magic)) != 0 ||
+       header.version != Header{}.version ||
+       header.vertexSize != sizeof(Model::Vertex) ||
+       header.sourceSize != std::filesystem::file_size(source, error) ||
+       header.sourceTime != sourceTime(source) ||
+       bytes.size() != sizeof(Header) + vertexBytes + indexBytes + lodBytes + meshletBytes) {
+      return false;
+    }
+
+    // the cheap checks passed, now the contents: the source's against the one it was imported from, and the
+    // streams against what was written
+    auto vertexData{bytes.data() + sizeof(Header)};
+    auto indexData{vertexData + vertexBytes};
+    auto lodData{indexData + indexBytes};
+    auto meshletData{lodData + lodBytes};
+
+    try {
+      if(header.sourceHash != sourceHash(source))
+        return false;
+    } catch(const std::exception& e) {
+      std::cerr << clr::sand << "[MeshCache] " << clr::white << e.what() << std::endl;
+      return false;
+    }
+
+    if(header.contentHash != fnv1a({indexData, indexBytes}, fnv1a({vertexData, vertexBytes})))
+      return false;
+
+    builder->vertices.clear();
+    builder->indices.clear();
+    builder->boundsMin = header.boundsMin;
+    builder->boundsMax = header.boundsMax;
+    builder->contentHash = header.contentHash;
+    auto lods{reinterpret_cast<const Model::Lod*>(lodData)};
+    builder->lods.assign(lods, lods + header.lodCount);
+    auto meshlets{reinterpret_cast<const Model::Meshlet*>(meshletData)};
+    builder->meshlets.assign(meshlets, meshlets + header.meshletCount);
+    builder->m_mappedVertices = {reinterpret_cast<const Model::Vertex*>(vertexData), header.vertexCount};
+    builder->m_mappedIndices = {reinterpret_cast<const uint32_t*>(indexData), header.indexCount};
+    builder->m_mapping = std::move(file);
+
+    return true;
+  }
+
+  void MeshCache::store(const std::filesystem::path& source, const Model::Builder& builder)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    auto vertices{builder.vertexData()};
+    auto indices{builder.indexData()};
+
+    Header header{
+      .sourceSize = std::filesystem::file_size(source),
+      .sourceTime = sourceTime(source),
+      .sourceHash = sourceHash(source),
+      .contentHash = builder.contentHash,
+      .vertexCount = static_cast<uint32_t>(vertices.size()),
+      .indexCount = static_cast<uint32_t>(indices.size()),
+      .lodCount = static_cast<uint32_t>(builder.lods.size()),
+      .boundsMin = builder.boundsMin,
+      .boundsMax = builder.boundsMax,
+      .meshletCount = static_cast<uint32_t>(builder.meshlets.size()),
+    };
+
+    // same as the pipeline cache, never leave a half written file behind.
+    // the name is per thread, two loaders may import the same file at once
+    auto path{cachePath(source)};
+    auto temporary{path};
+    temporary += ".tmp" + std::to_string(std::hash<std::thread::id>{}(std::this_thread::get_id()));
+    {
+      std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+      if(!file.is_open())
+        throw std::runtime_error("Failed to write mesh cache: " + temporary.string());
+
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(reinterpret_cast<const char*>(vertices.data()), vertices.size_bytes());
+      file.write(reinterpret_cast<const char*>(indices.data()), indices.size_bytes());
+      file.write(reinterpret_cast<const char*>(builder.lods.data()), builder.lods.size() * sizeof(Model::Lod));
+      file.write(reinterpret_cast<const char*>(builder.meshlets.data()), builder.meshlets.size() * sizeof(Model::Meshlet));
+
+      if(!file)
+        throw std::runtime_error("Failed to write mesh cache: " + temporary.string());
+    }
+
+    std::filesystem::rename(temporary, path);
+  }
+} // namespace vke
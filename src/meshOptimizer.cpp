@@ -0,0 +1,321 @@
+#include "meshOptimizer.hpp"
+
+namespace vke
+{
+  auto MeshOptimizer::optimize(Model::Builder* builder, const Options& options) -> Report
+  {
+    VKE_PROFILE_FUNCTION();
+
+    assert(builder->format == Model::VertexFormat::standard && builder->layout == Model::VertexLayout::interleaved && "Optimize before compact() and splitStreams()");
+
+    builder->ownData();
+
+    auto vertexCount{static_cast<uint32_t>(builder->vertices.size())};
+    std::span<uint32_t> indices{builder->indices};
+
+    Report report{};
+    if(indices.empty())
+      return report;
+
+    assert(indices.size() % 3 == 0 && "Not a triangle list");
+
+    report.acmrBefore = acmr(indices, vertexCount);
+    report.atvrBefore = atvr(indices, vertexCount);
+
+    std::vector<uint32_t> hardBoundaries;
+    if(options.vertexCache)
+      optimizeVertexCache(indices, vertexCount, &hardBoundaries);
+
+    // the clusters only make sense on top of a cache friendly order
+    if(options.overdraw && options.vertexCache)
+      optimizeOverdraw(indices, builder->vertices, options.overdrawThreshold, hardBoundaries);
+
+    if(options.vertexFetch)
+      optimizeVertexFetch(builder);
+
+    vertexCount = static_cast<uint32_t>(builder->vertices.size());
+    report.acmrAfter = acmr(builder->indices, vertexCount);
+    report.atvrAfter = atvr(builder->indices, vertexCount);
+
+    if(builder->contentHash)
+      builder->computeContentHash();
+
+    return report;
+  }
+
+  void MeshOptimizer::optimizeVertexCache(std::span<uint32_t> indices, uint32_t vertexCount, std::vector<uint32_t>* hardBoundaries)
+  {
+    auto triangleCount{static_cast<uint32_t>(indices.size() / 3)};
+
+    // vertex -> triangles, as offsets into one array
+    std::vector<uint32_t> live(vertexCount);
+    for(uint32_t index : indices)
+      ++live[index];
+
+    std::vector<uint32_t> offsets(vertexCount + 1);
+    for(uint32_t v{}; v < vertexCount; ++v)
+      offsets[v + 1] = offsets[v] + live[v];
+
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+      std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+      for(uint32_t i{}; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<uint32_t> cacheTime(vertexCount);
+    std::vector<bool> emitted(triangleCount);
+    std::vector<uint32_t> deadEnd; // recently used vertices, where to continue when the fan runs dry
+    std::vector<uint32_t> candidates;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    uint32_t time{cacheSize + 1};
+    uint32_t cursor{}; // last resort, the next vertex in input order with triangles left
+
+    auto skipDeadEnd = [&]() -> int64_t {
+      while(!deadEnd.empty()) {
+        uint32_t v{deadEnd.back()};
+        deadEnd.pop_back();
+        if(live[v] > 0)
+          return v;
+      }
+
+      for(; cursor < vertexCount; ++cursor) {
+        if(live[cursor] > 0)
+          return cursor;
+      }
+
+      return -1;
+    };
+
+    if(hardBoundaries)
+      hardBoundaries->assign(1, 0);
+
+    int64_t fanning{vertexCount > 0 ? skipDeadEnd() : -1};
+    while(fanning >= 0) {
+      candidates.clear();
+
+      for(uint32_t i{offsets[fanning]}; i < offsets[fanning + 1]; ++i) {
+        uint32_t triangle{adjacency[i]};
+        if(emitted[triangle])
+          continue;
+
+        emitted[triangle] = true;
+        for(uint32_t corner{}; corner < 3; ++corner) {
+          uint32_t v{indices[triangle * 3 + corner]};
+          output.push_back(v);
+          deadEnd.push_back(v);
+          candidates.push_back(v);
+          --live[v];
+
+          if(time - cacheTime[v] > cacheSize)
+            cacheTime[v] = time++;
+        }
+      }
+
+      // the candidate that is still in the cache after its remaining triangles are emitted, the oldest of those
+      int64_t next{-1};
+      int64_t bestPriority{-1};
+      for(uint32_t v : candidates) {
+        if(live[v] == 0)
+          continue;
+
+        int64_t priority{};
+        if(time - cacheTime[v] + 2 * live[v] <= cacheSize)
+          priority = time - cacheTime[v];
+
+        if(priority > bestPriority) {
+          bestPriority = priority;
+          next = v;
+        }
+      }
+
+      if(next < 0) {
+        next = skipDeadEnd();
+        if(hardBoundaries && next >= 0)
+          hardBoundaries->push_back(static_cast<uint32_t>(output.size() / 3));
+      }
+
+      fanning = next;
+    }
+
+    assert(output.size() == indices.size());
+    std::ranges::copy(output, indices.begin());
+  }
+
+  void MeshOptimizer::optimizeOverdraw(std::span<uint32_t> indices, std::span<const Model::Vertex> vertices, float threshold, std::span<const uint32_t> hardBoundaries)
+  {
+    auto vertexCount{static_cast<uint32_t>(vertices.size())};
+    auto triangleCount{static_cast<uint32_t>(indices.size() / 3)};
+    if(triangleCount == 0)
+      return;
+
+    std::vector<uint32_t> cacheTime(vertexCount);
+    uint32_t time{cacheSize + 1};
+
+    auto resetCache = [&]() { time += cacheSize + 1; };
+    auto triangleMisses = [&](uint32_t triangle) {
+      uint32_t misses{};
+      for(uint32_t corner{}; corner < 3; ++corner) {
+        uint32_t v{indices[triangle * 3 + corner]};
+        if(time - cacheTime[v] > cacheSize) {
+          cacheTime[v] = time++;
+          ++misses;
+        }
+      }
+
+      return misses;
+    };
+
+    // where the order had to restart anyway: given, or every triangle missing all three vertices
+    std::vector<uint32_t> hard{hardBoundaries.begin(), hardBoundaries.end()};
+    if(hard.empty()) {
+      for(uint32_t t{}; t < triangleCount; ++t) {
+        if(triangleMisses(t) == 3)
+          hard.push_back(t);
+      }
+
+      if(hard.empty() || hard.front() != 0)
+        hard.insert(hard.begin(), 0);
+    }
+
+    hard.push_back(triangleCount);
+
+    // cut the hard clusters again as soon as the cache hit rate so far is within threshold of the whole cluster's
+    std::vector<uint32_t> clusters;
+    for(size_t c{}; c + 1 < hard.size(); ++c) {
+      uint32_t begin{hard[c]};
+      uint32_t end{hard[c + 1]};
+      if(begin >= end)
+        continue;
+
+      resetCache();
+      uint32_t misses{};
+      for(uint32_t t{begin}; t < end; ++t)
+        misses += triangleMisses(t);
+
+      float clusterThreshold{threshold * misses / float(end - begin)};
+
+      resetCache();
+      clusters.push_back(begin);
+      uint32_t start{begin};
+      misses = 0;
+      for(uint32_t t{begin}; t < end; ++t) {
+        misses += triangleMisses(t);
+
+        if(t + 1 < end && misses / float(t - start + 1) <= clusterThreshold) {
+          clusters.push_back(t + 1);
+          start = t + 1;
+          misses = 0;
+          resetCache();
+        }
+      }
+    }
+
+    clusters.push_back(triangleCount);
+
+    // area weighted centroids and normals
+    struct Cluster
+    {
+      uint32_t begin;
+      uint32_t end;
+      glm::vec3 centroid;
+      glm::vec3 normal;
+      float sortKey;
+    };
+
+    std::vector<Cluster> sorted;
+    sorted.reserve(clusters.size() - 1);
+
+    glm::vec3 meshCentroid{};
+    float meshArea{};
+    for(size_t c{}; c + 1 < clusters.size(); ++c) {
+      Cluster cluster{.begin = clusters[c], .end = clusters[c + 1], .centroid = {}, .normal = {}, .sortKey = {}};
+
+      float area{};
+      for(uint32_t t{cluster.begin}; t < cluster.end; ++t) {
+        const glm::vec3& p0{vertices[indices[t * 3 + 0]].position};
+        const glm::vec3& p1{vertices[indices[t * 3 + 1]].position};
+        const glm::vec3& p2{vertices[indices[t * 3 + 2]].position};
+
+        glm::vec3 normal{glm::cross(p1 - p0, p2 - p0)};
+        float triangleArea{glm::length(normal)};
+
+        cluster.centroid += (p0 + p1 + p2) * (triangleArea / 3.f);
+        cluster.normal += normal;
+        area += triangleArea;
+      }
+
+      meshCentroid += cluster.centroid;
+      meshArea += area;
+      cluster.centroid = area > 0.f ? cluster.centroid / area : cluster.centroid;
+      sorted.push_back(cluster);
+    }
+
+    if(meshArea > 0.f)
+      meshCentroid /= meshArea;
+
+    // far out and facing away from the center: drawn first, occludes the rest of the mesh from most views
+    for(auto& cluster : sorted) {
+      float length{glm::length(cluster.normal)};
+      cluster.sortKey = length > 0.f ? glm::dot(cluster.centroid - meshCentroid, cluster.normal / length) : 0.f;
+    }
+
+    std::ranges::stable_sort(sorted, std::greater{}, &Cluster::sortKey);
+
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+    for(const auto& cluster : sorted)
+      output.insert(output.end(), indices.begin() + cluster.begin * 3, indices.begin() + cluster.end * 3);
+
+    std::ranges::copy(output, indices.begin());
+  }
+
+  void MeshOptimizer::optimizeVertexFetch(Model::Builder* builder)
+  {
+    builder->ownData();
+
+    constexpr uint32_t unused{~0u};
+    std::vector<uint32_t> remap(builder->vertices.size(), unused);
+    std::vector<Model::Vertex> vertices;
+    vertices.reserve(builder->vertices.size());
+
+    for(uint32_t& index : builder->indices) {
+      if(remap[index] == unused) {
+        remap[index] = static_cast<uint32_t>(vertices.size());
+        vertices.push_back(builder->vertices[index]);
+      }
+
+      index = remap[index];
+    }
+
+    builder->vertices = std::move(vertices);
+  }
+
+  auto MeshOptimizer::cacheMisses(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t fifoSize) -> uint32_t
+  {
+    std::vector<uint32_t> cacheTime(vertexCount);
+    uint32_t time{fifoSize + 1};
+    uint32_t misses{};
+
+    for(uint32_t v : indices) {
+      if(time - cacheTime[v] > fifoSize) {
+        cacheTime[v] = time++;
+        ++misses;
+      }
+    }
+
+    return misses;
+  }
+
+  auto MeshOptimizer::acmr(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t fifoSize) -> float
+  {
+    return indices.empty() ? 0.f : cacheMisses(indices, vertexCount, fifoSize) / float(indices.size() / 3);
+  }
+
+  auto MeshOptimizer::atvr(std::span<const uint32_t> indices, uint32_t vertexCount, uint32_t fifoSize) -> float
+  {
+    return vertexCount == 0 ? 0.f : cacheMisses(indices, vertexCount, fifoSize) / float(vertexCount);
+  }
+} // namespace vke
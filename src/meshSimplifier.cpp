@@ -0,0 +1,251 @@
+#include "meshSimplifier.hpp"
+
+#include <glm/gtx/hash.hpp> // std::hash<glm::vec3>, for the position welding
+
+namespace vke
+{
+  void MeshSimplifier::Quadric::addPlane(glm::vec3 normal, float distance, float area)
+  {
+    double x{normal.x}, y{normal.y}, z{normal.z}, d{distance}, w{area};
+
+    a00 += w * x * x;
+    a01 += w * x * y;
+    a02 += w * x * z;
+    a11 += w * y * y;
+    a12 += w * y * z;
+    a22 += w * z * z;
+    b0 += w * x * d;
+    b1 += w * y * d;
+    b2 += w * z * d;
+    c += w * d * d;
+    weight += w;
+  }
+
+  auto MeshSimplifier::Quadric::evaluate(glm::vec3 position) const -> double
+  {
+    double x{position.x}, y{position.y}, z{position.z};
+
+    double error{
+      a00 * x * x + a11 * y * y + a22 * z * z +
+      2 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+      2 * (b0 * x + b1 * y + b2 * z) +
+      c};
+
+    return weight > 0 ? std::max(error, 0.0) / weight : 0.0;
+  }
+
+  auto MeshSimplifier::Quadric::operator+=(const Quadric& other) -> Quadric&
+  {
+    a00 += other.a00;
+    a01 += other.a01;
+    a02 += other.a02;
+    a11 += other.a11;
+    a12 += other.a12;
+    a22 += other.a22;
+    b0 += other.b0;
+    b1 += other.b1;
+    b2 += other.b2;
+    c += other.c;
+    weight += other.weight;
+
+    return *this;
+  }
+
+  auto MeshSimplifier::simplify(std::span<const uint32_t> indices, std::span<const Model::Vertex> vertices, size_t targetIndexCount, float maxError, float* error) -> std::vector<uint32_t>
+  {
+    VKE_PROFILE_FUNCTION();
+
+    assert(indices.size() % 3 == 0 && "Not a triangle list");
+
+    auto vertexCount{static_cast<uint32_t>(vertices.size())};
+    std::vector<uint32_t> result{indices.begin(), indices.end()};
+
+    if(error)
+      *error = 0.f;
+
+    // vertices sharing a position (attribute seams) share a quadric and are locked
+    std::vector<uint32_t> group(vertexCount);
+    std::vector<bool> locked(vertexCount);
+    {
+      std::unordered_map<glm::vec3, uint32_t> positions;
+      std::vector<uint32_t> groupSize;
+      for(uint32_t v{}; v < vertexCount; ++v) {
+        auto [it, inserted]{positions.try_emplace(vertices[v].position, static_cast<uint32_t>(groupSize.size()))};
+        if(inserted)
+          groupSize.push_back(0);
+
+        group[v] = it->second;
+        ++groupSize[it->second];
+      }
+
+      for(uint32_t v{}; v < vertexCount; ++v)
+        locked[v] = groupSize[group[v]] > 1;
+    }
+
+    // open borders: edges (between positions) used by a single triangle
+    {
+      std::unordered_map<uint64_t, uint32_t> edges;
+      auto edgeKey = [&](uint32_t a, uint32_t b) {
+        uint64_t ga{group[a]}, gb{group[b]};
+        return ga < gb ? ga << 32 | gb : gb << 32 | ga;
+      };
+
+      for(size_t i{}; i < result.size(); i += 3) {
+        for(size_t corner{}; corner < 3; ++corner)
+          ++edges[edgeKey(result[i + corner], result[i + (corner + 1) % 3])];
+      }
+
+      for(size_t i{}; i < result.size(); i += 3) {
+        for(size_t corner{}; corner < 3; ++corner) {
+          uint32_t a{result[i + corner]};
+          uint32_t b{result[i + (corner + 1) % 3]};
+          if(edges[edgeKey(a, b)] == 1)
+            locked[a] = locked[b] = true;
+        }
+      }
+    }
+
+    std::vector<Quadric> quadrics(vertexCount);
+    for(size_t i{}; i < result.size(); i += 3) {
+      const glm::vec3& p0{vertices[result[i + 0]].position};
+      const glm::vec3& p1{vertices[result[i + 1]].position};
+      const glm::vec3& p2{vertices[result[i + 2]].position};
+
+      glm::vec3 normal{glm::cross(p1 - p0, p2 - p0)};
+      float area{glm::length(normal)};
+      if(area <= 0.f)
+        continue;
+
+      normal /= area;
+      for(size_t corner{}; corner < 3; ++corner)
+        quadrics[group[result[i + corner]]].addPlane(normal, -glm::dot(normal, p0), area * 0.5f);
+    }
+
+    auto faceNormal = [&](uint32_t a, uint32_t b, uint32_t c) {
+      return glm::cross(vertices[b].position - vertices[a].position, vertices[c].position - vertices[a].position);
+    };
+
+    struct Collapse
+    {
+      uint32_t from;
+      uint32_t to;
+      double cost;
+    };
+
+    std::vector<Collapse> collapses;
+    std::vector<uint32_t> offsets(vertexCount + 1);
+    std::vector<uint32_t> adjacency;
+    std::vector<uint32_t> remap(vertexCount);
+    std::vector<bool> touched(vertexCount);
+    double maxCost{double{maxError} * maxError};
+    float resultError{};
+
+    while(result.size() > targetIndexCount) {
+      // vertex -> triangles of this pass
+      std::ranges::fill(offsets, 0);
+      for(uint32_t v : result)
+        ++offsets[v + 1];
+      for(uint32_t v{}; v < vertexCount; ++v)
+        offsets[v + 1] += offsets[v];
+
+      adjacency.resize(result.size());
+      {
+        std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+        for(uint32_t i{}; i < result.size(); ++i)
+          adjacency[fill[result[i]]++] = i / 3;
+      }
+
+      collapses.clear();
+      for(size_t i{}; i < result.size(); i += 3) {
+        for(size_t corner{}; corner < 3; ++corner) {
+          uint32_t a{result[i + corner]};
+          uint32_t b{result[i + (corner + 1) % 3]};
+
+          for(auto [from, to] : {std::pair{a, b}, std::pair{b, a}}) {
+            if(locked[from])
+              continue;
+
+            Quadric quadric{quadrics[group[from]]};
+            quadric += quadrics[group[to]];
+            collapses.push_back({from, to, quadric.evaluate(vertices[to].position)});
+          }
+        }
+      }
+
+      std::ranges::sort(collapses, {}, &Collapse::cost);
+
+      std::iota(remap.begin(), remap.end(), 0u);
+      touched.assign(vertexCount, false);
+      size_t triangleCount{result.size() / 3};
+      size_t targetTriangles{targetIndexCount / 3};
+      bool collapsed{};
+
+      for(const Collapse& collapse : collapses) {
+        if(triangleCount <= targetTriangles || collapse.cost > maxCost)
+          break;
+
+        if(touched[collapse.from] || touched[collapse.to])
+          continue;
+
+        // the triangles moving along must keep their orientation, the ones holding the edge disappear
+        bool flips{};
+        size_t removed{};
+        for(uint32_t j{offsets[collapse.from]}; j < offsets[collapse.from + 1] && !flips; ++j) {
+          const uint32_t* triangle{&result[adjacency[j] * 3]};
+          uint32_t target{group[collapse.to]};
+          if(group[triangle[0]] == target || group[triangle[1]] == target || group[triangle[2]] == target) {
+            ++removed;
+            continue;
+          }
+
+          uint32_t moved[3]{triangle[0], triangle[1], triangle[2]};
+          for(uint32_t& v : moved)
+            v = v == collapse.from ? collapse.to : v;
+
+          glm::vec3 before{faceNormal(triangle[0], triangle[1], triangle[2])};
+          glm::vec3 after{faceNormal(moved[0], moved[1], moved[2])};
+          flips = glm::dot(before, after) <= 0.f;
+        }
+
+        if(flips)
+          continue;
+
+        // the whole neighbourhood waits for the next pass, its triangles are stale now
+        for(uint32_t j{offsets[collapse.from]}; j < offsets[collapse.from + 1]; ++j) {
+          const uint32_t* triangle{&result[adjacency[j] * 3]};
+          touched[triangle[0]] = touched[triangle[1]] = touched[triangle[2]] = true;
+        }
+
+        remap[collapse.from] = collapse.to;
+        quadrics[group[collapse.to]] += quadrics[group[collapse.from]];
+        resultError = std::max(resultError, static_cast<float>(std::sqrt(collapse.cost)));
+        triangleCount -= removed;
+        collapsed = true;
+      }
+
+      if(!collapsed)
+        break;
+
+      // drop what became degenerate, seam vertices at one position count as the same corner
+      size_t write{};
+      for(size_t i{}; i < result.size(); i += 3) {
+        uint32_t a{remap[result[i + 0]]};
+        uint32_t b{remap[result[i + 1]]};
+        uint32_t c{remap[result[i + 2]]};
+        if(group[a] == group[b] || group[b] == group[c] || group[a] == group[c])
+          continue;
+
+        result[write++] = a;
+        result[write++] = b;
+        result[write++] = c;
+      }
+
+      result.resize(write);
+    }
+
+    if(error)
+      *error = resultError;
+
+    return result;
+  }
+} // namespace vke
@@ -0,0 +1,173 @@
+#include "meshletBuilder.hpp"
+
+namespace vke
+{
+  auto MeshletBuilder::build(std::span<uint32_t> indices, std::span<const Model::Vertex> vertices) -> std::vector<Model::Meshlet>
+  {
+    VKE_PROFILE_FUNCTION();
+
+    assert(indices.size() % 3 == 0 && "Not a triangle list");
+
+    auto vertexCount{static_cast<uint32_t>(vertices.size())};
+    auto triangleCount{static_cast<uint32_t>(indices.size() / 3)};
+
+    // vertex -> triangles
+    std::vector<uint32_t> offsets(vertexCount + 1);
+    for(uint32_t index : indices)
+      ++offsets[index + 1];
+    for(uint32_t v{}; v < vertexCount; ++v)
+      offsets[v + 1] += offsets[v];
+
+    std::vector<uint32_t> adjacency(indices.size());
+    {
+      std::vector<uint32_t> fill(offsets.begin(), offsets.end() - 1);
+      for(uint32_t i{}; i < indices.size(); ++i)
+        adjacency[fill[indices[i]]++] = i / 3;
+    }
+
+    std::vector<Model::Meshlet> meshlets;
+    std::vector<uint32_t> output;
+    output.reserve(indices.size());
+
+    std::vector<bool> emitted(triangleCount);
+    std::vector<uint32_t> vertexMeshlet(vertexCount, ~0u); // which meshlet a vertex was last added to
+    std::vector<uint32_t> candidates;
+    uint32_t seed{};
+
+    while(output.size() < indices.size()) {
+      auto id{static_cast<uint32_t>(meshlets.size())};
+      Model::Meshlet meshlet{.firstIndex = static_cast<uint32_t>(output.size())};
+      candidates.clear();
+
+      auto newVertices = [&](uint32_t triangle) {
+        uint32_t count{};
+        for(uint32_t corner{}; corner < 3; ++corner)
+          count += vertexMeshlet[indices[triangle * 3 + corner]] != id;
+        return count;
+      };
+
+      auto add = [&](uint32_t triangle) {
+        emitted[triangle] = true;
+        ++meshlet.triangleCount;
+
+        for(uint32_t corner{}; corner < 3; ++corner) {
+          uint32_t v{indices[triangle * 3 + corner]};
+          output.push_back(v);
+
+          if(vertexMeshlet[v] != id) {
+            vertexMeshlet[v] = id;
+            ++meshlet.vertexCount;
+
+            for(uint32_t i{offsets[v]}; i < offsets[v + 1]; ++i) {
+              if(!emitted[adjacency[i]])
+                candidates.push_back(adjacency[i]);
+            }
+          }
+        }
+      };
+
+      while(emitted[seed])
+        ++seed;
+      add(seed);
+
+      while(meshlet.triangleCount < maxTriangles) {
+        int64_t best{-1};
+        uint32_t bestNew{4};
+
+        // drops the emitted ones while looking
+        size_t kept{};
+        for(uint32_t triangle : candidates) {
+          if(emitted[triangle])
+            continue;
+
+          candidates[kept++] = triangle;
+
+          uint32_t added{newVertices(triangle)};
+          if(meshlet.vertexCount + added <= maxVertices && added < bestNew) {
+            best = triangle;
+            bestNew = added;
+          }
+        }
+        candidates.resize(kept);
+
+        if(best < 0)
+          break;
+
+        add(static_cast<uint32_t>(best));
+      }
+
+      computeBounds(std::span{output}.subspan(meshlet.firstIndex, meshlet.triangleCount * 3), vertices, &meshlet);
+      meshlets.push_back(meshlet);
+    }
+
+    std::ranges::copy(output, indices.begin());
+    return meshlets;
+  }
+
+  void MeshletBuilder::computeBounds(std::span<const uint32_t> indices, std::span<const Model::Vertex> vertices, Model::Meshlet* meshlet)
+  {
+    glm::vec3 min{vertices[indices[0]].position};
+    glm::vec3 max{min};
+    for(uint32_t index : indices) {
+      min = glm::min(min, vertices[index].position);
+      max = glm::max(max, vertices[index].position);
+    }
+
+    meshlet->center = (min + max) * 0.5f;
+    meshlet->radius = 0.f;
+    for(uint32_t index : indices)
+      meshlet->radius = std::max(meshlet->radius, glm::length(vertices[index].position - meshlet->center));
+
+    // the cone around the average normal that holds every triangle normal
+    std::vector<glm::vec3> normals;
+    normals.reserve(indices.size() / 3);
+
+    glm::vec3 axis{};
+    for(size_t i{}; i < indices.size(); i += 3) {
+      const glm::vec3& p0{vertices[indices[i + 0]].position};
+      glm::vec3 normal{glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0)};
+
+      float length{glm::length(normal)};
+      if(length <= 0.f)
+        continue;
+
+      normals.push_back(normal / length);
+      axis += normals.back();
+    }
+
+    meshlet->coneAxis = glm::vec3{0.f, 0.f, 1.f};
+    meshlet->coneApex = meshlet->center;
+    meshlet->coneCutoff = 1.f;
+
+    float axisLength{glm::length(axis)};
+    if(normals.empty() || axisLength <= 0.f)
+      return;
+
+    axis /= axisLength;
+
+    float minDot{1.f};
+    for(const glm::vec3& normal : normals)
+      minDot = std::min(minDot, glm::dot(axis, normal));
+
+    meshlet->coneAxis = axis;
+
+    // wider than a hemisphere, some triangle always faces the camera
+    if(minDot <= 0.1f)
+      return;
+
+    // the apex sits behind every triangle plane, seen from inside the cone they all face away
+    float behind{};
+    for(size_t i{}, n{}; i < indices.size(); i += 3) {
+      const glm::vec3& p0{vertices[indices[i + 0]].position};
+      glm::vec3 normal{glm::cross(vertices[indices[i + 1]].position - p0, vertices[indices[i + 2]].position - p0)};
+      if(glm::length(normal) <= 0.f)
+        continue;
+
+      behind = std::max(behind, glm::dot(meshlet->center - p0, normals[n]) / glm::dot(axis, normals[n]));
+      ++n;
+    }
+
+    meshlet->coneApex = meshlet->center - axis * behind;
+    meshlet->coneCutoff = std::sqrt(1.f - minDot * minDot);
+  }
+} // namespace vke
@@ -1,33 +1,98 @@
 #include "model.hpp"
+#include "meshCache.hpp"
+#include "meshletBuilder.hpp"
+#include "meshOptimizer.hpp"
+#include "meshSimplifier.hpp"
+#include "objImporter.hpp"
+#include "uploadBatch.hpp"
 
-namespace std
+namespace vke
 {
-  template<>
-  struct hash<vke::Model::Vertex>
+  Model::Model(Device& device, Builder& builder) :
+    m_device{device},
+    m_boundingSphere{(builder.boundsMin + builder.boundsMax) * 0.5f, glm::length(builder.boundsMax - builder.boundsMin) * 0.5f}
   {
-    std::size_t operator()(vke::Model::Vertex const& vertex) const
+    createVertexBuffer(builder.vertexData());
+    createIndexBuffer(builder.indexData());
+  }
+
+  namespace
+  {
+    auto narrowIndices(std::span<const uint32_t> indices) -> std::vector<uint16_t>
     {
-      std::size_t seed{};
-      vke::hash_combine(&seed, vertex.position, vertex.color, vertex.normal, vertex.uv);
-      return seed;
+      std::vector<uint16_t> narrow(indices.size());
+      std::ranges::transform(indices, narrow.begin(), [](uint32_t index) { return static_cast<uint16_t>(index); });
+      return narrow;
     }
-  };
-} // namespace std
+  } // namespace
 
-namespace vke
-{
-  Model::Model(Device& device, Builder& builder) :
-    m_device{device}
+  Model::Model(Device& device, const Builder& builder, UploadBatch* upload) :
+    m_device{device},
+    m_vertexFormat{builder.format},
+    m_vertexLayout{builder.layout},
+    m_boundingSphere{(builder.boundsMin + builder.boundsMax) * 0.5f, glm::length(builder.boundsMax - builder.boundsMin) * 0.5f}
   {
-    createVertexBuffer(builder.vertices);
-    createIndexBuffer(builder.indices);
+    auto vertices{builder.vertexData()};
+    auto indices{builder.indexData()};
+
+    assert(vertices.size() >= 3 && "Vertex count must be at least 3");
+
+    auto vertexBytes{std::as_bytes(vertices)};
+    if(m_vertexFormat == VertexFormat::compact) {
+      assert(builder.compactVertices.size() == vertices.size() && "Compact vertices out of date");
+
+      glm::vec3 extent{builder.boundsMax - builder.boundsMin};
+      m_dequantization = glm::scale(glm::translate(glm::mat4{1.f}, builder.boundsMin), glm::max(extent, glm::vec3{1e-12f}));
+
+      vertexBytes = std::as_bytes(std::span{builder.compactVertices});
+    }
+
+    if(m_vertexLayout == VertexLayout::split) {
+      assert(builder.splitVertices.size() == vertexBytes.size() && "Split vertices out of date");
+
+      m_attributeOffset = VkDeviceSize{positionSize(m_vertexFormat)} * vertices.size();
+      vertexBytes = builder.splitVertices;
+    }
+
+    m_vertexBuffer = std::make_unique<Buffer>(
+      m_device,
+      static_cast<uint32_t>(vertices.size()),
+      vertexSize(m_vertexFormat),
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_VERTEX_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    upload->add(m_vertexBuffer->handle(), vertexBytes);
+
+    m_hasIndexBuffer = !indices.empty();
+    if(!m_hasIndexBuffer)
+      return;
+
+    m_indexType = builder.indexType;
+    m_submeshes = builder.submeshes;
+    m_lods = builder.lods;
+    m_meshlets = builder.meshlets;
+
+    auto indexBytes{std::as_bytes(indices)};
+    if(m_indexType == VK_INDEX_TYPE_UINT16) {
+      assert(builder.shortIndices.size() == indices.size() && "Short indices out of date");
+      indexBytes = std::as_bytes(std::span{builder.shortIndices});
+    }
+
+    m_indexBuffer = std::make_unique<Buffer>(
+      m_device,
+      static_cast<uint32_t>(indices.size()),
+      m_indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t),
+      VK_BUFFER_USAGE_TRANSFER_DST_BIT | VK_BUFFER_USAGE_INDEX_BUFFER_BIT,
+      VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+
+    upload->add(m_indexBuffer->handle(), indexBytes);
   }
 
   Model::~Model()
   {
   }
 
-  void Model::createVertexBuffer(std::span<Model::Vertex> vertices)
+  void Model::createVertexBuffer(std::span<const Model::Vertex> vertices)
   {
     assert(vertices.size() >= 3 && "Vertex count must be at least 3");
 
@@ -57,15 +122,22 @@ namespace vke
     MemAllocator::copyBuffer(m_device, stagingBuffer.handle(), m_vertexBuffer->handle(), stagingBuffer.size());
   }
 
-  void Model::createIndexBuffer(std::span<uint32_t> indices)
+  void Model::createIndexBuffer(std::span<const uint32_t> indices)
   {
     m_hasIndexBuffer = indices.size() > 0;
 
     if(!m_hasIndexBuffer)
       return;
 
+    // half the size whenever the vertex count allows it
+    std::vector<uint16_t> shortIndices;
+    if(m_vertexBuffer && m_vertexBuffer->elementCount() <= maxShortIndexVertices) {
+      shortIndices = narrowIndices(indices);
+      m_indexType = VK_INDEX_TYPE_UINT16;
+    }
+
     auto indexCount{static_cast<uint32_t>(indices.size())};
-    auto indexSize{sizeof(indices[0])};
+    auto indexSize{m_indexType == VK_INDEX_TYPE_UINT16 ? sizeof(uint16_t) : sizeof(uint32_t)};
     Buffer stagingBuffer{
       m_device,
       indexCount,
@@ -82,7 +154,7 @@ namespace vke
       VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
 
     stagingBuffer.mapMemory();
-    stagingBuffer.write(indices.data());
+    stagingBuffer.write(m_indexType == VK_INDEX_TYPE_UINT16 ? static_cast<const void*>(shortIndices.data()) : indices.data());
 
     // TODO: vkFlush and vkInvalidate
     // stagingBuffer.flush();
@@ -114,27 +186,116 @@ namespace vke
   {
     assert(m_vertexBuffer && "Vertex buffer not created.");
 
-    VkBuffer vertexBuffers[] = {m_vertexBuffer->handle()};
-    VkDeviceSize offsets[]{0};
+    VkBuffer vertexBuffers[] = {m_vertexBuffer->handle(), m_vertexBuffer->handle()};
+    VkDeviceSize offsets[]{0, m_attributeOffset};
 
-    vkCmdBindVertexBuffers(commandBuffer, 0, 1, vertexBuffers, offsets);
+    uint32_t bindingCount{m_vertexLayout == VertexLayout::split ? 2u : 1u};
+    vkCmdBindVertexBuffers(commandBuffer, 0, bindingCount, vertexBuffers, offsets);
 
     if(m_hasIndexBuffer)
-      vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->handle(), 0, VK_INDEX_TYPE_UINT32);
+      vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->handle(), 0, m_indexType);
   };
 
-  void Model::draw(VkCommandBuffer commandBuffer)
+  void Model::bindPositions(VkCommandBuffer commandBuffer)
+  {
+    assert(m_vertexBuffer && "Vertex buffer not created.");
+
+    VkBuffer vertexBuffer{m_vertexBuffer->handle()};
+    VkDeviceSize offset{0};
+
+    vkCmdBindVertexBuffers(commandBuffer, 0, 1, &vertexBuffer, &offset);
+
+    if(m_hasIndexBuffer)
+      vkCmdBindIndexBuffer(commandBuffer, m_indexBuffer->handle(), 0, m_indexType);
+  }
+
+  void Model::draw(VkCommandBuffer commandBuffer, uint32_t lod)
   {
     // assert(!m_indicesCount && "Using a index buffer, drawIndexed() instead.");
     // assert(m_indicesCount && "Index buffer not created, draw() instead.");
 
-    if(m_hasIndexBuffer) {
-      vkCmdDrawIndexed(commandBuffer, m_indexBuffer->elementCount(), 1, 0, 0, 0);
+    Lod range{lod < m_lods.size() ? m_lods[lod] : Lod{.firstIndex = 0, .indexCount = indexCount(), .error = 0.f}};
+
+    // submeshes never straddle two lods
+    if(m_hasIndexBuffer && !m_submeshes.empty()) {
+      for(const Submesh& submesh : m_submeshes) {
+        if(submesh.firstIndex >= range.firstIndex && submesh.firstIndex < range.firstIndex + range.indexCount)
+          vkCmdDrawIndexed(commandBuffer, submesh.indexCount, 1, submesh.firstIndex, submesh.vertexOffset, 0);
+      }
+    } else if(m_hasIndexBuffer) {
+      vkCmdDrawIndexed(commandBuffer, range.indexCount, 1, range.firstIndex, 0, 0);
     } else {
       vkCmdDraw(commandBuffer, m_vertexBuffer->elementCount(), 1, 0, 0);
     }
   }
 
+  auto Model::selectLod(float pixelsPerUnit, uint32_t current, float maxPixelError, float hysteresis) const -> uint32_t
+  {
+    // errors only grow with the lod
+    uint32_t lod{};
+    for(uint32_t i{1}; i < m_lods.size(); ++i) {
+      float limit{i > current ? maxPixelError * (1.f - hysteresis) : maxPixelError};
+      if(m_lods[i].error * pixelsPerUnit > limit)
+        break;
+
+      lod = i;
+    }
+
+    return lod;
+  }
+
+  auto Model::memorySize() const -> VkDeviceSize
+  {
+    return m_vertexBuffer->size() + (m_hasIndexBuffer ? m_indexBuffer->size() : 0);
+  }
+
+  auto Model::vertexSize(VertexFormat format) -> uint32_t
+  {
+    return format == VertexFormat::compact ? sizeof(CompactVertex) : sizeof(Vertex);
+  }
+
+  auto Model::positionSize(VertexFormat format) -> uint32_t
+  {
+    static_assert(offsetof(Vertex, position) == 0 && offsetof(CompactVertex, position) == 0);
+    return format == VertexFormat::compact ? sizeof(CompactVertex::position) : sizeof(Vertex::position);
+  }
+
+  auto Model::vertexBindings(VertexFormat format, VertexLayout layout, bool positionsOnly) -> std::vector<VkVertexInputBindingDescription>
+  {
+    if(layout == VertexLayout::interleaved)
+      return {{.binding = 0, .stride = vertexSize(format), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX}};
+
+    std::vector<VkVertexInputBindingDescription> bindings{
+      {.binding = 0, .stride = positionSize(format), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX},
+    };
+
+    if(!positionsOnly)
+      bindings.push_back({.binding = 1, .stride = vertexSize(format) - positionSize(format), .inputRate = VK_VERTEX_INPUT_RATE_VERTEX});
+
+    return bindings;
+  }
+
+  auto Model::vertexAttributes(VertexFormat format, VertexLayout layout, bool positionsOnly) -> std::vector<VkVertexInputAttributeDescription>
+  {
+    auto attributes{format == VertexFormat::compact ? CompactVertex::getVertexInputAttributeDescription() : Vertex::getVertexInputAttributeDescription()};
+
+    // location 0 (the position) comes first
+    if(positionsOnly)
+      attributes.resize(1);
+
+    if(layout == VertexLayout::split) {
+      for(auto& attribute : attributes) {
+        if(attribute.location == 0)
+          continue;
+
+        attribute.binding = 1;
+        attribute.offset -= positionSize(format);
+      }
+    }
+
+    return attributes;
+  }
+
   std::vector<VkVertexInputAttributeDescription> Model::Vertex::getVertexInputAttributeDescription()
   {
     return {
@@ -178,6 +339,48 @@ namespace vke
     };
   }
 
+  // same locations as Vertex, the compact shader variant decodes them
+  std::vector<VkVertexInputAttributeDescription> Model::CompactVertex::getVertexInputAttributeDescription()
+  {
+    return {
+      {
+        .location = 0,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16B16A16_UNORM,
+        .offset = offsetof(CompactVertex, position),
+      },
+      {
+        .location = 1,
+        .binding = 0,
+        .format = VK_FORMAT_R8G8B8A8_UNORM,
+        .offset = offsetof(CompactVertex, color),
+      },
+      {
+        .location = 2,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16_SNORM,
+        .offset = offsetof(CompactVertex, normal),
+      },
+      {
+        .location = 3,
+        .binding = 0,
+        .format = VK_FORMAT_R16G16_SFLOAT,
+        .offset = offsetof(CompactVertex, uv),
+      },
+    };
+  }
+
+  std::vector<VkVertexInputBindingDescription> Model::CompactVertex::getVertexInputBindingDescription()
+  {
+    return {
+      {
+        .binding = 0,
+        .stride = sizeof(CompactVertex),
+        .inputRate = VK_VERTEX_INPUT_RATE_VERTEX,
+      },
+    };
+  }
+
   std::vector<VkDescriptorSetLayoutBinding> Model::UniformBufferObject::getDescriptorSetLayoutBinding()
   {
     return {
@@ -201,72 +404,302 @@ namespace vke
     };
   }
 
-  void Model::Builder::loadModel(std::filesystem::path path)
+  void Model::Builder::loadModel(std::filesystem::path path, ThreadPool* threadPool)
   {
+    VKE_PROFILE_FUNCTION();
+
     if(!std::filesystem::exists(path))
       throw std::runtime_error("Invalid file path");
 
-    tinyobj::attrib_t attrib{};             // position, color, normal and texture coordinate data
-    std::vector<tinyobj::shape_t> shapes{}; // index values for each face element
-    std::vector<tinyobj::material_t> materials{};
-    std::string warn{}, err{};
+    if(MeshCache::load(path, this))
+      return;
+
+    importObj(path, threadPool);
+
+    // paid once per source file, the cache stores the optimized order and the lods
+    auto report{MeshOptimizer::optimize(this)};
+    buildMeshlets();
+    generateLods();
+    std::cout << clr::cyan << "[MeshOptimizer] " << clr::white << path.filename().string() << ": ACMR " << report.acmrBefore << " -> " << report.acmrAfter << ", ATVR " << report.atvrBefore << " -> " << report.atvrAfter << ", " << std::max(lods.size(), size_t{1}) << " lods, " << meshlets.size() << " meshlets" << std::endl;
+
+    computeBounds();
+    computeContentHash();
 
-    if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str())) {
-      throw std::runtime_error("[Failed to load model]" + warn + err);
+    // a read only asset folder only costs us the cache
+    try {
+      MeshCache::store(path, *this);
+    } catch(const std::exception& e) {
+      std::cerr << clr::sand << "[MeshCache] " << clr::white << e.what() << std::endl;
     }
+  }
 
-    vertices.clear();
-    indices.clear();
-
-    std::unordered_map<Vertex, uint32_t> uniqueVertices{};
-    for(auto const& shape : shapes) {
-      for(auto const& index : shape.mesh.indices) {
-        Vertex vertex{};
-
-        // inexistent if -1
-        if(index.vertex_index >= 0) {
-          // each vertexertex has 3 packed values
-          vertex.position = {
-            attrib.vertices[3 * index.vertex_index + 0],
-            attrib.vertices[3 * index.vertex_index + 1],
-            attrib.vertices[3 * index.vertex_index + 2],
-          };
-
-          // .obj doesn't support colors. This is possible through an unofficial extension for the file format, that puts RGB values after the XYZ vertex positions.
-
-          // attrib.color is always initialized to be the same size as attrib.vertices and filled with ones wherever a color is not provided in the obj file
-          vertex.color = {
-            attrib.colors[3 * index.vertex_index + 0],
-            attrib.colors[3 * index.vertex_index + 1],
-            attrib.colors[3 * index.vertex_index + 2],
-          };
-        }
+  auto Model::Builder::vertexData() const -> std::span<const Vertex>
+  {
+    return m_mapping ? m_mappedVertices : std::span<const Vertex>{vertices};
+  }
 
-        if(index.normal_index >= 0) {
-          vertex.normal = {
-            attrib.normals[3 * index.normal_index + 0],
-            attrib.normals[3 * index.normal_index + 1],
-            attrib.normals[3 * index.normal_index + 2],
-          };
-        }
+  auto Model::Builder::indexData() const -> std::span<const uint32_t>
+  {
+    return m_mapping ? m_mappedIndices : std::span<const uint32_t>{indices};
+  }
 
-        if(index.texcoord_index >= 0) {
-          vertex.uv = {
-            attrib.texcoords[2 * index.texcoord_index + 0],
-            attrib.texcoords[2 * index.texcoord_index + 1],
-          };
-        }
+  void Model::Builder::computeBounds()
+  {
+    auto data{vertexData()};
+    if(data.empty())
+      return;
+
+    boundsMin = boundsMax = data.front().position;
+    for(auto const& vertex : data) {
+      boundsMin = glm::min(boundsMin, vertex.position);
+      boundsMax = glm::max(boundsMax, vertex.position);
+    }
+  }
+
+  void Model::Builder::computeContentHash()
+  {
+    contentHash = fnv1a(std::as_bytes(vertexData()));
+    contentHash = fnv1a(std::as_bytes(indexData()), contentHash);
+  }
+
+  void Model::Builder::buildMeshlets()
+  {
+    assert(lods.empty() && format == VertexFormat::standard && indexType == VK_INDEX_TYPE_UINT32 && "Build the meshlets before generateLods(), shortenIndices() and compact()");
+
+    ownData();
+    meshlets.clear();
+    if(indices.size() / 3 < MeshletBuilder::minTriangles)
+      return;
+
+    // the greedy growth keeps most of the cache order, the new one is close enough to not redo it
+    meshlets = MeshletBuilder::build(indices, vertices);
+  }
+
+  void Model::Builder::generateLods(uint32_t count, float ratio)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    assert(format == VertexFormat::standard && indexType == VK_INDEX_TYPE_UINT32 && "Generate the lods before shortenIndices() and compact()");
+
+    ownData();
+    lods.clear();
+    if(indices.empty())
+      return;
+
+    lods.push_back({.firstIndex = 0, .indexCount = static_cast<uint32_t>(indices.size()), .error = 0.f});
+
+    // every lod is simplified from lod 0, its error is measured against the real surface
+    std::vector<uint32_t> base{indices};
+    float error{};
+    for(uint32_t lod{1}; lod < count; ++lod) {
+      size_t target{static_cast<size_t>(lods.back().indexCount / 3 * ratio) * 3};
+      if(target < 3)
+        break;
+
+      float lodError{};
+      auto simplified{MeshSimplifier::simplify(base, vertices, target, std::numeric_limits<float>::max(), &lodError)};
+
+      // stuck on seams and borders, another level wouldn't save anything
+      if(simplified.empty() || simplified.size() > lods.back().indexCount * 0.9f)
+        break;
+
+      MeshOptimizer::optimizeVertexCache(simplified, static_cast<uint32_t>(vertices.size()));
+
+      error = std::max(error, lodError);
+      lods.push_back({.firstIndex = static_cast<uint32_t>(indices.size()), .indexCount = static_cast<uint32_t>(simplified.size()), .error = error});
+      indices.insert(indices.end(), simplified.begin(), simplified.end());
+    }
+
+    if(lods.size() == 1)
+      lods.clear();
+  }
 
-        // For every vertex of the loaded file we check if he already exists on the map. If not then its index in the builder vertices vector is added to the map.
-        if(!uniqueVertices.contains(vertex)) {
-          uniqueVertices[vertex] = vertices.size();
-          vertices.push_back(vertex);
+  bool Model::Builder::compact()
+  {
+    auto data{vertexData()};
+
+    layout = VertexLayout::interleaved;
+    splitVertices.clear();
+
+    for(auto const& vertex : data) {
+      bool colorFits{vertex.color == glm::clamp(vertex.color, 0.f, 1.f)};
+      bool uvFits{vertex.uv == glm::clamp(vertex.uv, -1.f, 1.f)};
+      if(!colorFits || !uvFits) {
+        format = VertexFormat::standard;
+        compactVertices.clear();
+        return false;
+      }
+    }
+
+    computeBounds();
+    glm::vec3 extent{boundsMax - boundsMin};
+    glm::vec3 scale{
+      extent.x > 0.f ? 1.f / extent.x : 0.f,
+      extent.y > 0.f ? 1.f / extent.y : 0.f,
+      extent.z > 0.f ? 1.f / extent.z : 0.f,
+    };
+
+    compactVertices.resize(data.size());
+    for(size_t i{}; i < data.size(); ++i) {
+      const Vertex& vertex{data[i]};
+      CompactVertex& compact{compactVertices[i]};
+
+      glm::vec3 position{glm::round(glm::clamp((vertex.position - boundsMin) * scale, 0.f, 1.f) * 65535.f)};
+      compact.position[0] = static_cast<uint16_t>(position.x);
+      compact.position[1] = static_cast<uint16_t>(position.y);
+      compact.position[2] = static_cast<uint16_t>(position.z);
+
+      // octahedral: project on the octahedron, fold the lower half over the upper one
+      glm::vec3 normal{vertex.normal};
+      float length{glm::abs(normal.x) + glm::abs(normal.y) + glm::abs(normal.z)};
+      glm::vec2 octahedral{};
+      if(length > 0.f) {
+        normal /= length;
+        octahedral = {normal.x, normal.y};
+        if(normal.z < 0.f)
+          octahedral = (1.f - glm::abs(glm::vec2{normal.y, normal.x})) * glm::vec2{normal.x >= 0.f ? 1.f : -1.f, normal.y >= 0.f ? 1.f : -1.f};
+      }
+
+      glm::vec2 snorm{glm::round(glm::clamp(octahedral, -1.f, 1.f) * 32767.f)};
+      compact.normal[0] = static_cast<int16_t>(snorm.x);
+      compact.normal[1] = static_cast<int16_t>(snorm.y);
+
+      compact.uv = glm::packHalf2x16(vertex.uv);
+      compact.color = glm::packUnorm4x8(glm::vec4{vertex.color, 1.f});
+    }
+
+    format = VertexFormat::compact;
+    return true;
+  }
+
+  bool Model::Builder::shortenIndices(bool allowSubmeshes)
+  {
+    assert(format == VertexFormat::standard && layout == VertexLayout::interleaved && "Shorten the indices before compact() and splitStreams()");
+
+    auto data{indexData()};
+    submeshes.clear();
+    for(Meshlet& meshlet : meshlets)
+      meshlet.vertexOffset = 0;
+
+    if(data.empty() || (vertexData().size() > maxShortIndexVertices && !allowSubmeshes)) {
+      indexType = VK_INDEX_TYPE_UINT32;
+      shortIndices.clear();
+      return false;
+    }
+
+    indexType = VK_INDEX_TYPE_UINT16;
+    if(vertexData().size() <= maxShortIndexVertices) {
+      shortIndices = narrowIndices(data);
+      return true;
+    }
+
+    // triangles in order, a new submesh whenever the next one could reference a 65537th vertex or a lod starts.
+    // meshlets are never cut, their start reserves room for all their vertices. every submesh gets its own
+    // copy of the vertices it uses, contiguous from its vertexOffset
+    ownData();
+
+    constexpr uint32_t unused{~0u};
+    std::vector<uint32_t> local(vertices.size(), unused);
+    std::vector<uint32_t> used;
+    std::vector<Vertex> submeshVertices;
+    submeshVertices.reserve(vertices.size());
+    shortIndices.resize(indices.size());
+
+    Submesh submesh{};
+    size_t meshlet{};
+    for(size_t i{}; i < indices.size(); i += 3) {
+      bool lodStart{std::ranges::any_of(lods, [i](const Lod& lod) { return lod.firstIndex == i; })};
+
+      // meshlets come in index order
+      size_t reserved{3};
+      if(meshlet < meshlets.size() && i >= meshlets[meshlet].firstIndex) {
+        reserved = i == meshlets[meshlet].firstIndex ? meshlets[meshlet].vertexCount : 0;
+        if(i + 3 == meshlets[meshlet].firstIndex + meshlets[meshlet].triangleCount * 3)
+          ++meshlet;
+      }
+
+      if(i > submesh.firstIndex && (lodStart || used.size() + reserved > maxShortIndexVertices)) {
+        submesh.indexCount = static_cast<uint32_t>(i) - submesh.firstIndex;
+        submeshes.push_back(submesh);
+        submesh = {.firstIndex = static_cast<uint32_t>(i), .indexCount = 0, .vertexOffset = static_cast<int32_t>(submeshVertices.size())};
+
+        for(uint32_t v : used)
+          local[v] = unused;
+        used.clear();
+      }
+
+      for(size_t corner{i}; corner < i + 3; ++corner) {
+        uint32_t v{indices[corner]};
+        if(local[v] == unused) {
+          local[v] = static_cast<uint32_t>(used.size());
+          used.push_back(v);
+          submeshVertices.push_back(vertices[v]);
         }
 
-        // Those unique indexes are then pushed into the indices vector.
-        indices.push_back(uniqueVertices[vertex]);
+        shortIndices[corner] = static_cast<uint16_t>(local[v]);
       }
     }
+
+    submesh.indexCount = static_cast<uint32_t>(indices.size()) - submesh.firstIndex;
+    submeshes.push_back(submesh);
+
+    // the 32 bit indices stay valid for the cpu side (bounds, hashes, later stages)
+    vertices = std::move(submeshVertices);
+    for(const Submesh& range : submeshes) {
+      for(uint32_t i{range.firstIndex}; i < range.firstIndex + range.indexCount; ++i)
+        indices[i] = shortIndices[i] + static_cast<uint32_t>(range.vertexOffset);
+    }
+
+    for(Meshlet& cluster : meshlets) {
+      auto holder{std::ranges::find_if(submeshes, [&](const Submesh& range) { return cluster.firstIndex < range.firstIndex + range.indexCount; })};
+      cluster.vertexOffset = holder->vertexOffset;
+    }
+
+    return true;
+  }
+
+  void Model::Builder::splitStreams()
+  {
+    auto interleaved{format == VertexFormat::compact ? std::as_bytes(std::span{compactVertices}) : std::as_bytes(vertexData())};
+
+    size_t stride{vertexSize(format)};
+    size_t positionStride{positionSize(format)};
+    size_t attributeStride{stride - positionStride};
+    size_t count{interleaved.size() / stride};
+
+    splitVertices.resize(interleaved.size());
+    std::byte* positions{splitVertices.data()};
+    std::byte* attributes{positions + count * positionStride};
+
+    for(size_t i{}; i < count; ++i) {
+      const std::byte* vertex{interleaved.data() + i * stride};
+      std::memcpy(positions + i * positionStride, vertex, positionStride);
+      std::memcpy(attributes + i * attributeStride, vertex + positionStride, attributeStride);
+    }
+
+    layout = VertexLayout::split;
+  }
+
+  void Model::Builder::ownData()
+  {
+    if(!m_mapping)
+      return;
+
+    vertices.assign(m_mappedVertices.begin(), m_mappedVertices.end());
+    indices.assign(m_mappedIndices.begin(), m_mappedIndices.end());
+
+    m_mapping.reset();
+    m_mappedVertices = {};
+    m_mappedIndices = {};
+  }
+
+  void Model::Builder::importObj(const std::filesystem::path& path, ThreadPool* threadPool)
+  {
+    m_mapping.reset();
+    m_mappedVertices = {};
+    m_mappedIndices = {};
+
+    ObjImporter{threadPool}.import(path, this);
   }
 
 ///////////////////////////////////////
@@ -1,44 +1,356 @@
-#define TINYOBJLOADER_IMPLEMENTATION
 #include "modelManager.hpp"
 
 namespace vke
 {
-  ModelManager::ModelManager(Device& device, Coordinator& ecs) :
+  ModelManager::ModelManager(Device& device, Coordinator& ecs, ThreadPool& threadPool) :
       m_device{device},
-      m_ecs{ecs}
+      m_ecs{ecs},
+      m_threadPool{threadPool}
   {
+    Model::Builder builder{placeholderBuilder()};
+    m_placeholder = std::make_unique<Model>(m_device, builder);
   }
 
   ModelManager::~ModelManager()
   {
-    m_models.clear();
+    for(auto& task : m_tasks)
+      task.wait();
+
+    m_upload.reset(); // waits for its fence
+    m_retired.clear();
+    m_slots.clear();
   }
 
-  void ModelManager::give(Model::Builder builder, std::vector<EntityID> entities)
+  auto ModelManager::load(std::filesystem::path path, std::vector<EntityID> entities) -> Handle
   {
-    assert("Empty model (no vertices)" && builder.vertices.size() > 0);
-    m_modelBuilders.push_back({builder, entities});
+    auto key{std::filesystem::weakly_canonical(path).string()};
+
+    Handle handle{};
+    if(auto it{m_pathSlots.find(key)}; it != m_pathSlots.end()) {
+      handle = {it->second};
+    } else {
+      handle = createSlot(path);
+      m_pathSlots.emplace(key, handle.index);
+    }
+
+    if(Slot& slot{m_slots[handle.index]}; !slot.model && !slot.loading)
+      startLoad(handle.index);
+
+    for(auto& entity : entities)
+      acquire(handle, entity);
+
+    return handle;
   }
 
-  void ModelManager::createModels()
+  auto ModelManager::give(Model::Builder builder, std::vector<EntityID> entities) -> Handle
   {
-    //TODO: vkFlushMappedMemoryRanges();
+    assert("Empty model (no vertices)" && builder.vertexData().size() > 0);
+
+    if(!builder.contentHash)
+      builder.computeContentHash();
+
+    if(m_shortIndices)
+      builder.shortenIndices();
+
+    if(m_compactVertices)
+      builder.compact();
+
+    if(m_vertexLayout == Model::VertexLayout::split)
+      builder.splitStreams();
+
+    Handle handle{createSlot({})};
+    m_slots[handle.index].loading = true;
 
-    for(auto& builder : m_modelBuilders)
     {
-      m_models.emplace_back(m_device, builder);
-      for(auto& e : builder.entities)
-      {
-        auto& c{m_ecs.getComponent<cmp::Common>(e)};
-        c.setModel(&m_models.back());
+      std::lock_guard lock{m_mutex};
+      m_loaded.push_back({handle.index, std::move(builder)});
+    }
+
+    for(auto& entity : entities)
+      acquire(handle, entity);
+
+    return handle;
+  }
+
+  auto ModelManager::createSlot(std::filesystem::path path) -> Handle
+  {
+    Handle handle{static_cast<uint32_t>(m_slots.size())};
+    m_slots.push_back({.path = std::move(path), .lastUsed = m_frame});
+
+    return handle;
+  }
+
+  void ModelManager::startLoad(uint32_t slot)
+  {
+    m_slots[slot].loading = true;
+
+    m_tasks.push_back(m_threadPool.submit([this, path = m_slots[slot].path, slot, compactVertices = m_compactVertices, shortIndices = m_shortIndices, layout = m_vertexLayout]() {
+      std::optional<Model::Builder> builder;
+
+      try {
+        builder.emplace(path, &m_threadPool);
+        if(builder->vertexData().empty())
+          throw std::runtime_error("Empty model (no vertices): " + path.string());
+
+        if(shortIndices)
+          builder->shortenIndices();
+
+        if(compactVertices)
+          builder->compact();
+
+        if(layout == Model::VertexLayout::split)
+          builder->splitStreams();
+      } catch(const std::exception& e) {
+        // the entities keep the placeholder
+        std::cerr << clr::red << "[ModelManager] " << clr::white << e.what() << std::endl;
+        builder.reset();
       }
+
+      std::lock_guard lock{m_mutex};
+      m_loaded.push_back({slot, std::move(builder)});
+    }));
+  }
+
+  void ModelManager::acquire(Handle handle, EntityID entity)
+  {
+    if(auto it{m_entitySlots.find(entity)}; it != m_entitySlots.end()) {
+      if(it->second == handle.index)
+        return;
+
+      release(entity);
     }
 
-    m_modelBuilders.clear();
+    Slot& slot{m_slots[handle.index]};
+    slot.entities.push_back(entity);
+    m_entitySlots.emplace(entity, handle.index);
+
+    // evicted meanwhile
+    if(!slot.model && !slot.loading && !slot.path.empty())
+      startLoad(handle.index);
+
+    m_ecs.getComponent<cmp::Common>(entity).setModel(slot.model ? slot.model.get() : m_placeholder.get());
+  }
+
+  void ModelManager::release(EntityID entity)
+  {
+    auto it{m_entitySlots.find(entity)};
+    if(it == m_entitySlots.end())
+      return;
+
+    Slot& slot{m_slots[it->second]};
+    std::erase(slot.entities, entity);
+    if(slot.entities.empty())
+      slot.lastUsed = m_frame;
+
+    m_entitySlots.erase(it);
+    m_ecs.getComponent<cmp::Common>(entity).setModel(nullptr);
+  }
+
+  void ModelManager::update()
+  {
+    VKE_PROFILE_FUNCTION();
+
+    ++m_frame;
+
+    std::erase_if(m_tasks, [](const std::future<void>& task) {
+      return task.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+    });
+
+    // a single batch in flight, whatever finished meanwhile goes into the next one
+    if(m_upload && m_upload->batch->isComplete())
+      finishUpload();
+
+    if(!m_upload)
+      startUpload();
+
+    evict();
+
+    while(!m_retired.empty() && m_retired.front().frame + m_framesInFlight < m_frame)
+      m_retired.pop_front();
   }
 
-  Model& ModelManager::get(EntityID entity)
+  void ModelManager::startUpload()
   {
-    throw std::runtime_error("unimplemented function");
+    std::vector<Loaded> loaded;
+    {
+      std::lock_guard lock{m_mutex};
+      loaded.swap(m_loaded);
+    }
+
+    if(loaded.empty())
+      return;
+
+    Upload upload{.batch = std::make_unique<UploadBatch>(m_device)};
+
+    for(auto& [index, builder] : loaded) {
+      Slot& slot{m_slots[index]};
+      if(!builder) {
+        slot.loading = false;
+        continue;
+      }
+
+      // same content under another path (or twice in this batch), nothing to upload
+      slot.contentKey = contentKey(*builder);
+      std::shared_ptr<Model> model;
+      if(auto it{m_contents.find(slot.contentKey)}; it != m_contents.end())
+        model = it->second.lock();
+
+      if(!model) {
+        model = std::make_shared<Model>(m_device, *builder, upload.batch.get());
+        m_contents[slot.contentKey] = model;
+        m_residentMemory += model->memorySize();
+      }
+
+      upload.models.emplace_back(index, std::move(model));
+    }
+
+    // the builders (and their mapped files) can go once the data sits in the staging buffer
+    upload.batch->submit();
+    m_upload = std::move(upload);
+  }
+
+  void ModelManager::finishUpload()
+  {
+    for(auto& [index, model] : m_upload->models) {
+      Slot& slot{m_slots[index]};
+      slot.model = model;
+      slot.loading = false;
+
+      if(slot.entities.empty())
+        slot.lastUsed = m_frame;
+
+      for(auto& entity : slot.entities)
+        m_ecs.getComponent<cmp::Common>(entity).setModel(model.get());
+    }
+
+    m_upload.reset();
+  }
+
+  // least recently used first. a model is shared by every slot with its content, it can go once none of them is
+  // referenced by an entity and all of them can load it again
+  void ModelManager::evict()
+  {
+    if(m_residentMemory <= m_memoryBudget)
+      return;
+
+    struct Candidate
+    {
+      Model* model{};
+      uint64_t lastUsed{};
+      bool evictable{true};
+    };
+
+    std::unordered_map<uint64_t, Candidate> candidates;
+    for(const Slot& slot : m_slots) {
+      if(!slot.model)
+        continue;
+
+      Candidate& candidate{candidates[slot.contentKey]};
+      candidate.model = slot.model.get();
+      candidate.lastUsed = std::max(candidate.lastUsed, slot.lastUsed);
+      candidate.evictable &= slot.entities.empty() && !slot.path.empty();
+    }
+
+    // the batch in flight hands them to more slots
+    if(m_upload) {
+      for(const auto& [index, model] : m_upload->models) {
+        if(auto it{candidates.find(m_slots[index].contentKey)}; it != candidates.end())
+          it->second.evictable = false;
+      }
+    }
+
+    std::vector<std::pair<uint64_t, uint64_t>> order; // last use, content key
+    for(const auto& [key, candidate] : candidates) {
+      if(candidate.evictable)
+        order.emplace_back(candidate.lastUsed, key);
+    }
+    std::ranges::sort(order);
+
+    for(const auto& [lastUsed, key] : order) {
+      if(m_residentMemory <= m_memoryBudget)
+        break;
+
+      m_residentMemory -= candidates[key].model->memorySize();
+      m_contents.erase(key);
+
+      // frames still in flight may draw it
+      for(Slot& slot : m_slots) {
+        if(slot.model && slot.contentKey == key)
+          m_retired.push_back({std::move(slot.model), m_frame});
+      }
+    }
+  }
+
+  void ModelManager::waitIdle()
+  {
+    for(auto& task : m_tasks)
+      task.wait();
+    m_tasks.clear();
+
+    while(true) {
+      if(m_upload)
+        m_upload->batch->wait();
+
+      update();
+
+      if(!m_upload)
+        break;
+    }
+  }
+
+  bool ModelManager::isReady(Handle handle) const
+  {
+    return m_slots[handle.index].model != nullptr;
+  }
+
+  auto ModelManager::get(Handle handle) -> Model&
+  {
+    Model* model{m_slots[handle.index].model.get()};
+    return model ? *model : *m_placeholder;
+  }
+
+  auto ModelManager::get(EntityID entity) -> Model&
+  {
+    Model* model{m_ecs.getComponent<cmp::Common>(entity).model()};
+    return model ? *model : *m_placeholder;
+  }
+
+  auto ModelManager::contentKey(const Model::Builder& builder) -> uint64_t
+  {
+    size_t seed{};
+    hash_combine(&seed, builder.contentHash, builder.vertexData().size(), builder.indexData().size(), builder.format, builder.layout, builder.indexType);
+    return seed;
+  }
+
+  // unit cube, flat normals, grey
+  auto ModelManager::placeholderBuilder() -> Model::Builder
+  {
+    Model::Builder builder{};
+
+    constexpr glm::vec3 color{0.5f};
+    for(int axis{}; axis < 3; ++axis) {
+      for(float sign : {-1.f, 1.f}) {
+        glm::vec3 normal{};
+        normal[axis] = sign;
+
+        glm::vec3 u{};
+        glm::vec3 v{};
+        u[(axis + 1) % 3] = 0.5f;
+        v[(axis + 2) % 3] = 0.5f * sign; // keeps the winding consistent on both sides
+
+        auto first{static_cast<uint32_t>(builder.vertices.size())};
+        glm::vec3 center{normal * 0.5f};
+        builder.vertices.push_back({center - u - v, color, normal, {0.f, 0.f}});
+        builder.vertices.push_back({center + u - v, color, normal, {1.f, 0.f}});
+        builder.vertices.push_back({center + u + v, color, normal, {1.f, 1.f}});
+        builder.vertices.push_back({center - u + v, color, normal, {0.f, 1.f}});
+
+        for(uint32_t index : {0u, 1u, 2u, 0u, 2u, 3u})
+          builder.indices.push_back(first + index);
+      }
+    }
+
+    builder.computeBounds();
+    return builder;
   }
 } // namespace vke
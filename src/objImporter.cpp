@@ -0,0 +1,466 @@
+#define TINYOBJLOADER_IMPLEMENTATION
+#include "objImporter.hpp"
+#include "meshCache.hpp"
+
+namespace vke
+{
+  namespace
+  {
+    bool isSpace(char c)
+    {
+      return c == ' ' || c == '\t' || c == '\r';
+    }
+
+    auto skipSpaces(const char* p, const char* end) -> const char*
+    {
+      while(p < end && isSpace(*p))
+        ++p;
+      return p;
+    }
+
+    // from_chars takes neither leading whitespace nor '+'
+    bool readFloat(const char** p, const char* end, float* value)
+    {
+      const char* first{skipSpaces(*p, end)};
+      if(first < end && *first == '+')
+        ++first;
+
+      auto [last, error]{std::from_chars(first, end, *value)};
+      if(error != std::errc{})
+        return false;
+
+      *p = last;
+      return true;
+    }
+
+    bool readInt(const char** p, const char* end, int32_t* value)
+    {
+      auto [last, error]{std::from_chars(*p, end, *value)};
+      if(error != std::errc{})
+        return false;
+
+      *p = last;
+      return true;
+    }
+
+    // -0.f == 0.f, so both have to land in the same bucket
+    auto hashVertex(const Model::Vertex& vertex) -> uint64_t
+    {
+      static_assert(sizeof(Model::Vertex) == 11 * sizeof(float));
+
+      float values[11];
+      std::memcpy(values, &vertex, sizeof(values));
+
+      uint64_t hash{0xcbf29ce484222325};
+      for(float value : values) {
+        uint32_t bits{};
+        if(value != 0.f)
+          std::memcpy(&bits, &value, sizeof(bits));
+
+        hash = (hash ^ bits) * 0x9e3779b97f4a7c15;
+        hash ^= hash >> 32;
+      }
+
+      return hash;
+    }
+  } // namespace
+
+  ObjImporter::ObjImporter(ThreadPool* threadPool) :
+    m_threadPool{threadPool}
+  {
+  }
+
+  void ObjImporter::import(const std::filesystem::path& path, Model::Builder* builder)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    MappedFile file{path};
+    std::string_view text{reinterpret_cast<const char*>(file.bytes().data()), file.size()};
+
+    std::vector<Chunk> chunks{split(text)};
+
+    parallelFor(chunks.size(), [&chunks](uint32_t i) {
+      VKE_PROFILE_ZONE("ObjImporter::parse");
+      parse(&chunks[i]);
+    });
+
+    uint32_t positionCount{};
+    uint32_t normalCount{};
+    uint32_t uvCount{};
+    uint32_t cornerCount{};
+    for(auto& chunk : chunks) {
+      chunk.positionOffset = positionCount;
+      chunk.normalOffset = normalCount;
+      chunk.uvOffset = uvCount;
+      chunk.cornerOffset = cornerCount;
+
+      positionCount += chunk.positions.size();
+      normalCount += chunk.normals.size();
+      uvCount += chunk.uvs.size();
+      cornerCount += chunk.corners.size();
+    }
+
+    std::vector<glm::vec3> positions(positionCount);
+    std::vector<glm::vec3> colors(positionCount);
+    std::vector<glm::vec3> normals(normalCount);
+    std::vector<glm::vec2> uvs(uvCount);
+
+    parallelFor(chunks.size(), [&](uint32_t i) {
+      auto& chunk{chunks[i]};
+      std::ranges::copy(chunk.positions, positions.begin() + chunk.positionOffset);
+      std::ranges::copy(chunk.colors, colors.begin() + chunk.positionOffset);
+      std::ranges::copy(chunk.normals, normals.begin() + chunk.normalOffset);
+      std::ranges::copy(chunk.uvs, uvs.begin() + chunk.uvOffset);
+    });
+
+    // every corner as a full vertex, welded below
+    std::vector<Model::Vertex> corners(cornerCount);
+
+    parallelFor(chunks.size(), [&](uint32_t i) {
+      VKE_PROFILE_ZONE("ObjImporter::resolve");
+
+      auto& chunk{chunks[i]};
+
+      auto resolve{[](int32_t index, bool relative, uint32_t offset, size_t count) -> int64_t {
+        int64_t resolved{relative ? int64_t{offset} + index : index};
+        if(resolved >= int64_t(count) || (relative && resolved < 0))
+          throw std::runtime_error("Failed to import obj, face index out of range");
+        return resolved;
+      }};
+
+      // quads were emitted as 0 1 2, 0 2 3. like tinyobjloader, split along 1 3 when that's shorter
+      for(uint32_t quad : chunk.quads) {
+        Corner* c{&chunk.corners[quad]};
+        Corner q[4]{c[0], c[1], c[2], c[5]};
+
+        auto position{[&](const Corner& corner) {
+          return positions[resolve(corner.position, corner.relative & 1, chunk.positionOffset, positions.size())];
+        }};
+
+        glm::vec3 e02{position(q[2]) - position(q[0])};
+        glm::vec3 e13{position(q[3]) - position(q[1])};
+        if(glm::dot(e13, e13) < glm::dot(e02, e02)) {
+          c[0] = q[0], c[1] = q[1], c[2] = q[3];
+          c[3] = q[1], c[4] = q[2], c[5] = q[3];
+        }
+      }
+
+      for(size_t j{}; j < chunk.corners.size(); ++j) {
+        const Corner& corner{chunk.corners[j]};
+        Model::Vertex& vertex{corners[chunk.cornerOffset + j]};
+
+        int64_t position{resolve(corner.position, corner.relative & 1, chunk.positionOffset, positions.size())};
+        if(position < 0)
+          throw std::runtime_error("Failed to import obj, face corner without a position");
+
+        vertex.position = positions[position];
+        vertex.color = colors[position];
+
+        if(int64_t uv{resolve(corner.uv, corner.relative & 2, chunk.uvOffset, uvs.size())}; uv >= 0)
+          vertex.uv = uvs[uv];
+
+        if(int64_t normal{resolve(corner.normal, corner.relative & 4, chunk.normalOffset, normals.size())}; normal >= 0)
+          vertex.normal = normals[normal];
+      }
+
+      // the text and the per chunk data aren't needed anymore
+      chunk = {};
+    });
+
+    // welding: every corner lands in the slot of its vertex value, the slot keeps the lowest corner index.
+    // the surviving corners, in order, are exactly the first occurrences the serial dedup would keep.
+    // slots store index + 1, zero is empty so the table comes zeroed for free
+    size_t tableSize{std::bit_ceil(std::max<size_t>(size_t{cornerCount} * 2, 2))};
+    size_t mask{tableSize - 1};
+    auto table{std::make_unique<std::atomic<uint32_t>[]>(tableSize)};
+    std::vector<uint32_t> slots(cornerCount);
+
+    uint32_t blockCount{(cornerCount + weldBlockSize - 1) / weldBlockSize};
+    auto blockRange{[cornerCount](uint32_t block) {
+      uint32_t first{block * weldBlockSize};
+      return std::pair{first, std::min(first + weldBlockSize, cornerCount)};
+    }};
+
+    parallelFor(blockCount, [&](uint32_t block) {
+      VKE_PROFILE_ZONE("ObjImporter::weld");
+
+      auto [first, last]{blockRange(block)};
+      for(uint32_t i{first}; i < last; ++i) {
+        size_t slot{hashVertex(corners[i]) & mask};
+
+        while(true) {
+          uint32_t current{table[slot].load(std::memory_order_acquire)};
+
+          if(!current) {
+            if(table[slot].compare_exchange_weak(current, i + 1, std::memory_order_acq_rel))
+              break;
+            continue; // lost the race, look at the winner
+          }
+
+          // a slot only ever holds corners of one vertex value, so this can only lower it
+          if(corners[current - 1] == corners[i]) {
+            while(i + 1 < current && !table[slot].compare_exchange_weak(current, i + 1, std::memory_order_acq_rel)) {
+            }
+            break;
+          }
+
+          slot = (slot + 1) & mask;
+        }
+
+        slots[i] = slot;
+      }
+    });
+
+    auto owner{[&](uint32_t i) { return table[slots[i]].load(std::memory_order_relaxed) - 1; }};
+
+    // corners owning their slot become the unique vertices, numbered through a prefix sum over the blocks
+    std::vector<uint32_t> blockOffsets(blockCount);
+
+    parallelFor(blockCount, [&](uint32_t block) {
+      auto [first, last]{blockRange(block)};
+      for(uint32_t i{first}; i < last; ++i)
+        blockOffsets[block] += owner(i) == i;
+    });
+
+    uint32_t uniqueCount{std::accumulate(blockOffsets.begin(), blockOffsets.end(), 0u)};
+    std::exclusive_scan(blockOffsets.begin(), blockOffsets.end(), blockOffsets.begin(), 0u);
+
+    builder->vertices.resize(uniqueCount);
+    builder->indices.resize(cornerCount);
+    std::vector<uint32_t> remap(cornerCount);
+
+    parallelFor(blockCount, [&](uint32_t block) {
+      auto [first, last]{blockRange(block)};
+      uint32_t next{blockOffsets[block]};
+      for(uint32_t i{first}; i < last; ++i) {
+        if(owner(i) == i) {
+          remap[i] = next;
+          builder->vertices[next++] = corners[i];
+        }
+      }
+    });
+
+    parallelFor(blockCount, [&](uint32_t block) {
+      auto [first, last]{blockRange(block)};
+      for(uint32_t i{first}; i < last; ++i)
+        builder->indices[i] = remap[owner(i)];
+    });
+  }
+
+  void ObjImporter::importReference(const std::filesystem::path& path, Model::Builder* builder)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    tinyobj::attrib_t attrib{};             // position, color, normal and texture coordinate data
+    std::vector<tinyobj::shape_t> shapes{}; // index values for each face element
+    std::vector<tinyobj::material_t> materials{};
+    std::string warn{}, err{};
+
+    if(!tinyobj::LoadObj(&attrib, &shapes, &materials, &warn, &err, path.c_str())) {
+      throw std::runtime_error("[Failed to load model]" + warn + err);
+    }
+
+    builder->vertices.clear();
+    builder->indices.clear();
+
+    std::unordered_map<Model::Vertex, uint32_t> uniqueVertices{};
+    for(auto const& shape : shapes) {
+      for(auto const& index : shape.mesh.indices) {
+        Model::Vertex vertex{};
+
+        // inexistent if -1
+        if(index.vertex_index >= 0) {
+          // each vertexertex has 3 packed values
+          vertex.position = {
+            attrib.vertices[3 * index.vertex_index + 0],
+            attrib.vertices[3 * index.vertex_index + 1],
+            attrib.vertices[3 * index.vertex_index + 2],
+          };
+
+          // .obj doesn't support colors. This is possible through an unofficial extension for the file format, that puts RGB values after the XYZ vertex positions.
+
+          // attrib.color is always initialized to be the same size as attrib.vertices and filled with ones wherever a color is not provided in the obj file
+          vertex.color = {
+            attrib.colors[3 * index.vertex_index + 0],
+            attrib.colors[3 * index.vertex_index + 1],
+            attrib.colors[3 * index.vertex_index + 2],
+          };
+        }
+
+        if(index.normal_index >= 0) {
+          vertex.normal = {
+            attrib.normals[3 * index.normal_index + 0],
+            attrib.normals[3 * index.normal_index + 1],
+            attrib.normals[3 * index.normal_index + 2],
+          };
+        }
+
+        if(index.texcoord_index >= 0) {
+          vertex.uv = {
+            attrib.texcoords[2 * index.texcoord_index + 0],
+            attrib.texcoords[2 * index.texcoord_index + 1],
+          };
+        }
+
+        // For every vertex of the loaded file we check if he already exists on the map. If not then its index in the builder vertices vector is added to the map.
+        if(!uniqueVertices.contains(vertex)) {
+          uniqueVertices[vertex] = builder->vertices.size();
+          builder->vertices.push_back(vertex);
+        }
+
+        // Those unique indexes are then pushed into the indices vector.
+        builder->indices.push_back(uniqueVertices[vertex]);
+      }
+    }
+  }
+
+  // chunks end right after a newline, so no line is ever split
+  auto ObjImporter::split(std::string_view text) const -> std::vector<Chunk>
+  {
+    size_t threadCount{m_threadPool ? m_threadPool->size() + 1 : 1};
+    size_t chunkSize{std::max(minChunkSize, text.size() / (threadCount * 4) + 1)};
+
+    std::vector<Chunk> chunks;
+    size_t begin{};
+    while(begin < text.size()) {
+      size_t end{std::min(begin + chunkSize, text.size())};
+      if(end < text.size()) {
+        size_t newline{text.find('\n', end)};
+        end = newline == std::string_view::npos ? text.size() : newline + 1;
+      }
+
+      chunks.push_back({.text = text.substr(begin, end - begin)});
+      begin = end;
+    }
+
+    return chunks;
+  }
+
+  void ObjImporter::parse(Chunk* chunk)
+  {
+    // rough guess from the text size, saves most of the regrowth
+    size_t lines{chunk->text.size() / 32};
+    chunk->positions.reserve(lines / 2);
+    chunk->colors.reserve(lines / 2);
+    chunk->corners.reserve(lines * 3 / 2);
+
+    std::vector<Corner> polygon;
+
+    const char* p{chunk->text.data()};
+    const char* end{p + chunk->text.size()};
+    while(p < end) {
+      auto lineEnd{static_cast<const char*>(std::memchr(p, '\n', end - p))};
+      if(!lineEnd)
+        lineEnd = end;
+
+      parseLine(p, lineEnd, chunk, &polygon);
+      p = lineEnd + 1;
+    }
+  }
+
+  void ObjImporter::parseLine(const char* p, const char* end, Chunk* chunk, std::vector<Corner>* polygon)
+  {
+    p = skipSpaces(p, end);
+    if(end - p < 3) // shortest useful line is "f 1"
+      return;
+
+    if(p[0] == 'v' && isSpace(p[1])) {
+      p += 1;
+
+      // missing components read as 0, like tinyobjloader
+      glm::vec3 position{};
+      readFloat(&p, end, &position.x) && readFloat(&p, end, &position.y) && readFloat(&p, end, &position.z);
+      chunk->positions.push_back(position);
+
+      // the unofficial vertex color extension, white otherwise
+      glm::vec3 color{};
+      if(!(readFloat(&p, end, &color.x) && readFloat(&p, end, &color.y) && readFloat(&p, end, &color.z)))
+        color = glm::vec3{1.f};
+      chunk->colors.push_back(color);
+      return;
+    }
+
+    if(p[0] == 'v' && p[1] == 'n' && isSpace(p[2])) {
+      p += 2;
+
+      glm::vec3 normal{};
+      readFloat(&p, end, &normal.x) && readFloat(&p, end, &normal.y) && readFloat(&p, end, &normal.z);
+      chunk->normals.push_back(normal);
+      return;
+    }
+
+    if(p[0] == 'v' && p[1] == 't' && isSpace(p[2])) {
+      p += 2;
+
+      glm::vec2 uv{};
+      readFloat(&p, end, &uv.x) && readFloat(&p, end, &uv.y);
+      chunk->uvs.push_back(uv);
+      return;
+    }
+
+    if(p[0] != 'f' || !isSpace(p[1]))
+      return;
+
+    p += 1;
+    polygon->clear();
+
+    // 0 based when absolute, otherwise relative to what the chunk read so far
+    auto toIndex{[](int32_t value, size_t count, uint8_t bit, Corner* corner) -> int32_t {
+      if(value > 0)
+        return value - 1;
+      if(value == 0)
+        throw std::runtime_error("Failed to import obj, face index 0");
+
+      corner->relative |= bit;
+      return static_cast<int32_t>(count) + value;
+    }};
+
+    while((p = skipSpaces(p, end)) < end) {
+      Corner corner{};
+
+      int32_t value{};
+      if(!readInt(&p, end, &value))
+        break;
+      corner.position = toIndex(value, chunk->positions.size(), 1, &corner);
+
+      if(p < end && *p == '/') {
+        ++p;
+        if(readInt(&p, end, &value))
+          corner.uv = toIndex(value, chunk->uvs.size(), 2, &corner);
+
+        if(p < end && *p == '/') {
+          ++p;
+          if(readInt(&p, end, &value))
+            corner.normal = toIndex(value, chunk->normals.size(), 4, &corner);
+        }
+      }
+
+      polygon->push_back(corner);
+
+      // skip anything we don't understand up to the next corner
+      while(p < end && !isSpace(*p))
+        ++p;
+    }
+
+    // the diagonal of a quad is picked once positions are resolved, see import()
+    if(polygon->size() == 4)
+      chunk->quads.push_back(chunk->corners.size());
+
+    for(size_t i{1}; i + 1 < polygon->size(); ++i) {
+      chunk->corners.push_back((*polygon)[0]);
+      chunk->corners.push_back((*polygon)[i]);
+      chunk->corners.push_back((*polygon)[i + 1]);
+    }
+  }
+
+  void ObjImporter::parallelFor(uint32_t count, const std::function<void(uint32_t)>& body)
+  {
+    if(m_threadPool) {
+      m_threadPool->parallelFor(count, body);
+      return;
+    }
+
+    for(uint32_t i{}; i < count; ++i)
+      body(i);
+  }
+} // namespace vke
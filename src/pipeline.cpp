@@ -12,6 +12,12 @@ namespace vke
     createPipeline(shaderPaths, config);
   }
 
+  Pipeline::Pipeline(Device& device, VkShaderModule vertModule, VkShaderModule fragModule, const Config& config) :
+      m_device{device}
+  {
+    createPipeline(vertModule, fragModule, config);
+  }
+
   Pipeline::~Pipeline()
   {
     // vkDestroyDescriptorSetLayout(m_device, m_descriptorSetLayout, nullptr);
@@ -19,7 +25,7 @@ namespace vke
     vkDestroyPipeline(m_device, m_pipeline, nullptr);
   }
 
-  void Pipeline::defaultConfig(VkExtent2D extent, bool fullscreen, Config* config)
+  void Pipeline::defaultConfig(Config* config)
   {
     config->attributeDescriptions.reserve(2);
     config->bindingDescriptions.reserve(2);
@@ -93,45 +99,25 @@ namespace vke
       .maxDepthBounds = 1.f, //optional
     };
 
-    if(fullscreen)
-    {
-      config->dynamicStateEnables = {
-        VK_DYNAMIC_STATE_VIEWPORT,
-      };
+    // set by RenderGraph::execute for every pass
+    config->dynamicStateEnables = {
+      VK_DYNAMIC_STATE_VIEWPORT,
+      VK_DYNAMIC_STATE_SCISSOR,
+    };
+
+    config->dynamicState = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
+      .dynamicStateCount = static_cast<uint32_t>(config->dynamicStateEnables.size()),
+      .pDynamicStates = config->dynamicStateEnables.data(),
+    };
 
-      config->dynamicState = {
-        .dynamicStateCount = static_cast<uint32_t>(config->dynamicStateEnables.size()),
-        .pDynamicStates = config->dynamicStateEnables.data(),
-      };
-    }
-    else
-    {
-      config->dynamicState = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO,
-      };
-
-      config->viewport = {
-        .x = 0.0f,
-        .y = 0.0f,
-        .width = static_cast<float>(extent.width),
-        .height = static_cast<float>(extent.height),
-        .minDepth = 0.0f,
-        .maxDepth = 1.0f,
-      };
-
-      config->scissor = {
-        .offset = {0, 0},
-        .extent = extent,
-      };
-
-      config->viewportState = {
-        .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
-        .viewportCount = 1,
-        .pViewports = &config->viewport,
-        .scissorCount = 1,
-        .pScissors = &config->scissor,
-      };
-    }
+    config->viewportState = {
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO,
+      .viewportCount = 1,
+      .pViewports = nullptr,
+      .scissorCount = 1,
+      .pScissors = nullptr,
+    };
   }
 
   void Pipeline::createPipeline(const ShaderPaths& shaderPaths, const Config& config)
@@ -140,14 +126,24 @@ namespace vke
     // std::vector<char> fragShaderCode{readFile("build/shaders/shader.frag.spv")};
 
     std::vector<char> vertShaderCode{readFile(shaderPaths.vert)};
-    std::vector<char> fragShaderCode{readFile(shaderPaths.frag)};
 
     VkShaderModule vertShaderModule;
-    VkShaderModule fragShaderModule;
+    VkShaderModule fragShaderModule{VK_NULL_HANDLE};
 
     createShaderModule(vertShaderCode, &vertShaderModule);
-    createShaderModule(fragShaderCode, &fragShaderModule);
+    if(!shaderPaths.frag.empty()) {
+      std::vector<char> fragShaderCode{readFile(shaderPaths.frag)};
+      createShaderModule(fragShaderCode, &fragShaderModule);
+    }
+
+    createPipeline(vertShaderModule, fragShaderModule, config);
 
+    vkDestroyShaderModule(m_device, vertShaderModule, nullptr);
+    vkDestroyShaderModule(m_device, fragShaderModule, nullptr);
+  }
+
+  void Pipeline::createPipeline(VkShaderModule vertShaderModule, VkShaderModule fragShaderModule, const Config& config)
+  {
     VkPipelineShaderStageCreateInfo shaderStages[]{
       {
         .sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO,
@@ -173,7 +169,7 @@ namespace vke
 
     VkGraphicsPipelineCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO,
-      .stageCount = std::size(shaderStages),
+      .stageCount = fragShaderModule ? 2u : 1u, // depth only pipelines have no fragment shader
       .pStages = shaderStages,
       .pVertexInputState = &vertexInput,
       .pInputAssemblyState = &config.inputAssembly,
@@ -191,11 +187,9 @@ namespace vke
       .basePipelineIndex = -1,
     };
 
-    if(vkCreateGraphicsPipelines(m_device, VK_NULL_HANDLE, 1, &createInfo, nullptr, &m_pipeline))
+    // the pipeline cache is internally synchronized, this can run on several threads
+    if(vkCreateGraphicsPipelines(m_device, m_device.pipelineCache(), 1, &createInfo, nullptr, &m_pipeline))
       throw std::runtime_error("Failed to create pipeline");
-
-    vkDestroyShaderModule(m_device, vertShaderModule, nullptr);
-    vkDestroyShaderModule(m_device, fragShaderModule, nullptr);
   }
 
   void Pipeline::createShaderModule(std::vector<char>& buffer, VkShaderModule* module)
@@ -240,15 +234,11 @@ namespace vke
 
   Pipeline::Config& Pipeline::Config::operator=(const Config& other)
   {
-    viewport = other.viewport;
-    scissor = other.scissor;
     bindingDescriptions = other.bindingDescriptions;
     attributeDescriptions = other.attributeDescriptions;
     inputAssembly = other.inputAssembly;
 
     viewportState = other.viewportState;
-    viewportState.pViewports = &viewport;
-    viewportState.pScissors = &scissor;
 
     rasterization = other.rasterization;
     multisample = other.multisample;
@@ -274,4 +264,102 @@ namespace vke
   {
     *this = other;
   }
+
+  auto Pipeline::Config::hash() const -> size_t
+  {
+    size_t seed{};
+
+    for(const auto& binding : bindingDescriptions)
+      hash_combine(&seed, binding.binding, binding.stride, static_cast<uint32_t>(binding.inputRate));
+
+    for(const auto& attribute : attributeDescriptions)
+      hash_combine(&seed, attribute.location, attribute.binding, static_cast<uint32_t>(attribute.format), attribute.offset);
+
+    hash_combine(&seed,
+      static_cast<uint32_t>(inputAssembly.topology), inputAssembly.primitiveRestartEnable,
+      viewportState.viewportCount, viewportState.scissorCount);
+
+    hash_combine(&seed,
+      rasterization.depthClampEnable, rasterization.rasterizerDiscardEnable, static_cast<uint32_t>(rasterization.polygonMode),
+      rasterization.cullMode, static_cast<uint32_t>(rasterization.frontFace), rasterization.depthBiasEnable,
+      rasterization.depthBiasConstantFactor, rasterization.depthBiasClamp, rasterization.depthBiasSlopeFactor, rasterization.lineWidth);
+
+    hash_combine(&seed,
+      static_cast<uint32_t>(multisample.rasterizationSamples), multisample.sampleShadingEnable, multisample.minSampleShading,
+      multisample.alphaToCoverageEnable, multisample.alphaToOneEnable);
+
+    auto hashStencil{[&seed](const VkStencilOpState& op) {
+      hash_combine(&seed,
+        static_cast<uint32_t>(op.failOp), static_cast<uint32_t>(op.passOp), static_cast<uint32_t>(op.depthFailOp),
+        static_cast<uint32_t>(op.compareOp), op.compareMask, op.writeMask, op.reference);
+    }};
+
+    hash_combine(&seed,
+      depthStencil.depthTestEnable, depthStencil.depthWriteEnable, static_cast<uint32_t>(depthStencil.depthCompareOp),
+      depthStencil.depthBoundsTestEnable, depthStencil.stencilTestEnable, depthStencil.minDepthBounds, depthStencil.maxDepthBounds);
+    hashStencil(depthStencil.front);
+    hashStencil(depthStencil.back);
+
+    hash_combine(&seed,
+      colorBlendAttachment.blendEnable,
+      static_cast<uint32_t>(colorBlendAttachment.srcColorBlendFactor), static_cast<uint32_t>(colorBlendAttachment.dstColorBlendFactor),
+      static_cast<uint32_t>(colorBlendAttachment.colorBlendOp),
+      static_cast<uint32_t>(colorBlendAttachment.srcAlphaBlendFactor), static_cast<uint32_t>(colorBlendAttachment.dstAlphaBlendFactor),
+      static_cast<uint32_t>(colorBlendAttachment.alphaBlendOp), colorBlendAttachment.colorWriteMask);
+
+    hash_combine(&seed, colorBlend.logicOpEnable, static_cast<uint32_t>(colorBlend.logicOp), colorBlend.attachmentCount);
+    for(float constant : colorBlend.blendConstants)
+      hash_combine(&seed, constant);
+
+    for(auto state : dynamicStateEnables)
+      hash_combine(&seed, static_cast<uint32_t>(state));
+
+    hash_combine(&seed, pipelineLayout, renderPass, subpass);
+
+    return seed;
+  }
+
+  bool Pipeline::Config::operator==(const Config& other) const
+  {
+    auto sameBinding{[](const VkVertexInputBindingDescription& a, const VkVertexInputBindingDescription& b) {
+      return a.binding == b.binding && a.stride == b.stride && a.inputRate == b.inputRate;
+    }};
+    auto sameAttribute{[](const VkVertexInputAttributeDescription& a, const VkVertexInputAttributeDescription& b) {
+      return a.location == b.location && a.binding == b.binding && a.format == b.format && a.offset == b.offset;
+    }};
+    auto sameStencil{[](const VkStencilOpState& a, const VkStencilOpState& b) {
+      return a.failOp == b.failOp && a.passOp == b.passOp && a.depthFailOp == b.depthFailOp && a.compareOp == b.compareOp &&
+             a.compareMask == b.compareMask && a.writeMask == b.writeMask && a.reference == b.reference;
+    }};
+
+    const auto& r{rasterization};
+    const auto& ro{other.rasterization};
+    const auto& ms{multisample};
+    const auto& mso{other.multisample};
+    const auto& ds{depthStencil};
+    const auto& dso{other.depthStencil};
+    const auto& cb{colorBlendAttachment};
+    const auto& cbo{other.colorBlendAttachment};
+
+    return std::ranges::equal(bindingDescriptions, other.bindingDescriptions, sameBinding) &&
+           std::ranges::equal(attributeDescriptions, other.attributeDescriptions, sameAttribute) &&
+           inputAssembly.topology == other.inputAssembly.topology && inputAssembly.primitiveRestartEnable == other.inputAssembly.primitiveRestartEnable &&
+           viewportState.viewportCount == other.viewportState.viewportCount && viewportState.scissorCount == other.viewportState.scissorCount &&
+           r.depthClampEnable == ro.depthClampEnable && r.rasterizerDiscardEnable == ro.rasterizerDiscardEnable && r.polygonMode == ro.polygonMode &&
+           r.cullMode == ro.cullMode && r.frontFace == ro.frontFace && r.depthBiasEnable == ro.depthBiasEnable &&
+           r.depthBiasConstantFactor == ro.depthBiasConstantFactor && r.depthBiasClamp == ro.depthBiasClamp &&
+           r.depthBiasSlopeFactor == ro.depthBiasSlopeFactor && r.lineWidth == ro.lineWidth &&
+           ms.rasterizationSamples == mso.rasterizationSamples && ms.sampleShadingEnable == mso.sampleShadingEnable &&
+           ms.minSampleShading == mso.minSampleShading && ms.alphaToCoverageEnable == mso.alphaToCoverageEnable && ms.alphaToOneEnable == mso.alphaToOneEnable &&
+           ds.depthTestEnable == dso.depthTestEnable && ds.depthWriteEnable == dso.depthWriteEnable && ds.depthCompareOp == dso.depthCompareOp &&
+           ds.depthBoundsTestEnable == dso.depthBoundsTestEnable && ds.stencilTestEnable == dso.stencilTestEnable &&
+           ds.minDepthBounds == dso.minDepthBounds && ds.maxDepthBounds == dso.maxDepthBounds && sameStencil(ds.front, dso.front) && sameStencil(ds.back, dso.back) &&
+           cb.blendEnable == cbo.blendEnable && cb.srcColorBlendFactor == cbo.srcColorBlendFactor && cb.dstColorBlendFactor == cbo.dstColorBlendFactor &&
+           cb.colorBlendOp == cbo.colorBlendOp && cb.srcAlphaBlendFactor == cbo.srcAlphaBlendFactor && cb.dstAlphaBlendFactor == cbo.dstAlphaBlendFactor &&
+           cb.alphaBlendOp == cbo.alphaBlendOp && cb.colorWriteMask == cbo.colorWriteMask &&
+           colorBlend.logicOpEnable == other.colorBlend.logicOpEnable && colorBlend.logicOp == other.colorBlend.logicOp &&
+           colorBlend.attachmentCount == other.colorBlend.attachmentCount && std::ranges::equal(colorBlend.blendConstants, other.colorBlend.blendConstants) &&
+           dynamicStateEnables == other.dynamicStateEnables &&
+           pipelineLayout == other.pipelineLayout && renderPass == other.renderPass && subpass == other.subpass;
+  }
 } // namespace vke
@@ -0,0 +1,134 @@
+#include "pipelineCache.hpp"
+#include "device.hpp"
+#include "utils.hpp"
+
+namespace vke
+{
+  PipelineCache::PipelineCache(VkDevice device, const PhysicalDeviceInfo& info, const std::filesystem::path& directory) :
+    m_device{device},
+    m_info{info}
+  {
+    const auto& properties{m_info.deviceProperties};
+
+    std::stringstream name;
+    name << std::hex << "pipelines_" << properties.vendorID << '_' << properties.deviceID << '_' << properties.driverVersion << ".bin";
+    m_path = directory / name.str();
+
+    std::vector<char> data{load()};
+    m_loaded = !data.empty();
+
+    VkPipelineCacheCreateInfo createInfo{
+      .sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO,
+      .initialDataSize = data.size(),
+      .pInitialData = data.empty() ? nullptr : data.data(),
+    };
+
+    if(vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache) != VK_SUCCESS) {
+      // a driver may still refuse data that passed validation, retry empty
+      createInfo.initialDataSize = 0;
+      createInfo.pInitialData = nullptr;
+      m_loaded = false;
+
+      if(vkCreatePipelineCache(m_device, &createInfo, nullptr, &m_cache) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create pipeline cache");
+    }
+  }
+
+  PipelineCache::~PipelineCache()
+  {
+    try {
+      save();
+    } catch(const std::exception& e) {
+      std::cerr << clr::sand << "[PipelineCache] " << clr::white << e.what() << std::endl;
+    }
+
+    vkDestroyPipelineCache(m_device, m_cache, nullptr);
+  }
+
+  void PipelineCache::save()
+  {
+    size_t size{};
+    if(vkGetPipelineCacheData(m_device, m_cache, &size, nullptr) != VK_SUCCESS || !size)
+      return;
+
+    std::vector<char> data(size);
+    if(vkGetPipelineCacheData(m_device, m_cache, &size, data.data()) != VK_SUCCESS)
+      throw std::runtime_error("Failed to get pipeline cache data");
+    data.resize(size);
+
+    FileHeader header{
+      .driverVersion = m_info.deviceProperties.driverVersion,
+      .dataSize = static_cast<uint32_t>(data.size()),
+      .checksum = checksum(data),
+    };
+
+    std::filesystem::create_directories(m_path.parent_path());
+
+    // write next to it and rename, a crash mid-write never leaves a corrupt cache behind
+    auto temporary{m_path};
+    temporary += ".tmp";
+    {
+      std::ofstream file{temporary, std::ios::binary | std::ios::trunc};
+      if(!file.is_open())
+        throw std::runtime_error("Failed to write pipeline cache: " + temporary.string());
+
+      file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+      file.write(data.data(), data.size());
+    }
+
+    std::filesystem::rename(temporary, m_path);
+  }
+
+  auto PipelineCache::load() -> std::vector<char>
+  {
+    std::ifstream file{m_path, std::ios::binary | std::ios::ate};
+    if(!file.is_open())
+      return {};
+
+    size_t fileSize = file.tellg();
+    if(fileSize < sizeof(FileHeader))
+      return {};
+
+    file.seekg(0);
+
+    FileHeader header{};
+    file.read(reinterpret_cast<char*>(&header), sizeof(header));
+
+    if(std::memcmp(header.magic, FileHeader{}.magic, sizeof(header.magic)) != 0 ||
+       header.version != FileHeader{}.version ||
+       header.driverVersion != m_info.deviceProperties.driverVersion ||
+       header.dataSize != fileSize - sizeof(FileHeader)) {
+      return {};
+    }
+
+    std::vector<char> data(header.dataSize);
+    file.read(data.data(), data.size());
+
+    if(!file || checksum(data) != header.checksum || !isCompatible(data))
+      return {};
+
+    return data;
+  }
+
+  // https://registry.khronos.org/vulkan/specs/1.3-extensions/html/vkspec.html#pipelines-cache-header
+  bool PipelineCache::isCompatible(std::span<const char> data) const
+  {
+    VkPipelineCacheHeaderVersionOne header{};
+    if(data.size() < sizeof(header))
+      return false;
+
+    std::memcpy(&header, data.data(), sizeof(header));
+
+    const auto& properties{m_info.deviceProperties};
+    return header.headerSize >= sizeof(header) &&
+           header.headerVersion == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+           header.vendorID == properties.vendorID &&
+           header.deviceID == properties.deviceID &&
+           std::memcmp(header.pipelineCacheUUID, properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+  }
+
+  auto PipelineCache::checksum(std::span<const char> data) -> uint64_t
+  {
+    return fnv1a(std::as_bytes(data));
+  }
+} // namespace vke
@@ -0,0 +1,206 @@
+#include "pipelineRegistry.hpp"
+
+namespace vke
+{
+  PipelineRegistry::PipelineRegistry(Device& device, ThreadPool& threadPool) :
+    m_device{device},
+    m_threadPool{threadPool}
+  {
+  }
+
+  PipelineRegistry::~PipelineRegistry()
+  {
+    waitIdle();
+
+    m_entries.clear();
+
+    for(auto& [path, shader] : m_shaderModules)
+      vkDestroyShaderModule(m_device, shader.module, nullptr);
+  }
+
+  auto PipelineRegistry::request(const Pipeline::ShaderPaths& shaderPaths, const Pipeline::Config& config, Mode mode, Handle fallback) -> Handle
+  {
+    Entry* entry{};
+    uint32_t index{};
+    size_t hash{};
+    VkShaderModule vert{};
+    VkShaderModule frag{};
+
+    {
+      std::lock_guard lock{m_mutex};
+
+      const ShaderModule& vertShader{shaderModule(shaderPaths.vert)};
+      const ShaderModule& fragShader{shaderPaths.frag.empty() ? ShaderModule{} : shaderModule(shaderPaths.frag)};
+      vert = vertShader.module;
+      frag = fragShader.module;
+
+      hash = config.hash();
+      hash_combine(&hash, vertShader.codeHash, fragShader.codeHash);
+
+      auto& bucket{m_buckets[hash]};
+      for(uint32_t candidate : bucket) {
+        const Key& key{m_entries[candidate].key};
+        if(key.vert == vert && key.frag == frag && key.config == config)
+          return {candidate};
+      }
+
+      index = m_entries.size();
+      entry = &m_entries.emplace_back();
+      entry->key.config = config;
+      entry->key.vert = vert;
+      entry->key.frag = frag;
+      entry->fallback = fallback;
+      bucket.push_back(index);
+    }
+
+    if(mode == Mode::blocking) {
+      try {
+        compile(*entry, vert, frag, config);
+      } catch(...) {
+        forget(hash, index);
+        throw;
+      }
+      return {index};
+    }
+
+    // Config can't be moved (it points into itself), so the task gets a shared copy
+    auto configCopy{std::make_shared<Pipeline::Config>(config)};
+    auto compilation{m_threadPool.submit([this, entry, index, hash, vert, frag, configCopy]() {
+      try {
+        compile(*entry, vert, frag, *configCopy);
+      } catch(const std::exception& e) {
+        std::cerr << clr::red << "[PipelineRegistry] " << clr::white << e.what() << std::endl;
+        forget(hash, index);
+      }
+    })};
+
+    std::lock_guard lock{m_mutex};
+    entry->compilation = compilation.share();
+
+    return {index};
+  }
+
+  void PipelineRegistry::compile(Entry& entry, VkShaderModule vert, VkShaderModule frag, const Pipeline::Config& config)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    entry.pipeline = std::make_unique<Pipeline>(m_device, vert, frag, config);
+    entry.handle.store(*entry.pipeline, std::memory_order_release);
+  }
+
+  // a failed compilation: the entry stays (its handle binds nothing, or its fallback) but can't be found again,
+  // the next request with its key tries anew
+  void PipelineRegistry::forget(size_t hash, uint32_t index)
+  {
+    std::lock_guard lock{m_mutex};
+
+    auto it{m_buckets.find(hash)};
+    if(it == m_buckets.end())
+      return;
+
+    std::erase(it->second, index);
+    if(it->second.empty())
+      m_buckets.erase(it);
+  }
+
+  // call with m_mutex held
+  auto PipelineRegistry::shaderModule(const std::filesystem::path& path) -> const ShaderModule&
+  {
+    auto [it, inserted]{m_shaderModules.try_emplace(path.string())};
+    if(!inserted)
+      return it->second;
+
+    std::vector<char> code{Pipeline::readFile(path)};
+
+    VkShaderModuleCreateInfo createInfo{
+      .sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO,
+      .codeSize = code.size(),
+      .pCode = reinterpret_cast<uint32_t*>(code.data()),
+    };
+
+    if(vkCreateShaderModule(m_device, &createInfo, nullptr, &it->second.module) != VK_SUCCESS) {
+      m_shaderModules.erase(it);
+      throw std::runtime_error("Failed to create shader module: " + path.string());
+    }
+
+    it->second.codeHash = std::hash<std::string_view>{}(std::string_view{code.data(), code.size()});
+
+    return it->second;
+  }
+
+  bool PipelineRegistry::isReady(Handle handle) const
+  {
+    std::lock_guard lock{m_mutex};
+    return handle.isValid() && m_entries[handle.index].handle.load(std::memory_order_acquire);
+  }
+
+  auto PipelineRegistry::get(Handle handle) const -> VkPipeline
+  {
+    if(!handle.isValid())
+      return VK_NULL_HANDLE;
+
+    std::lock_guard lock{m_mutex};
+    const Entry& entry{m_entries[handle.index]};
+
+    if(VkPipeline pipeline{entry.handle.load(std::memory_order_acquire)})
+      return pipeline;
+
+    // a single level, fallbacks are expected to be blocking requests
+    if(entry.fallback.isValid())
+      return m_entries[entry.fallback.index].handle.load(std::memory_order_acquire);
+
+    return VK_NULL_HANDLE;
+  }
+
+  bool PipelineRegistry::bind(VkCommandBuffer commandBuffer, Handle handle) const
+  {
+    VkPipeline pipeline{get(handle)};
+    if(!pipeline)
+      return false;
+
+    vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    return true;
+  }
+
+  void PipelineRegistry::waitIdle()
+  {
+    std::vector<std::shared_future<void>> compilations;
+
+    {
+      std::lock_guard lock{m_mutex};
+      for(const auto& entry : m_entries) {
+        if(entry.compilation.valid())
+          compilations.push_back(entry.compilation);
+      }
+    }
+
+    for(auto& compilation : compilations)
+      compilation.wait();
+  }
+
+  void PipelineRegistry::retire(VkRenderPass renderPass)
+  {
+    std::lock_guard lock{m_mutex};
+
+    for(auto& [hash, bucket] : m_buckets) {
+      std::erase_if(bucket, [this, renderPass](uint32_t index) {
+        return m_entries[index].key.config.renderPass == renderPass;
+      });
+    }
+    std::erase_if(m_buckets, [](const auto& bucket) { return bucket.second.empty(); });
+
+    // the ones still compiling are left to the destructor
+    for(auto& entry : m_entries) {
+      if(entry.key.config.renderPass == renderPass && entry.handle.load(std::memory_order_acquire)) {
+        entry.handle.store(VK_NULL_HANDLE, std::memory_order_release);
+        entry.pipeline.reset();
+      }
+    }
+  }
+
+  auto PipelineRegistry::pipelineCount() const -> size_t
+  {
+    std::lock_guard lock{m_mutex};
+    return m_entries.size();
+  }
+} // namespace vke
@@ -0,0 +1,80 @@
+#include "profiler.hpp"
+
+namespace vke::prof
+{
+  auto Profiler::instance() -> Profiler&
+  {
+    static Profiler profiler{};
+    return profiler;
+  }
+
+  Profiler::Profiler() :
+    m_startTicks{now()},
+    m_startNs{steadyNow()}
+  {
+  }
+
+  auto Profiler::registerThread() -> ThreadBuffer*
+  {
+    std::lock_guard lock{m_mutex};
+    m_buffers.push_back(std::make_unique<ThreadBuffer>(static_cast<uint32_t>(m_buffers.size())));
+    return m_buffers.back().get();
+  }
+
+  // https://docs.google.com/document/d/1CvAClvFfyA5R-PhYUmn5OOQtYMH4h6I0nSsKchNAySU
+  // complete events ("X") for zones and instant events ("i") for frame markers, timestamps in microseconds.
+  void Profiler::writeChromeTrace(const std::filesystem::path& path)
+  {
+    std::lock_guard lock{m_mutex};
+
+    std::ofstream file{path, std::ios::trunc};
+    if(!file.is_open())
+      throw std::runtime_error("Failed to open trace file " + path.string());
+
+    // zones are pushed when they close, an enclosing zone comes after the ones it holds, so the earliest begin
+    // can be anywhere in a buffer. the heads are read once, both passes then see the same events
+    std::vector<uint64_t> heads;
+    uint64_t origin{std::numeric_limits<uint64_t>::max()};
+    for(auto& buffer : m_buffers) {
+      uint64_t head{heads.emplace_back(buffer->head())};
+      for(uint64_t i{head > ThreadBuffer::capacity ? head - ThreadBuffer::capacity : 0}; i < head; ++i)
+        origin = std::min(origin, buffer->at(i).begin);
+    }
+
+    // ticks per microsecond over the whole run, so the calibration error is negligible
+    double ticksPerUs{static_cast<double>(now() - m_startTicks) / (static_cast<double>(steadyNow() - m_startNs) / 1000.0)};
+    if(!(ticksPerUs > 0.0))
+      ticksPerUs = 1000.0;
+
+    auto micros{[ticksPerUs](uint64_t ticks) { return static_cast<double>(ticks) / ticksPerUs; }};
+
+    file << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    file << std::fixed;
+    file.precision(3);
+
+    bool first{true};
+    for(size_t b{}; b < m_buffers.size(); ++b) {
+      auto& buffer{m_buffers[b]};
+      uint64_t head{heads[b]};
+      uint64_t begin{head > ThreadBuffer::capacity ? head - ThreadBuffer::capacity : 0};
+
+      for(uint64_t i{begin}; i < head; ++i) {
+        const ZoneEvent& event{buffer->at(i)};
+
+        file << (first ? "" : ",\n");
+        first = false;
+
+        // zone names are literals or __func__, no escaping needed
+        file << "{\"name\":\"" << event.name << "\",\"pid\":0,\"tid\":" << buffer->threadId()
+             << ",\"ts\":" << micros(event.begin - origin);
+
+        if(event.end == event.begin)
+          file << ",\"ph\":\"i\",\"s\":\"g\"}";
+        else
+          file << ",\"ph\":\"X\",\"dur\":" << micros(event.end - event.begin) << '}';
+      }
+    }
+
+    file << "\n]}\n";
+  }
+} // namespace vke::prof
@@ -2,21 +2,69 @@
 
 namespace vke
 {
+  namespace
+  {
+    // VKE_PRESENT_MODE: fifo (default), fifo_relaxed, mailbox or immediate
+    auto requestedPresentMode() -> VkPresentModeKHR
+    {
+      const char* name{std::getenv("VKE_PRESENT_MODE")};
+      if(!name)
+        return VK_PRESENT_MODE_FIFO_KHR;
+
+      auto presentMode{Swapchain::parsePresentMode(name)};
+      if(!presentMode)
+        std::cerr << clr::sand << "[Program] " << clr::white << "Unknown VKE_PRESENT_MODE " << name << ", using fifo" << std::endl;
+
+      return presentMode.value_or(VK_PRESENT_MODE_FIFO_KHR);
+    }
+
+    // the cycle the P key walks through, fifo_relaxed goes back to fifo
+    auto nextPresentMode(VkPresentModeKHR presentMode) -> VkPresentModeKHR
+    {
+      switch(presentMode) {
+        case VK_PRESENT_MODE_FIFO_KHR: return VK_PRESENT_MODE_MAILBOX_KHR;
+        case VK_PRESENT_MODE_MAILBOX_KHR: return VK_PRESENT_MODE_IMMEDIATE_KHR;
+        default: return VK_PRESENT_MODE_FIFO_KHR;
+      }
+    }
+
+    // VKE_FRAME_LIMIT: frames per second, unset or 0 for uncapped
+    auto requestedFrameLimit() -> double
+    {
+      const char* limit{std::getenv("VKE_FRAME_LIMIT")};
+      return limit ? std::max(std::strtod(limit, nullptr), 0.0) : 0.0;
+    }
+
+    // VKE_BINDLESS: 0 turns the bindless table off where the device supports it
+    auto requestedBindless() -> bool
+    {
+      const char* bindless{std::getenv("VKE_BINDLESS")};
+      return !bindless || std::strcmp(bindless, "0") != 0;
+    }
+
+    // VKE_DEPTH_PREPASS: 0 or 1, overrides the scene's choice
+    auto requestedDepthPrepass(bool sceneDefault) -> bool
+    {
+      const char* prepass{std::getenv("VKE_DEPTH_PREPASS")};
+      return prepass ? std::strcmp(prepass, "0") != 0 : sceneDefault;
+    }
+  } // namespace
+
   Program::Program() :
     m_eventRelayer{},
     m_window{m_eventRelayer},
     m_device{m_window, std::getenv("ROOT_PATH")},
+    m_threadPool{},
+    m_pipelineRegistry{m_device, m_threadPool},
     m_ecs{},
-    m_modelManager{m_device, m_ecs},
-    m_renderer{m_device, m_window, m_eventRelayer}
+    m_modelManager{m_device, m_ecs, m_threadPool},
+    m_textureManager{m_device, m_threadPool},
+    m_renderer{m_device, m_window, m_eventRelayer, requestedPresentMode()},
+    m_descriptors{m_device},
+    m_materials{m_device, m_renderer.layoutCache(), m_descriptors}
   {
+    m_modelManager.setFramesInFlight(m_renderer.maxFramesInFlight());
     loadEntities();
-
-    m_globalDescriptorPool =
-      DescriptorPool::Builder{m_device}
-        .setMaxDescriptorSets(m_renderer.maxFramesInFlight())
-        .addPoolSize(VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, m_renderer.maxFramesInFlight())
-        .build();
   }
 
   Program::~Program()
@@ -25,6 +73,10 @@ namespace vke
       m_ecs.destroyEntity(entity);
     }
 
+    for(auto& light : m_lights) {
+      m_ecs.destroyEntity(light);
+    }
+
     // m_model.reset();
 
     /*
@@ -55,22 +107,35 @@ namespace vke
     ////////// DescriptorSet //////////
     VkDescriptorSet globalDescriptorSet{};
 
-    auto globalSetLayout =
+    auto& globalSetLayout =
       DescriptorSetLayout::Builder{m_device}
         .addBinding(0, VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER, VK_SHADER_STAGE_ALL_GRAPHICS)
-        .build();
+        .build(m_renderer.layoutCache());
 
     auto bufferInfo{uniformBuffer.descriptorInfo()};
-    DescriptorWriter{*globalSetLayout, *m_globalDescriptorPool}
+    DescriptorWriter{globalSetLayout, m_descriptors}
       .addBuffer(0, &bufferInfo)
       .allocAndUpdate(&globalDescriptorSet);
 
+    LightClusters lightClusters{m_device, m_renderer.layoutCache(), m_renderer.maxFramesInFlight()};
+
+    std::unique_ptr<BindlessTable> bindless;
+    if(m_device.bindlessSupported() && requestedBindless())
+      bindless = std::make_unique<BindlessTable>(m_device);
+
     ////////// RenderSystem //////////
     RenderSystemContext renderSystemContext{
       .eventRelayer = m_eventRelayer,
+      .pipelineRegistry = m_pipelineRegistry,
+      .layoutCache = m_renderer.layoutCache(),
+      .materials = m_materials,
       .renderPass = m_renderer.renderPass(),
-      .extent = m_renderer.swapchainExtent(),
-      .globalDescriptorSetLayout = *globalSetLayout,
+      .depthRenderPass = m_renderer.depthRenderPass(),
+      .globalDescriptorSetLayout = globalSetLayout,
+      .lightDescriptorSetLayout = lightClusters.descriptorSetLayout(),
+      .framesInFlight = m_renderer.maxFramesInFlight(),
+      .depthPrepass = m_depthPrepass,
+      .bindless = bindless.get(),
     };
 
     RenderSystem renderSystem{m_device, renderSystemContext};
@@ -94,25 +159,77 @@ namespace vke
     scTimePoint frameEndTime{};
     TimeStep timeStep{};
 
+    // the frame being recorded, the passes draw what it describes
+    std::optional<FrameInfo> frame;
+
+    std::optional<VkClearDepthStencilValue> depthClear{VkClearDepthStencilValue{1.0f, 0}};
+    if(m_depthPrepass) {
+      m_renderer.renderGraph()
+        .addPass("depthPrepass")
+        .writeDepth(m_renderer.depthBuffer(), depthClear)
+        .execute([&](VkCommandBuffer) { renderSystem.renderDepth(*frame); });
+
+      depthClear.reset(); // the main pass keeps it
+    }
+
+    m_renderer.renderGraph()
+      .addPass("mainPass")
+      .writeColor(m_renderer.backbuffer(), VkClearColorValue{{0.000f, 0.000f, 0.005f, 0.0f}})
+      .writeDepth(m_renderer.depthBuffer(), depthClear)
+      .execute([&](VkCommandBuffer) {
+        renderSystem.render(*frame);
+        pointLightSystem.render(*frame);
+      });
+
+    // waits before the input is read, so a capped frame still shows the latest input
+    FrameLimiter frameLimiter{requestedFrameLimit()};
+    std::cout << clr::cyan << "[Program] " << clr::white << "present mode " << Swapchain::presentModeName(m_renderer.presentMode()) << ", frame limit ";
+    if(frameLimiter.target() > 0.0)
+      std::cout << frameLimiter.target() << " fps";
+    else
+      std::cout << "off";
+    std::cout << ", depth pre-pass " << (m_depthPrepass ? "on" : "off") << ", bindless " << (bindless ? "on" : m_device.bindlessSupported() ? "off" : "unsupported") << std::endl;
+
     while(!m_window.shouldClose()) {
+      VKE_PROFILE_FRAME();
+      frameLimiter.wait();
+
+      VKE_PROFILE_ZONE("Program::frame");
+
       frameEndTime = now();
       timeStep = frameEndTime - frameStartTime;
       frameStartTime = frameEndTime;
 
-      m_window.poolEvents();
+      {
+        VKE_PROFILE_ZONE("Window::poolEvents");
+        m_window.poolEvents();
+      }
       dispatchEvents();
 
+      // P: fifo -> mailbox -> immediate, the swapchain is rebuilt at the next present
+      if(cameraController.presentModeCycled()) {
+        VkPresentModeKHR presentMode{nextPresentMode(m_renderer.requestedPresentMode())};
+        std::cout << clr::cyan << "[Program] " << clr::white << "present mode " << Swapchain::presentModeName(presentMode) << " requested" << std::endl;
+        m_renderer.setPresentMode(presentMode);
+      }
+
+      m_modelManager.update();
+      m_textureManager.update();
+
       ////////////////
-      double speed{0.3};
-      for(size_t i{}; i < m_entities.size() - 1; ++i) {
-        speed += 0.1;
-        auto& eTransform{m_ecs.getComponent<cmp::Transform3D>(m_entities[i])};
-        double rotX{eTransform.rotation.x + (speed * timeStep.count())};
-        double rotY{eTransform.rotation.y + (speed / 2 * timeStep.count())};
-        double rotZ{eTransform.rotation.z + (speed / 3 * timeStep.count())};
-        eTransform.rotation.x = glm::mod(rotX, glm::two_pi<double>());
-        eTransform.rotation.y = glm::mod(rotY, glm::two_pi<double>());
-        eTransform.rotation.z = glm::mod(rotZ, glm::two_pi<double>());
+      {
+        VKE_PROFILE_ZONE("Program::updateTransforms");
+        double speed{0.3};
+        for(size_t i{}; i < m_entities.size() - 1; ++i) {
+          speed += 0.1;
+          auto& eTransform{m_ecs.getComponent<cmp::Transform3D>(m_entities[i])};
+          double rotX{eTransform.rotation.x + (speed * timeStep.count())};
+          double rotY{eTransform.rotation.y + (speed / 2 * timeStep.count())};
+          double rotZ{eTransform.rotation.z + (speed / 3 * timeStep.count())};
+          eTransform.rotation.x = glm::mod(rotX, glm::two_pi<double>());
+          eTransform.rotation.y = glm::mod(rotY, glm::two_pi<double>());
+          eTransform.rotation.z = glm::mod(rotZ, glm::two_pi<double>());
+        }
       }
       ////////////////
 
@@ -132,15 +249,20 @@ namespace vke
       // you could draw only when necessary, and repeatedly present the current image.
       // this can avoid needless draw() calls in more static scenes.
       if(m_renderer.beginFrame()) {
-        FrameInfo info{
+        VKE_PROFILE_ZONE("Program::record");
+        frame.emplace(FrameInfo{
           .frameIndex = m_renderer.frameIndex(),
           .timeStep = timeStep,
           .commandBuffer = m_renderer.currentCommandBuffer(),
+          .extent = m_renderer.swapchainExtent(),
           .camera{camera},
           .ecs = m_ecs,
+          .gpuProfiler = m_renderer.gpuProfiler(),
+          .descriptors = m_renderer.frameDescriptors(),
           .globalDescriptorSet = globalDescriptorSet,
           .entities = m_entities,
-        };
+          .lights = m_lights,
+        });
 
         glm::vec4 cameraPos = glm::vec4(m_ecs.getComponent<cmp::Transform3D>(cameraEntity).translation, 1.0);
         GlobalUbo ubo{
@@ -151,34 +273,59 @@ namespace vke
         uniformBuffer.write(&ubo);
         uniformBuffer.flush();
 
-        m_renderer.beginRenderPass();
-
-        renderSystem.render(info);
-        pointLightSystem.render(info);
-
-        m_renderer.endRenderPass();
+        frame->lightDescriptorSet = lightClusters.update(*frame);
+        m_renderer.render();
         m_renderer.endFrame();
 
         m_renderer.present();
       }
-
-      std::this_thread::sleep_for(std::chrono::milliseconds(6));
     }
 
+    // pending compilations still use the systems' pipeline layouts
+    m_pipelineRegistry.waitIdle();
     vkDeviceWaitIdle(m_device);
+
+    m_renderer.gpuProfiler().report(std::cout);
+    reportOverdraw();
+    VKE_PROFILE_EXPORT(m_device.assetsPath() / "build/trace.json");
+  }
+
+  // fragment shader invocations of the scene's shading over the pixels of the last frame. without the pre-pass
+  // every covered layer is shaded, with it (about) only the visible one
+  void Program::reportOverdraw()
+  {
+    const GpuProfiler& profiler{m_renderer.gpuProfiler()};
+    auto timing{std::ranges::find_if(profiler.timings(), [](const GpuProfiler::Timing& timing) { return std::string_view{timing.name} == "RenderSystem"; })};
+    if(!profiler.hasStatistics() || timing == profiler.timings().end())
+      return;
+
+    VkExtent2D extent{m_renderer.swapchainExtent()};
+    double fragments{static_cast<double>(timing->statistics[GpuProfiler::fragmentInvocations])};
+    std::cout << clr::cyan << "[Program] " << clr::white << "depth pre-pass " << (m_depthPrepass ? "on" : "off") << ": "
+              << fragments / (static_cast<double>(extent.width) * extent.height) << " shaded fragments per pixel" << std::endl;
   }
 
   void Program::dispatchEvents()
   {
+    VKE_PROFILE_FUNCTION();
     // m_eventRelayer.dispatch<event::WindowResized>();
+
+    // before the systems request their pipelines again, the new render passes may have the old ones' handles
+    for(VkRenderPass renderPass : m_renderer.takeRetiredRenderPasses())
+      m_pipelineRegistry.retire(renderPass);
     m_eventRelayer.dispatch<event::InvalidPipeline>();
   }
 
   void Program::loadEntities()
   {
+    // the vases overlap from most viewpoints, shading only the front one pays for the extra pass
+    m_depthPrepass = requestedDepthPrepass(true);
+
     m_ecs.registerComponent<cmp::Transform3D>();
     m_ecs.registerComponent<cmp::Common>();
     m_ecs.registerComponent<cmp::Color>();
+    m_ecs.registerComponent<cmp::PointLight>();
+    m_ecs.registerComponent<cmp::Material>();
 
     cmp::Transform3D transform3D{
       .translation{-3.f, 0.f, 1.f},
@@ -211,8 +358,17 @@ namespace vke
       m_ecs.addComponent<cmp::Transform3D>(e, transform3D);
       m_ecs.addComponent<cmp::Common>(e, common);
       m_ecs.addComponent<cmp::Color>(e, {});
+      m_ecs.addComponent<cmp::Material>(e, {});
     }
 
+    // the vases share a glazed material, the cube and the floor keep the default one
+    auto glazed{m_materials.create("glazed", {.baseColor{0.9f, 0.85f, 1.f, 1.f}, .specular = 1.5f, .shininess = 64.f})};
+    auto clay{m_materials.create("clay", {.baseColor{1.f, 0.7f, 0.55f, 1.f}, .specular = 0.2f, .shininess = 8.f})};
+    m_ecs.getComponent<cmp::Material>(flatVase).id = clay;
+    m_ecs.getComponent<cmp::Material>(smoothVase).id = glazed;
+    m_ecs.getComponent<cmp::Material>(smallVase).id = glazed;
+    m_materials.upload();
+
     m_ecs.getComponent<cmp::Transform3D>(smallVase).scale = {1.f, 0.5f, 1.f};
     m_ecs.getComponent<cmp::Transform3D>(quad).translation = {-0.5f, 0.5f, 1.f};
     m_ecs.getComponent<cmp::Transform3D>(quad).scale = {3.f, 1.f, 3.f};
@@ -221,19 +377,33 @@ namespace vke
     /* m_ecs.getComponent<cmp::Transform3D>(quad).scale.y = 0.f; */
 
     // Model::Builder builder{m_modelManager.cubeModelBuilder()};
-    std::string root = m_device.assetsPath();
-    Model::Builder flatVaseBuilder{root + "/models/flat_vase.obj"};
-    Model::Builder cubeBuilder{root + "/models/colored_cube.obj"};
-    Model::Builder smoothBuilder{root + "/models/smooth_vase.obj"};
-    Model::Builder smallBuilder{root + "/models/smooth_vase.obj"};
-    Model::Builder quadBuilder{root + "/models/quad.obj"};
-
-    m_modelManager.give(flatVaseBuilder, {flatVase});
-    m_modelManager.give(cubeBuilder, {cube});
-    m_modelManager.give(smoothBuilder, {smoothVase});
-    m_modelManager.give(smallBuilder, {smallVase});
-    m_modelManager.give(quadBuilder, {quad});
-    m_modelManager.createModels();
+    // loaded in the background, the entities show a placeholder until then.
+    // both vases share one model
+    auto models{m_device.assetsPath() / "models"};
+    m_modelManager.load(models / "flat_vase.obj", {flatVase});
+    m_modelManager.load(models / "colored_cube.obj", {cube});
+    m_modelManager.load(models / "smooth_vase.obj", {smoothVase});
+    m_modelManager.load(models / "smooth_vase.obj", {smallVase});
+    m_modelManager.load(models / "quad.obj", {quad});
+
+    // the old single light, reaching the whole scene, and a ring of small colored ones around the vases
+    auto light{m_ecs.createEntity()};
+    m_ecs.addComponent<cmp::PointLight>(light, {.position{-1.f, -1.f, -1.f}, .intensity = 1.f, .radius = 6.f});
+    m_lights.push_back(light);
+
+    constexpr int ringLights{48};
+    for(int i{}; i < ringLights; ++i) {
+      float angle{glm::two_pi<float>() * i / ringLights};
+      auto ringLight{m_ecs.createEntity()};
+      m_ecs.addComponent<cmp::PointLight>(ringLight,
+        {
+          .position{-0.6f + 1.8f * std::cos(angle), -0.2f, 1.f + 1.8f * std::sin(angle)},
+          .color{0.5f + 0.5f * std::cos(angle), 0.5f + 0.5f * std::cos(angle + 2.1f), 0.5f + 0.5f * std::cos(angle + 4.2f)},
+          .intensity = 0.6f,
+          .radius = 0.8f,
+        });
+      m_lights.push_back(ringLight);
+    }
   }
 
   // void Program::notifySwapchainRecreation(void* object, VkRenderPass renderPass, VkExtent2D extent)
@@ -0,0 +1,737 @@
+#include "renderGraph.hpp"
+#include "allocator.hpp"
+
+namespace vke
+{
+  namespace
+  {
+    bool hasStencil(VkFormat format)
+    {
+      return format == VK_FORMAT_D16_UNORM_S8_UINT || format == VK_FORMAT_D24_UNORM_S8_UINT || format == VK_FORMAT_D32_SFLOAT_S8_UINT || format == VK_FORMAT_S8_UINT;
+    }
+  } // namespace
+
+  auto RenderGraph::PassBuilder::writeColor(ImageHandle image, std::optional<VkClearColorValue> clear) -> PassBuilder&
+  {
+    m_graph.addAccess(m_pass, {
+      .usage = Usage::colorAttachment,
+      .resource = image.index,
+      .layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL,
+      .stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT,
+      .access = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT,
+      .write = true,
+      .clear = clear ? std::optional{VkClearValue{.color = *clear}} : std::nullopt,
+    });
+
+    return *this;
+  }
+
+  auto RenderGraph::PassBuilder::writeDepth(ImageHandle image, std::optional<VkClearDepthStencilValue> clear) -> PassBuilder&
+  {
+    m_graph.addAccess(m_pass, {
+      .usage = Usage::depthAttachment,
+      .resource = image.index,
+      .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL,
+      .stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+      .access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
+      .write = true,
+      .clear = clear ? std::optional{VkClearValue{.depthStencil = *clear}} : std::nullopt,
+    });
+
+    return *this;
+  }
+
+  auto RenderGraph::PassBuilder::readDepth(ImageHandle image) -> PassBuilder&
+  {
+    m_graph.addAccess(m_pass, {
+      .usage = Usage::depthRead,
+      .resource = image.index,
+      .layout = VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL,
+      .stages = VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT | VK_PIPELINE_STAGE_LATE_FRAGMENT_TESTS_BIT,
+      .access = VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_READ_BIT,
+    });
+
+    return *this;
+  }
+
+  auto RenderGraph::PassBuilder::readTexture(ImageHandle image, VkPipelineStageFlags stages) -> PassBuilder&
+  {
+    m_graph.addAccess(m_pass, {
+      .usage = Usage::sampled,
+      .resource = image.index,
+      .layout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+      .stages = stages,
+      .access = VK_ACCESS_SHADER_READ_BIT,
+    });
+
+    return *this;
+  }
+
+  auto RenderGraph::PassBuilder::readBuffer(BufferHandle buffer, VkPipelineStageFlags stages, VkAccessFlags access) -> PassBuilder&
+  {
+    m_graph.addAccess(m_pass, {.usage = Usage::buffer, .resource = buffer.index, .stages = stages, .access = access});
+    return *this;
+  }
+
+  auto RenderGraph::PassBuilder::writeBuffer(BufferHandle buffer, VkPipelineStageFlags stages, VkAccessFlags access) -> PassBuilder&
+  {
+    m_graph.addAccess(m_pass, {.usage = Usage::buffer, .resource = buffer.index, .stages = stages, .access = access, .write = true});
+    return *this;
+  }
+
+  auto RenderGraph::PassBuilder::sideEffect() -> PassBuilder&
+  {
+    m_graph.m_passes[m_pass.index].sideEffect = true;
+    m_graph.m_compiled = false;
+    return *this;
+  }
+
+  auto RenderGraph::PassBuilder::execute(std::function<void(VkCommandBuffer)> record) -> PassBuilder&
+  {
+    m_graph.m_passes[m_pass.index].record = std::move(record);
+    return *this;
+  }
+
+  RenderGraph::RenderGraph(Device& device) :
+    m_device{device}
+  {
+  }
+
+  RenderGraph::~RenderGraph()
+  {
+    destroyResources();
+  }
+
+  auto RenderGraph::createImage(const char* name, const ImageDesc& desc) -> ImageHandle
+  {
+    m_images.push_back({.name = name, .desc = desc});
+    m_compiled = false;
+    return {static_cast<uint32_t>(m_images.size() - 1)};
+  }
+
+  auto RenderGraph::importImage(const char* name, VkFormat format, ExternalState initial, ExternalState final) -> ImageHandle
+  {
+    m_images.push_back({.name = name, .desc = {.format = format}, .imported = true, .initial = initial, .final = final});
+    m_compiled = false;
+    return {static_cast<uint32_t>(m_images.size() - 1)};
+  }
+
+  auto RenderGraph::importBuffer(const char* name) -> BufferHandle
+  {
+    m_buffers.push_back({.name = name});
+    m_compiled = false;
+    return {static_cast<uint32_t>(m_buffers.size() - 1)};
+  }
+
+  auto RenderGraph::addPass(const char* name) -> PassBuilder
+  {
+    m_passes.push_back({.name = name});
+    m_compiled = false;
+    return {*this, {static_cast<uint32_t>(m_passes.size() - 1)}};
+  }
+
+  void RenderGraph::setFormat(ImageHandle image, VkFormat format)
+  {
+    if(m_images[image.index].desc.format != format) {
+      m_images[image.index].desc.format = format;
+      m_compiled = false;
+    }
+  }
+
+  void RenderGraph::setImage(ImageHandle image, VkImage handle, VkImageView view)
+  {
+    assert(m_images[image.index].imported && "Only imported images are set from outside");
+
+    m_images[image.index].image = handle;
+    m_images[image.index].view = view;
+  }
+
+  void RenderGraph::setBuffer(BufferHandle buffer, VkBuffer handle)
+  {
+    m_buffers[buffer.index].buffer = handle;
+  }
+
+  void RenderGraph::addAccess(PassHandle pass, Access access)
+  {
+    auto& accesses{m_passes[pass.index].accesses};
+    assert(std::ranges::none_of(accesses, [&](const Access& other) { return (other.usage == Usage::buffer) == (access.usage == Usage::buffer) && other.resource == access.resource; }) &&
+           "A pass accesses a resource once");
+
+    accesses.push_back(access);
+    m_compiled = false;
+  }
+
+  void RenderGraph::compile(VkExtent2D extent)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    // the frames in flight may still use what gets replaced
+    if(!m_blocks.empty() || std::ranges::any_of(m_passes, [](const Pass& pass) { return pass.renderPass != VK_NULL_HANDLE; }))
+      vkDeviceWaitIdle(m_device);
+
+    destroyResources();
+    m_extent = extent;
+
+    cullPasses();
+    allocateImages();
+    createRenderPasses();
+    planBarriers();
+
+    m_compiled = true;
+
+    auto culled{std::ranges::count_if(m_passes, &Pass::culled)};
+    std::cout << clr::cyan << "[RenderGraph] " << clr::white << m_passes.size() - culled << " passes (" << culled << " culled), " << m_blocks.size() << " transient allocations, "
+              << m_memorySize / 1024 << " KiB (" << m_unaliasedSize / 1024 << " KiB unaliased)" << std::endl;
+  }
+
+  // backwards: a pass lives when it has side effects or writes something needed later. imported resources are
+  // needed at the end of the frame, a pass reading (or loading) a resource needs it, a pass clearing it doesn't
+  void RenderGraph::cullPasses()
+  {
+    std::vector<bool> neededImages(m_images.size());
+    for(size_t i{}; i < m_images.size(); ++i)
+      neededImages[i] = m_images[i].imported;
+
+    std::vector<bool> neededBuffers(m_buffers.size(), true);
+
+    auto needed = [&](const Access& access) { return access.usage == Usage::buffer ? neededBuffers[access.resource] : neededImages[access.resource]; };
+    auto setNeeded = [&](const Access& access, bool value) {
+      if(access.usage == Usage::buffer)
+        neededBuffers[access.resource] = value;
+      else
+        neededImages[access.resource] = value;
+    };
+
+    for(auto pass{m_passes.rbegin()}; pass != m_passes.rend(); ++pass) {
+      pass->culled = !pass->sideEffect && std::ranges::none_of(pass->accesses, [&](const Access& access) { return access.write && needed(access); });
+      if(pass->culled)
+        continue;
+
+      for(const Access& access : pass->accesses) {
+        if(access.write && access.clear)
+          setNeeded(access, false);
+      }
+
+      for(const Access& access : pass->accesses) {
+        if(!access.write || !access.clear)
+          setNeeded(access, true);
+      }
+    }
+  }
+
+  void RenderGraph::allocateImages()
+  {
+    for(uint32_t p{}; p < m_passes.size(); ++p) {
+      if(m_passes[p].culled)
+        continue;
+
+      for(const Access& access : m_passes[p].accesses) {
+        if(access.usage == Usage::buffer)
+          continue;
+
+        Image& image{m_images[access.resource]};
+        image.firstPass = std::min(image.firstPass, p);
+        image.lastPass = std::max(image.lastPass, p);
+      }
+    }
+
+    struct Allocation
+    {
+      uint32_t image;
+      VkMemoryRequirements requirements;
+      uint32_t memoryType;
+    };
+
+    std::vector<Allocation> allocations;
+    for(uint32_t i{}; i < m_images.size(); ++i) {
+      Image& image{m_images[i]};
+      if(image.imported || image.firstPass == ~0u)
+        continue;
+
+      VkImageUsageFlags usage{};
+      for(const Pass& pass : m_passes) {
+        for(const Access& access : pass.accesses) {
+          if(pass.culled || access.usage == Usage::buffer || access.resource != i)
+            continue;
+
+          usage |= access.usage == Usage::colorAttachment ? VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT :
+                   access.usage == Usage::sampled         ? VK_IMAGE_USAGE_SAMPLED_BIT :
+                                                            VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT;
+        }
+      }
+
+      VkImageCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+        .imageType = VK_IMAGE_TYPE_2D,
+        .format = image.desc.format,
+        .extent = {m_extent.width, m_extent.height, 1},
+        .mipLevels = 1,
+        .arrayLayers = 1,
+        .samples = image.desc.samples,
+        .tiling = VK_IMAGE_TILING_OPTIMAL,
+        .usage = usage,
+        .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+        .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+      };
+
+      if(vkCreateImage(m_device, &createInfo, nullptr, &image.image) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create render graph image");
+
+      Allocation allocation{.image = i};
+      vkGetImageMemoryRequirements(m_device, image.image, &allocation.requirements);
+      allocation.memoryType = MemAllocator::findMemoryType(m_device.physicalInfo().memoryProperties, allocation.requirements.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
+      allocations.push_back(allocation);
+
+      m_unaliasedSize += allocation.requirements.size;
+    }
+
+    // biggest first, each into the first block it fits in whose images are all dead while it lives.
+    // every image sits at offset 0 of its block, allocations are aligned for anything
+    std::ranges::sort(allocations, std::greater{}, [](const Allocation& allocation) { return allocation.requirements.size; });
+
+    for(const Allocation& allocation : allocations) {
+      Image& image{m_images[allocation.image]};
+
+      auto fits = [&](const Block& block) {
+        return block.memoryType == allocation.memoryType && block.size >= allocation.requirements.size &&
+               std::ranges::none_of(block.images, [&](uint32_t other) { return m_images[other].firstPass <= image.lastPass && image.firstPass <= m_images[other].lastPass; });
+      };
+
+      auto block{std::ranges::find_if(m_blocks, fits)};
+      if(block == m_blocks.end()) {
+        m_blocks.push_back({.size = allocation.requirements.size, .memoryType = allocation.memoryType});
+        block = m_blocks.end() - 1;
+      }
+
+      block->images.push_back(allocation.image);
+      image.block = static_cast<uint32_t>(block - m_blocks.begin());
+    }
+
+    for(Block& block : m_blocks) {
+      MemAllocator::allocate(m_device, block.size, block.memoryType, &block.memory);
+      m_memorySize += block.size;
+
+      std::ranges::sort(block.images, {}, [this](uint32_t image) { return m_images[image].firstPass; });
+      for(uint32_t i : block.images) {
+        Image& image{m_images[i]};
+        vkBindImageMemory(m_device, image.image, block.memory, 0);
+
+        VkImageViewCreateInfo createInfo{
+          .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+          .image = image.image,
+          .viewType = VK_IMAGE_VIEW_TYPE_2D,
+          .format = image.desc.format,
+          .subresourceRange = {
+            .aspectMask = aspectMask(image),
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+          },
+        };
+
+        if(vkCreateImageView(m_device, &createInfo, nullptr, &image.view) != VK_SUCCESS)
+          throw std::runtime_error("Failed to create render graph image view");
+      }
+    }
+  }
+
+  void RenderGraph::createRenderPasses()
+  {
+    for(uint32_t p{}; p < m_passes.size(); ++p) {
+      Pass& pass{m_passes[p]};
+      if(pass.culled)
+        continue;
+
+      std::vector<const Access*> colors;
+      const Access* depth{};
+      for(const Access& access : pass.accesses) {
+        if(access.usage == Usage::colorAttachment)
+          colors.push_back(&access);
+        else if(access.usage == Usage::depthAttachment || access.usage == Usage::depthRead)
+          depth = &access;
+      }
+
+      if(colors.empty() && !depth)
+        continue;
+
+      // stored when a later pass uses it or it leaves the graph
+      auto usedLater = [&](uint32_t image) {
+        if(m_images[image].imported)
+          return true;
+
+        for(uint32_t later{p + 1}; later < m_passes.size(); ++later) {
+          if(!m_passes[later].culled && std::ranges::any_of(m_passes[later].accesses, [&](const Access& access) { return access.usage != Usage::buffer && access.resource == image; }))
+            return true;
+        }
+
+        return false;
+      };
+
+      std::vector<VkAttachmentDescription> attachments;
+      std::vector<VkAttachmentReference> colorReferences;
+      VkAttachmentReference depthReference{};
+
+      auto addAttachment = [&](const Access& access) {
+        const Image& image{m_images[access.resource]};
+        bool readOnly{!access.write};
+
+        attachments.push_back({
+          .format = image.desc.format,
+          .samples = image.desc.samples,
+          .loadOp = access.clear ? VK_ATTACHMENT_LOAD_OP_CLEAR : VK_ATTACHMENT_LOAD_OP_LOAD,
+          .storeOp = readOnly || usedLater(access.resource) ? VK_ATTACHMENT_STORE_OP_STORE : VK_ATTACHMENT_STORE_OP_DONT_CARE,
+          .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+          .stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
+          // the graph's barriers do the transitions
+          .initialLayout = access.layout,
+          .finalLayout = access.layout,
+        });
+
+        pass.attachments.push_back(access.resource);
+        pass.clearValues.push_back(access.clear.value_or(VkClearValue{}));
+        return VkAttachmentReference{static_cast<uint32_t>(attachments.size() - 1), access.layout};
+      };
+
+      for(const Access* color : colors)
+        colorReferences.push_back(addAttachment(*color));
+      if(depth)
+        depthReference = addAttachment(*depth);
+
+      VkSubpassDescription subpass{
+        .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+        .colorAttachmentCount = static_cast<uint32_t>(colorReferences.size()),
+        .pColorAttachments = colorReferences.data(),
+        .pDepthStencilAttachment = depth ? &depthReference : nullptr,
+      };
+
+      VkRenderPassCreateInfo createInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
+        .attachmentCount = static_cast<uint32_t>(attachments.size()),
+        .pAttachments = attachments.data(),
+        .subpassCount = 1,
+        .pSubpasses = &subpass,
+      };
+
+      if(vkCreateRenderPass(m_device, &createInfo, nullptr, &pass.renderPass) != VK_SUCCESS)
+        throw std::runtime_error("Failed to create render graph render pass");
+    }
+  }
+
+  // the frame loops: a resource starts in the state its last use left it in. a transient image also waits for
+  // the last use of whatever shared its memory before it, its content is discarded (undefined layout)
+  void RenderGraph::planBarriers()
+  {
+    std::vector<const Access*> lastImageUse(m_images.size());
+    std::vector<const Access*> lastBufferUse(m_buffers.size());
+    for(const Pass& pass : m_passes) {
+      if(pass.culled)
+        continue;
+
+      for(const Access& access : pass.accesses)
+        (access.usage == Usage::buffer ? lastBufferUse : lastImageUse)[access.resource] = &access;
+    }
+
+    auto leftBy = [](const Access* access, VkImageLayout layout) {
+      State state{.layout = layout};
+      if(!access)
+        return state;
+
+      if(access->write) {
+        state.writeStages = access->stages;
+        state.writeAccess = access->access;
+        state.dirty = true;
+      } else {
+        state.readStages = access->stages;
+      }
+
+      return state;
+    };
+
+    std::vector<State> images(m_images.size());
+    for(uint32_t i{}; i < m_images.size(); ++i) {
+      const Image& image{m_images[i]};
+      if(image.imported) {
+        images[i] = {
+          .layout = image.initial.layout,
+          .writeStages = image.initial.stages,
+          .writeAccess = image.initial.access,
+          .dirty = true,
+        };
+      } else if(image.block != ~0u) {
+        const auto& occupants{m_blocks[image.block].images};
+        auto position{std::ranges::find(occupants, i) - occupants.begin()};
+        uint32_t previous{occupants[(position + occupants.size() - 1) % occupants.size()]};
+        images[i] = leftBy(lastImageUse[previous], VK_IMAGE_LAYOUT_UNDEFINED);
+      }
+    }
+
+    std::vector<State> buffers(m_buffers.size());
+    for(uint32_t i{}; i < m_buffers.size(); ++i)
+      buffers[i] = leftBy(lastBufferUse[i], VK_IMAGE_LAYOUT_UNDEFINED);
+
+    for(Pass& pass : m_passes) {
+      if(pass.culled)
+        continue;
+
+      for(const Access& access : pass.accesses) {
+        bool isImage{access.usage != Usage::buffer};
+        synchronize(&(isImage ? images : buffers)[access.resource], access, isImage, &pass.barriers);
+      }
+    }
+
+    for(uint32_t i{}; i < m_images.size(); ++i) {
+      const Image& image{m_images[i]};
+      if(!image.imported)
+        continue;
+
+      Access final{.resource = i, .layout = image.final.layout, .stages = image.final.stages, .access = image.final.access};
+      synchronize(&images[i], final, true, &m_finalBarriers);
+    }
+  }
+
+  void RenderGraph::synchronize(State* state, const Access& access, bool isImage, std::vector<Barrier>* barriers)
+  {
+    bool transition{isImage && state->layout != access.layout};
+    bool unsynchronized{state->dirty && (access.stages & ~state->visibleStages)};
+
+    if(!access.write && !transition && !unsynchronized) {
+      // read after read, a later write waits for both readers
+      state->readStages |= access.stages;
+      return;
+    }
+
+    // writes wait for everyone before them (only writes need their memory made available), reads for the writes
+    VkPipelineStageFlags srcStages{access.write || transition ? state->writeStages | state->readStages : state->writeStages};
+
+    barriers->push_back({
+      .isImage = isImage,
+      .resource = access.resource,
+      .oldLayout = state->layout,
+      .newLayout = isImage ? access.layout : state->layout,
+      .srcStages = srcStages ? srcStages : VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+      .dstStages = access.stages,
+      .srcAccess = state->writeAccess,
+      .dstAccess = access.access,
+    });
+
+    if(access.write) {
+      // the barrier above orders the write, nothing has seen it yet: even a read in the same stages waits for it
+      *state = {
+        .layout = access.layout,
+        .writeStages = access.stages,
+        .writeAccess = access.access,
+        .dirty = true,
+      };
+    } else if(transition) {
+      // the transition itself is a write, the barrier made it visible to this access' stages only
+      *state = {
+        .layout = access.layout,
+        .writeStages = access.stages,
+        .readStages = access.stages,
+        .visibleStages = access.stages,
+        .dirty = true,
+      };
+    } else {
+      state->readStages |= access.stages;
+      state->visibleStages |= access.stages;
+    }
+  }
+
+  void RenderGraph::execute(VkCommandBuffer commandBuffer, GpuProfiler* profiler)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    assert(m_compiled && "Render graph not compiled");
+
+    for(Pass& pass : m_passes) {
+      if(pass.culled)
+        continue;
+
+      recordBarriers(commandBuffer, pass.barriers);
+
+      std::optional<GpuProfiler::Scope> scope;
+      if(profiler)
+        scope.emplace(*profiler, commandBuffer, pass.name, false);
+
+      if(!pass.renderPass) {
+        if(pass.record)
+          pass.record(commandBuffer);
+
+        continue;
+      }
+
+      VkRenderPassBeginInfo beginInfo{
+        .sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO,
+        .renderPass = pass.renderPass,
+        .framebuffer = framebuffer(pass),
+        .renderArea = {.offset = {0, 0}, .extent = m_extent},
+        .clearValueCount = static_cast<uint32_t>(pass.clearValues.size()),
+        .pClearValues = pass.clearValues.data(),
+      };
+
+      vkCmdBeginRenderPass(commandBuffer, &beginInfo, VK_SUBPASS_CONTENTS_INLINE);
+
+      // dynamic state, see Pipeline::defaultConfig
+      VkViewport viewport{
+        .x = 0.f,
+        .y = 0.f,
+        .width = static_cast<float>(m_extent.width),
+        .height = static_cast<float>(m_extent.height),
+        .minDepth = 0.f,
+        .maxDepth = 1.f,
+      };
+
+      VkRect2D scissor{.offset = {0, 0}, .extent = m_extent};
+
+      vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
+      vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
+
+      if(pass.record)
+        pass.record(commandBuffer);
+
+      vkCmdEndRenderPass(commandBuffer);
+    }
+
+    recordBarriers(commandBuffer, m_finalBarriers);
+  }
+
+  auto RenderGraph::framebuffer(Pass& pass) -> VkFramebuffer
+  {
+    std::vector<VkImageView> views;
+    views.reserve(pass.attachments.size());
+    for(uint32_t image : pass.attachments)
+      views.push_back(m_images[image].view);
+
+    auto cached{std::ranges::find(pass.framebuffers, views, &Framebuffer::views)};
+    if(cached != pass.framebuffers.end())
+      return cached->framebuffer;
+
+    VkFramebufferCreateInfo createInfo{
+      .sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO,
+      .renderPass = pass.renderPass,
+      .attachmentCount = static_cast<uint32_t>(views.size()),
+      .pAttachments = views.data(),
+      .width = m_extent.width,
+      .height = m_extent.height,
+      .layers = 1,
+    };
+
+    VkFramebuffer framebuffer{};
+    if(vkCreateFramebuffer(m_device, &createInfo, nullptr, &framebuffer) != VK_SUCCESS)
+      throw std::runtime_error("Failed to create render graph framebuffer");
+
+    pass.framebuffers.push_back({std::move(views), framebuffer});
+    return framebuffer;
+  }
+
+  void RenderGraph::recordBarriers(VkCommandBuffer commandBuffer, std::span<const Barrier> barriers) const
+  {
+    if(barriers.empty())
+      return;
+
+    VkPipelineStageFlags srcStages{};
+    VkPipelineStageFlags dstStages{};
+    std::vector<VkImageMemoryBarrier> imageBarriers;
+    std::vector<VkBufferMemoryBarrier> bufferBarriers;
+
+    for(const Barrier& barrier : barriers) {
+      srcStages |= barrier.srcStages;
+      dstStages |= barrier.dstStages;
+
+      if(barrier.isImage) {
+        const Image& image{m_images[barrier.resource]};
+        imageBarriers.push_back({
+          .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+          .srcAccessMask = barrier.srcAccess,
+          .dstAccessMask = barrier.dstAccess,
+          .oldLayout = barrier.oldLayout,
+          .newLayout = barrier.newLayout,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .image = image.image,
+          .subresourceRange = {
+            .aspectMask = aspectMask(image),
+            .baseMipLevel = 0,
+            .levelCount = 1,
+            .baseArrayLayer = 0,
+            .layerCount = 1,
+          },
+        });
+      } else {
+        bufferBarriers.push_back({
+          .sType = VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER,
+          .srcAccessMask = barrier.srcAccess,
+          .dstAccessMask = barrier.dstAccess,
+          .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+          .buffer = m_buffers[barrier.resource].buffer,
+          .offset = 0,
+          .size = VK_WHOLE_SIZE,
+        });
+      }
+    }
+
+    vkCmdPipelineBarrier(
+      commandBuffer,
+      srcStages, dstStages,
+      0,
+      0, nullptr,
+      static_cast<uint32_t>(bufferBarriers.size()), bufferBarriers.data(),
+      static_cast<uint32_t>(imageBarriers.size()), imageBarriers.data());
+  }
+
+  auto RenderGraph::aspectMask(const Image& image) const -> VkImageAspectFlags
+  {
+    bool depth{std::ranges::any_of(m_passes, [&](const Pass& pass) {
+      return std::ranges::any_of(pass.accesses, [&](const Access& access) {
+        return (access.usage == Usage::depthAttachment || access.usage == Usage::depthRead) && &m_images[access.resource] == &image;
+      });
+    })};
+
+    if(!depth)
+      return VK_IMAGE_ASPECT_COLOR_BIT;
+
+    return VK_IMAGE_ASPECT_DEPTH_BIT | (hasStencil(image.desc.format) ? VK_IMAGE_ASPECT_STENCIL_BIT : 0);
+  }
+
+  void RenderGraph::destroyResources()
+  {
+    for(Pass& pass : m_passes) {
+      for(const Framebuffer& framebuffer : pass.framebuffers)
+        vkDestroyFramebuffer(m_device, framebuffer.framebuffer, nullptr);
+
+      vkDestroyRenderPass(m_device, pass.renderPass, nullptr);
+
+      pass.culled = false;
+      pass.barriers.clear();
+      pass.renderPass = VK_NULL_HANDLE;
+      pass.attachments.clear();
+      pass.clearValues.clear();
+      pass.framebuffers.clear();
+    }
+
+    for(Image& image : m_images) {
+      image.firstPass = ~0u;
+      image.lastPass = 0;
+      image.block = ~0u;
+
+      if(image.imported)
+        continue;
+
+      vkDestroyImageView(m_device, image.view, nullptr);
+      vkDestroyImage(m_device, image.image, nullptr);
+      image.view = VK_NULL_HANDLE;
+      image.image = VK_NULL_HANDLE;
+    }
+
+    for(const Block& block : m_blocks)
+      vkFreeMemory(m_device, block.memory, nullptr);
+
+    m_blocks.clear();
+    m_finalBarriers.clear();
+    m_memorySize = 0;
+    m_unaliasedSize = 0;
+    m_compiled = false;
+  }
+} // namespace vke
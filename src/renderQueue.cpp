@@ -0,0 +1,70 @@
+#include "renderQueue.hpp"
+
+namespace vke
+{
+  auto RenderQueue::makeKey(uint32_t pass, uint32_t pipeline, uint32_t material, uint32_t mesh, float depth) -> Key
+  {
+    auto mask = [](uint32_t value, uint32_t bits) { return Key{value} & ((Key{1} << bits) - 1); };
+
+    constexpr uint32_t maxDepth{(1u << depthBits) - 1};
+    auto quantized{static_cast<uint32_t>(std::clamp(depth, 0.f, 1.f) * maxDepth)};
+
+    return mask(pass, passBits) << passShift
+      | mask(pipeline, pipelineBits) << pipelineShift
+      | mask(material, materialBits) << materialShift
+      | mask(mesh, meshBits) << meshShift
+      | Key{quantized} << depthShift;
+  }
+
+  void RenderQueue::sort()
+  {
+    VKE_PROFILE_FUNCTION();
+    radixSort(&m_entries, &m_scratch);
+  }
+
+  // a counting sort per byte, least significant first. every pass is stable, so the order of the lower bytes
+  // survives the higher ones
+  void RenderQueue::radixSort(std::vector<Entry>* entries, std::vector<Entry>* scratch)
+  {
+    constexpr uint32_t digits{sizeof(Key)};
+    constexpr uint32_t buckets{256};
+
+    if(entries->size() < 2)
+      return;
+
+    // every byte's histogram in one walk over the keys
+    std::array<std::array<uint32_t, buckets>, digits> counts{};
+    for(const Entry& entry : *entries) {
+      for(uint32_t digit{}; digit < digits; ++digit)
+        ++counts[digit][(entry.key >> (digit * 8)) & 0xff];
+    }
+
+    scratch->resize(entries->size());
+    std::vector<Entry>* source{entries};
+    std::vector<Entry>* target{scratch};
+
+    for(uint32_t digit{}; digit < digits; ++digit) {
+      auto& count{counts[digit]};
+      uint32_t shift{digit * 8};
+
+      // a single bucket holds every key, the pass wouldn't move anything
+      if(count[(source->front().key >> shift) & 0xff] == source->size())
+        continue;
+
+      std::array<uint32_t, buckets> offsets;
+      uint32_t offset{};
+      for(uint32_t bucket{}; bucket < buckets; ++bucket) {
+        offsets[bucket] = offset;
+        offset += count[bucket];
+      }
+
+      for(const Entry& entry : *source)
+        (*target)[offsets[(entry.key >> shift) & 0xff]++] = entry;
+
+      std::swap(source, target);
+    }
+
+    if(source != entries)
+      entries->swap(*scratch);
+  }
+} // namespace vke
@@ -2,15 +2,30 @@
 
 namespace vke
 {
-  Renderer::Renderer(Device& device, Window& window, EventRelayer& relayer) :
+  Renderer::Renderer(Device& device, Window& window, EventRelayer& relayer, VkPresentModeKHR presentMode) :
       m_device{device},
       m_window{window},
       m_eventRelayer{relayer},
-      m_swapchain{std::make_unique<Swapchain>(m_device, m_window)},
+      m_swapchain{std::make_unique<Swapchain>(m_device, m_window, presentMode)},
+      m_layoutCache{m_device},
+      m_renderGraph{m_device},
+      m_requestedPresentMode{presentMode},
       m_maxFramesInFlight{m_swapchain->imageCount()}
   {
     createSyncObjects();
     allocateCommandBuffers();
+
+    m_gpuProfiler = std::make_unique<GpuProfiler>(m_device, m_maxFramesInFlight);
+
+    for(uint32_t i{0}; i < m_maxFramesInFlight; ++i)
+      m_frameDescriptors.push_back(std::make_unique<DescriptorAllocator>(m_device));
+
+    // acquired with the image available semaphore, which waits at the color attachment output
+    const auto& info{m_swapchain->info()};
+    m_backbuffer = m_renderGraph.importImage("backbuffer", info.surfaceFormat.format,
+      {.layout = VK_IMAGE_LAYOUT_UNDEFINED, .stages = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT},
+      {.layout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, .stages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT});
+    m_depthBuffer = m_renderGraph.createImage("depth", {.format = info.depthFormat, .samples = info.samples});
     // recordCommandBuffers();
   }
 
@@ -78,21 +93,30 @@ namespace vke
 
   void Renderer::recreateSwapchain()
   {
+    VKE_PROFILE_FUNCTION();
+
     m_window.handleMinimization();
 
     vkDeviceWaitIdle(m_device);
 
-    Swapchain::Info oldSwapchainInfo{m_swapchain->info()};
-    m_swapchain = std::make_unique<Swapchain>(m_device, m_window, std::move(m_swapchain));
+    VkRenderPass oldRenderPass{m_swapchain->renderPass()};
+    VkRenderPass oldDepthRenderPass{m_swapchain->depthRenderPass()};
 
-    // the pipeline is dependant on the swapchain because of the viewport and renderpass.
-    // TODO: if the render pass is compatible, and a dynamic viewport is being used, do nothing.
-    // (https://www.khronos.org/registry/vulkan/specs/1.1-extensions/html/chap8.html#renderpass-compatibility)
+    m_swapchain = std::make_unique<Swapchain>(m_device, m_window, m_requestedPresentMode, std::move(m_swapchain));
+    m_presentModeChanged = false;
 
-    if(!m_window.isFullscreen() || !m_swapchain->compareSwapchainFormats(oldSwapchainInfo))
+    // another present mode may come with another image count, the device is idle so no image is in flight
+    m_imagesInFlight.assign(m_swapchain->imageCount(), VK_NULL_HANDLE);
+
+    m_renderGraph.setFormat(m_backbuffer, m_swapchain->info().surfaceFormat.format);
+    m_renderGraph.compile(m_swapchain->extent());
+
+    // the viewport and scissor are dynamic, the pipelines only depend on the render pass.
+    // the swapchain keeps the old one when it is compatible, so a plain resize rebuilds nothing.
+    if(!m_swapchain->reusedRenderPass())
     {
-      m_eventRelayer.queue(event::InvalidPipeline{m_swapchain->renderPass(), m_swapchain->extent()});
-      //createGraphicsPipeline();
+      m_retiredRenderPasses.insert(m_retiredRenderPasses.end(), {oldRenderPass, oldDepthRenderPass});
+      m_eventRelayer.queue(event::InvalidPipeline{m_swapchain->renderPass(), m_swapchain->depthRenderPass()});
     }
 
     // createDescriptorSets();
@@ -109,6 +133,12 @@ namespace vke
     */
   }
 
+  void Renderer::setPresentMode(VkPresentModeKHR presentMode)
+  {
+    m_requestedPresentMode = presentMode;
+    m_presentModeChanged = true;
+  }
+
   VkCommandBuffer Renderer::currentCommandBuffer() const
   {
     assert(m_hasFrameStarted && "Frame has not been started.");
@@ -117,13 +147,23 @@ namespace vke
 
   bool Renderer::beginFrame()
   {
+    VKE_PROFILE_FUNCTION();
+
     //uint32_t& imageIndex = *pImageIndex;
     assert(!m_hasFrameStarted && "Frame already started. ");
 
     //////////////////////////
 
-    vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrameIndex], VK_TRUE, UINT64_MAX);
-    VkResult result{m_swapchain->acquireNextImage(m_imageAvailableSemaphore[m_currentFrameIndex], &m_currentImageIndex)};
+    VkResult result{};
+    {
+      VKE_PROFILE_ZONE("Renderer::waitInFlightFence");
+      vkWaitForFences(m_device, 1, &m_inFlightFences[m_currentFrameIndex], VK_TRUE, UINT64_MAX);
+    }
+    m_frameDescriptors[m_currentFrameIndex]->reset();
+    {
+      VKE_PROFILE_ZONE("Swapchain::acquireNextImage");
+      result = m_swapchain->acquireNextImage(m_imageAvailableSemaphore[m_currentFrameIndex], &m_currentImageIndex);
+    }
 
     if(result == VK_ERROR_OUT_OF_DATE_KHR)
     {
@@ -136,10 +176,19 @@ namespace vke
     }
 
     if(m_imagesInFlight[m_currentImageIndex] != VK_NULL_HANDLE)
+    {
+      VKE_PROFILE_ZONE("Renderer::waitImageFence");
       vkWaitForFences(m_device, 1, &m_imagesInFlight[m_currentImageIndex], VK_TRUE, UINT64_MAX);
+    }
 
     m_imagesInFlight[m_currentImageIndex] = m_inFlightFences[m_currentFrameIndex];
 
+    // the passes are added after the renderer is made, the first frame compiles them
+    if(!m_renderGraph.isCompiled())
+      m_renderGraph.compile(m_swapchain->extent());
+
+    m_renderGraph.setImage(m_backbuffer, m_swapchain->images()[m_currentImageIndex], m_swapchain->imageViews()[m_currentImageIndex]);
+
     m_hasFrameStarted = true;
 
     //////////////////////////////////////
@@ -154,63 +203,22 @@ namespace vke
     if(vkBeginCommandBuffer(commandBuffer, &beginInfo) != VK_SUCCESS)
       throw std::runtime_error("Failed to begin recording command buffer.");
 
-    return true;
-  }
-
-  void Renderer::beginRenderPass()
-  {
-    assert(m_hasFrameStarted && "Frame not started.");
+    m_gpuProfiler->beginFrame(commandBuffer, m_currentFrameIndex);
 
-    auto commandBuffer{ currentCommandBuffer() };
-    VkClearValue clearValues[2];
-    clearValues[0].color = {{0.000f, 0.000f, 0.005f, 0.0f}};
-    clearValues[1].depthStencil = {1.0f, 0};
-
-    // for(size_t i = 0; i < m_commandBuffers.size(); i++) {
-    //
-    VkRenderPassBeginInfo renderPassInfo{};
-    renderPassInfo.sType = VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO;
-    renderPassInfo.renderPass = m_swapchain->renderPass();
-    renderPassInfo.framebuffer = m_swapchain->framebuffers()[m_currentImageIndex];
-    renderPassInfo.renderArea.offset = {0, 0};
-    renderPassInfo.renderArea.extent = m_swapchain->extent();
-    renderPassInfo.clearValueCount = std::size(clearValues);
-    renderPassInfo.pClearValues = clearValues;
-
-    vkCmdBeginRenderPass(commandBuffer, &renderPassInfo, VK_SUBPASS_CONTENTS_INLINE);
-
-    if(!m_window.isFullscreen())
-    {
-      VkViewport viewport{
-        .x = 0.0f,
-        .y = 0.0f,
-        .width = static_cast<float>(m_swapchain->extent().width),
-        .height = static_cast<float>(m_swapchain->extent().height),
-        .minDepth = 0.0f,
-        .maxDepth = 1.0f,
-      };
-
-      VkRect2D scissor = {
-        .offset = {0, 0},
-        .extent = m_swapchain->extent(),
-      };
-
-      vkCmdSetViewport(commandBuffer, 0, 1, &viewport);
-      vkCmdSetScissor(commandBuffer, 0, 1, &scissor);
-    }
-
-    // renderEntities(commandBuffer, m_currentImageIndex);
+    return true;
   }
 
-  void Renderer::endRenderPass()
+  void Renderer::render()
   {
     assert(m_hasFrameStarted && "Frame not started.");
 
-    vkCmdEndRenderPass( m_commandBuffers[m_currentFrameIndex] );
+    m_renderGraph.execute(currentCommandBuffer(), m_gpuProfiler.get());
   }
 
   void Renderer::endFrame()
   {
+    VKE_PROFILE_FUNCTION();
+
     assert(m_hasFrameStarted && "Frame not started.");
 
     auto commandBuffer{ currentCommandBuffer() };
@@ -237,6 +245,7 @@ namespace vke
 
     vkResetFences(m_device, 1, &m_inFlightFences[m_currentFrameIndex]);
 
+    VKE_PROFILE_ZONE("vkQueueSubmit");
     if(vkQueueSubmit(m_device.queues().graphics, 1, &submitInfo, m_inFlightFences[m_currentFrameIndex]) != VK_SUCCESS)
       throw std::runtime_error("Failed to submit draw command buffer");
 
@@ -245,6 +254,8 @@ namespace vke
 
   void Renderer::present()
   {
+    VKE_PROFILE_FUNCTION();
+
     assert(!m_hasFrameStarted && "Frame not finished.");
 
     VkSemaphore signalSemaphores[]{m_renderFinishedSemaphore[m_currentFrameIndex]};
@@ -261,7 +272,7 @@ namespace vke
 
     VkResult result{vkQueuePresentKHR(m_device.queues().present, &presentInfo)};
 
-    if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window.wasResized())
+    if(result == VK_ERROR_OUT_OF_DATE_KHR || result == VK_SUBOPTIMAL_KHR || m_window.wasResized() || m_presentModeChanged)
     {
       m_window.resetResizedFlag();
       recreateSwapchain();
@@ -0,0 +1,59 @@
+#include "samplerCache.hpp"
+
+#include "utils.hpp"
+
+namespace vke
+{
+  SamplerCache::SamplerCache(Device& device) :
+    m_device{device}
+  {
+  }
+
+  SamplerCache::~SamplerCache()
+  {
+    for(auto& [state, sampler] : m_samplers)
+      vkDestroySampler(m_device, sampler, nullptr);
+  }
+
+  auto SamplerCache::get(const State& state) -> VkSampler
+  {
+    if(auto it{m_samplers.find(state)}; it != m_samplers.end())
+      return it->second;
+
+    float maxAnisotropy{std::min(state.maxAnisotropy, m_device.physicalInfo().deviceProperties.limits.maxSamplerAnisotropy)};
+    bool anisotropy{m_device.enabledFeatures().samplerAnisotropy && maxAnisotropy > 1.f};
+
+    VkSamplerCreateInfo createInfo{
+      .sType = VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO,
+      .magFilter = state.magFilter,
+      .minFilter = state.minFilter,
+      .mipmapMode = state.mipmapMode,
+      .addressModeU = state.addressModeU,
+      .addressModeV = state.addressModeV,
+      .addressModeW = state.addressModeW,
+      .mipLodBias = 0.f,
+      .anisotropyEnable = anisotropy,
+      .maxAnisotropy = anisotropy ? maxAnisotropy : 1.f,
+      .compareEnable = VK_FALSE,
+      .compareOp = VK_COMPARE_OP_ALWAYS,
+      .minLod = 0.f,
+      .maxLod = state.maxLod,
+      .borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK,
+      .unnormalizedCoordinates = VK_FALSE,
+    };
+
+    VkSampler sampler{};
+    if(vkCreateSampler(m_device, &createInfo, nullptr, &sampler) != VK_SUCCESS)
+      throw std::runtime_error("Failed to create sampler");
+
+    m_samplers.emplace(state, sampler);
+    return sampler;
+  }
+
+  auto SamplerCache::StateHash::operator()(const State& state) const -> size_t
+  {
+    size_t seed{};
+    hash_combine(&seed, state.magFilter, state.minFilter, state.mipmapMode, state.addressModeU, state.addressModeV, state.addressModeW, state.maxAnisotropy, state.maxLod);
+    return seed;
+  }
+} // namespace vke
@@ -2,50 +2,51 @@
 
 namespace vke
 {
-  Swapchain::Swapchain(Device& device, Window& window, std::unique_ptr<Swapchain> pOldSwapchain) :
+  Swapchain::Swapchain(Device& device, Window& window, VkPresentModeKHR presentMode, std::unique_ptr<Swapchain> pOldSwapchain) :
     m_device{device}, m_window{window}
   {
-    // VkSwapchainKHR oldSwapchain = (pOldSwapchain ? *pOldSwapchain : VK_NULL_HANDLE);
-    VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE;
-    if(pOldSwapchain) {
-      VkSwapchainKHR oldSwapchain = *pOldSwapchain;
-    }
+    VkSwapchainKHR oldSwapchain = (pOldSwapchain ? pOldSwapchain->m_swapchain : VK_NULL_HANDLE);
 
     if(!oldSwapchain) {
       querySupportDetails();
       chooseSurfaceFormat();
-      choosePresentMode();
+      choosePresentMode(presentMode);
       chooseExtent();
       findDepthFormat(&m_info.depthFormat);
     } else {
-      m_details = std::move(pOldSwapchain->m_details);
-      m_info = std::move(pOldSwapchain->m_info);
+      m_info = pOldSwapchain->m_info;
 
-      // update details and info
-      querySupportDetails(&m_details.capabilities);
+      // the surface may have moved to a display with other formats (or present modes)
+      querySupportDetails();
+      chooseSurfaceFormat();
+      choosePresentMode(presentMode);
       chooseExtent();
     }
 
+    if(m_info.presentMode != presentMode && (!pOldSwapchain || pOldSwapchain->m_info.presentMode != m_info.presentMode))
+      std::cerr << clr::sand << "[Swapchain] " << clr::white << presentModeName(presentMode) << " isn't supported, using " << presentModeName(m_info.presentMode) << std::endl;
+
     createSwapchain(oldSwapchain);
     createImageViews();
-    createRenderPass();
-    createDepthResources();
-    createFramebuffers();
+
+    // a resize only changes the extent, the old render pass (and every pipeline made with it) stays valid
+    if(pOldSwapchain && isRenderPassCompatible(pOldSwapchain->m_info)) {
+      m_renderPass = std::exchange(pOldSwapchain->m_renderPass, VK_NULL_HANDLE);
+      m_depthRenderPass = std::exchange(pOldSwapchain->m_depthRenderPass, VK_NULL_HANDLE);
+      m_reusedRenderPass = true;
+    } else {
+      createRenderPass();
+    }
+
   }
 
   Swapchain::~Swapchain()
   {
-    for(const auto& framebuffer : m_framebuffers)
-      vkDestroyFramebuffer(m_device, framebuffer, nullptr);
-
     vkDestroySwapchainKHR(m_device, m_swapchain, nullptr);
     vkDestroyRenderPass(m_device, m_renderPass, nullptr);
+    vkDestroyRenderPass(m_device, m_depthRenderPass, nullptr);
 
-    vkDestroyImageView(m_device, m_depthImageView, nullptr);
-    vkDestroyImage(m_device, m_depthImage, nullptr);
-    vkFreeMemory(m_device, m_depthImageMemory, nullptr);
-
-    for(const auto& imageView : imageViews)
+    for(const auto& imageView : m_imageViews)
       vkDestroyImageView(m_device, imageView, nullptr);
   }
 
@@ -87,10 +88,10 @@ namespace vke
       throw std::runtime_error("Failed to create swapchain");
 
     vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, nullptr);
-    images.resize(imageCount);
-    vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, images.data());
+    m_images.resize(imageCount);
+    vkGetSwapchainImagesKHR(m_device, m_swapchain, &imageCount, m_images.data());
 
-    m_info.imageCount = images.size();
+    m_info.imageCount = m_images.size();
   }
 
   void Swapchain::querySupportDetails(VkSurfaceCapabilitiesKHR* capabilities)
@@ -112,21 +113,47 @@ namespace vke
     }
   }
 
-  void Swapchain::choosePresentMode()
+  // fifo is the only mode every surface has. mailbox and immediate stand in for each other, both skip the wait
+  // for the vertical blank, one dropping frames and the other tearing. relaxed fifo just falls back to fifo
+  void Swapchain::choosePresentMode(VkPresentModeKHR requested)
   {
-    /*
-       for(const auto& presentMode : m_details.presentModes)
-       {
-       if(presentMode == VK_PRESENT_MODE_MAILBOX_KHR)
-       {
-       m_presentMode = presentMode;
-       return;
-       }
-       }
-       */
+    std::vector<VkPresentModeKHR> preferences{requested};
+    if(requested == VK_PRESENT_MODE_MAILBOX_KHR)
+      preferences.push_back(VK_PRESENT_MODE_IMMEDIATE_KHR);
+    else if(requested == VK_PRESENT_MODE_IMMEDIATE_KHR)
+      preferences.push_back(VK_PRESENT_MODE_MAILBOX_KHR);
+
+    for(auto presentMode : preferences) {
+      if(std::ranges::find(m_details.presentModes, presentMode) != m_details.presentModes.end()) {
+        m_info.presentMode = presentMode;
+        return;
+      }
+    }
+
     m_info.presentMode = VK_PRESENT_MODE_FIFO_KHR;
   }
 
+  auto Swapchain::presentModeName(VkPresentModeKHR presentMode) -> std::string_view
+  {
+    switch(presentMode) {
+      case VK_PRESENT_MODE_FIFO_KHR: return "fifo";
+      case VK_PRESENT_MODE_FIFO_RELAXED_KHR: return "fifo_relaxed";
+      case VK_PRESENT_MODE_MAILBOX_KHR: return "mailbox";
+      case VK_PRESENT_MODE_IMMEDIATE_KHR: return "immediate";
+      default: return "unknown";
+    }
+  }
+
+  auto Swapchain::parsePresentMode(std::string_view name) -> std::optional<VkPresentModeKHR>
+  {
+    for(auto presentMode : {VK_PRESENT_MODE_FIFO_KHR, VK_PRESENT_MODE_FIFO_RELAXED_KHR, VK_PRESENT_MODE_MAILBOX_KHR, VK_PRESENT_MODE_IMMEDIATE_KHR}) {
+      if(presentModeName(presentMode) == name)
+        return presentMode;
+    }
+
+    return std::nullopt;
+  }
+
   void Swapchain::chooseSurfaceFormat()
   {
     for(const auto& surfaceFormat : m_details.formats) {
@@ -155,11 +182,11 @@ namespace vke
 
   void Swapchain::createImageViews()
   {
-    imageViews.resize(images.size());
-    for(size_t i = 0; i < images.size(); ++i) {
+    m_imageViews.resize(m_images.size());
+    for(size_t i = 0; i < m_images.size(); ++i) {
       VkImageViewCreateInfo createInfo{};
       createInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
-      createInfo.image = images[i];
+      createInfo.image = m_images[i];
       createInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
       createInfo.format = m_info.surfaceFormat.format;
       createInfo.components.r = VK_COMPONENT_SWIZZLE_IDENTITY;
@@ -172,46 +199,17 @@ namespace vke
       createInfo.subresourceRange.baseArrayLayer = 0;
       createInfo.subresourceRange.layerCount = 1;
 
-      if(vkCreateImageView(m_device, &createInfo, nullptr, &imageViews[i]) != VK_SUCCESS) {
+      if(vkCreateImageView(m_device, &createInfo, nullptr, &m_imageViews[i]) != VK_SUCCESS) {
         throw std::runtime_error("Failed to create image views");
       }
     }
   }
 
-  void Swapchain::createImageView(VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, VkImageView* imageView)
-  {
-    VkImageViewCreateInfo createInfo{
-      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
-      .image = image,
-      .viewType = VK_IMAGE_VIEW_TYPE_2D,
-      .format = format,
-    };
-
-    createInfo.components = {
-      .r = VK_COMPONENT_SWIZZLE_IDENTITY,
-      .g = VK_COMPONENT_SWIZZLE_IDENTITY,
-      .b = VK_COMPONENT_SWIZZLE_IDENTITY,
-      .a = VK_COMPONENT_SWIZZLE_IDENTITY,
-    };
-
-    createInfo.subresourceRange = {
-      .aspectMask = aspectFlags,
-      .baseMipLevel = 0,
-      .levelCount = 1,
-      .baseArrayLayer = 0,
-      .layerCount = 1,
-    };
-
-    if(vkCreateImageView(m_device, &createInfo, nullptr, imageView) != VK_SUCCESS) {
-      throw std::runtime_error("Failed to create image view");
-    }
-  }
-
   void Swapchain::createRenderPass()
   {
     VkAttachmentDescription colorAttachment{
       .format = m_info.surfaceFormat.format,
-      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .samples = m_info.samples,
       .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
       .storeOp = VK_ATTACHMENT_STORE_OP_STORE, // VK_ATTACHMENT_STORE_OP_DONT_CARE
       .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
@@ -222,7 +220,7 @@ namespace vke
 
     VkAttachmentDescription depthAttachment{
       .format = m_info.depthFormat,
-      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .samples = m_info.samples,
       .loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR,
       .storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE,
       .stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE,
@@ -254,15 +252,8 @@ namespace vke
       // subpass.pPreserveAttachments = //  not used by this subpass, but for which the data must be preserved
     };
 
-    VkSubpassDependency dependency{
-      .srcSubpass = VK_SUBPASS_EXTERNAL,
-      .dstSubpass = 0,
-      .srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-      .dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_EARLY_FRAGMENT_TESTS_BIT,
-      .srcAccessMask = 0,
-      .dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT | VK_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE_BIT,
-    };
-
+    // no subpass dependencies: the render graph synchronizes with pipeline barriers, and its passes have to stay
+    // compatible with this one (only layouts and load/store ops may differ)
     VkAttachmentDescription attachments[]{colorAttachment, depthAttachment};
     VkRenderPassCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO,
@@ -270,39 +261,24 @@ namespace vke
       .pAttachments = attachments,
       .subpassCount = 1,
       .pSubpasses = &subpass,
-      .dependencyCount = 1,
-      .pDependencies = &dependency,
     };
 
     if(vkCreateRenderPass(m_device, &createInfo, nullptr, &m_renderPass) != VK_SUCCESS)
       throw std::runtime_error("Failed to create render pass");
-  }
 
-  void Swapchain::createFramebuffers()
-  {
-    m_framebuffers.resize(imageViews.size());
-
-    VkFramebufferCreateInfo createInfo{};
-    createInfo.sType = VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO;
-    createInfo.renderPass = m_renderPass;
-    createInfo.attachmentCount = {};
-    createInfo.pAttachments = {};
-    createInfo.width = m_info.extent.width;
-    createInfo.height = m_info.extent.height;
-    createInfo.layers = 1;
-
-    for(size_t i = 0; i < imageViews.size(); ++i) {
-      VkImageView attachments[]{
-        imageViews[i],
-        m_depthImageView,
-      };
+    // the same without the color attachment, for the depth only passes
+    VkSubpassDescription depthSubpass{
+      .pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS,
+      .pDepthStencilAttachment = &depthAttachmentRef,
+    };
 
-      createInfo.attachmentCount = std::size(attachments);
-      createInfo.pAttachments = attachments;
+    depthAttachmentRef.attachment = 0;
+    createInfo.attachmentCount = 1;
+    createInfo.pAttachments = &depthAttachment;
+    createInfo.pSubpasses = &depthSubpass;
 
-      if(vkCreateFramebuffer(m_device, &createInfo, nullptr, &m_framebuffers[i]) != VK_SUCCESS)
-        throw std::runtime_error("Failed to framebuffers");
-    }
+    if(vkCreateRenderPass(m_device, &createInfo, nullptr, &m_depthRenderPass) != VK_SUCCESS)
+      throw std::runtime_error("Failed to create depth render pass");
   }
 
   VkResult Swapchain::acquireNextImage(VkSemaphore imageAvailableSemaphore, uint32_t* imageIndex)
@@ -322,28 +298,6 @@ namespace vke
     return format == VK_FORMAT_D32_SFLOAT || format == VK_FORMAT_D24_UNORM_S8_UINT;
   }
 
-  void Swapchain::createDepthResources()
-  {
-    VkImageCreateInfo createInfo{
-      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
-      .flags = {}, // optional
-      .imageType = VK_IMAGE_TYPE_2D,
-      .format = m_info.depthFormat,
-      .extent = {m_info.extent.width, m_info.extent.height, 1},
-      .mipLevels = 1, // maybe?
-      .arrayLayers = 1,
-      .samples = VK_SAMPLE_COUNT_1_BIT,
-      .tiling = VK_IMAGE_TILING_OPTIMAL,
-      .usage = VK_IMAGE_USAGE_DEPTH_STENCIL_ATTACHMENT_BIT,
-      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
-      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
-    };
-
-    MemAllocator::createImage(m_device, createInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_depthImageMemory, &m_depthImage);
-
-    createImageView(m_depthImage, m_info.depthFormat, VK_IMAGE_ASPECT_DEPTH_BIT, &m_depthImageView);
-  }
-
   bool operator==(const VkSurfaceFormatKHR first, const VkSurfaceFormatKHR second)
   {
     return (first.format == second.format) && (first.colorSpace == second.colorSpace);
@@ -362,6 +316,14 @@ namespace vke
     // depth will be implemented latter
   }
 
+  // the render pass only depends on the attachment formats and sample counts (load/store ops and layouts are fixed),
+  // which is what render pass compatibility is about:
+  // https://registry.khronos.org/vulkan/specs/1.3-extensions/html/vkspec.html#renderpass-compatibility
+  bool Swapchain::isRenderPassCompatible(const Info& other) const
+  {
+    return compareSwapchainFormats(other) && m_info.samples == other.samples;
+  }
+
   float Swapchain::aspectRatio() const
   {
     const uint32_t& w = m_info.extent.width;
@@ -4,43 +4,64 @@ namespace vke
 {
   PointLightSystem::PointLightSystem(Device& device, RenderSystemContext context) :
     m_device{device},
-    m_eventRelayer{context.eventRelayer}
+    m_eventRelayer{context.eventRelayer},
+    m_pipelineRegistry{context.pipelineRegistry},
+    m_instanceSetLayout{
+      DescriptorSetLayout::Builder{device}
+        .addBinding(0, VK_DESCRIPTOR_TYPE_STORAGE_BUFFER, VK_SHADER_STAGE_VERTEX_BIT)
+        .build(context.layoutCache)},
+    m_bindless{context.bindless}
   // m_modelManager{context.modelManager}
   {
     m_eventRelayer.setCallback(this, &PointLightSystem::recreateGraphicsPipeline);
 
+    m_instanceBuffers.resize(std::max(context.framesInFlight, 1u));
+    m_instanceSlots.resize(m_instanceBuffers.size(), BindlessTable::invalidSlot);
+
     createPipelineLayout(context.globalDescriptorSetLayout);
-    createGraphicsPipeline(context.renderPass, context.extent);
+    createGraphicsPipeline(context.renderPass);
   }
 
   PointLightSystem::~PointLightSystem()
   {
     vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
+
+    for(uint32_t slot : m_instanceSlots) {
+      if(slot != BindlessTable::invalidSlot)
+        m_bindless->releaseBuffer(slot);
+    }
   }
 
   void PointLightSystem::createPipelineLayout(VkDescriptorSetLayout globalDescriptorSetLayout)
   {
-    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalDescriptorSetLayout};
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalDescriptorSetLayout, m_bindless ? m_bindless->descriptorSetLayout() : m_instanceSetLayout};
+
+    // bindless: the slot of the instances' buffer
+    VkPushConstantRange pushConstantRange{
+      .stageFlags = VK_SHADER_STAGE_VERTEX_BIT,
+      .offset = 0,
+      .size = sizeof(uint32_t),
+    };
 
     VkPipelineLayoutCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
       .setLayoutCount = static_cast<uint32_t>(descriptorSetLayouts.size()),
       .pSetLayouts = descriptorSetLayouts.data(),
-      .pushConstantRangeCount = 0,
-      .pPushConstantRanges = nullptr,
+      .pushConstantRangeCount = m_bindless ? 1u : 0u,
+      .pPushConstantRanges = m_bindless ? &pushConstantRange : nullptr,
     };
 
     if(vkCreatePipelineLayout(m_device, &createInfo, nullptr, &m_pipelineLayout) != VK_SUCCESS)
       throw std::runtime_error("Failed to create pipelineLayout");
   }
 
-  void PointLightSystem::createGraphicsPipeline(VkRenderPass renderPass, VkExtent2D extent)
+  void PointLightSystem::createGraphicsPipeline(VkRenderPass renderPass)
   {
     Pipeline::Config config{};
-    Pipeline::defaultConfig(extent, false, &config);
+    Pipeline::defaultConfig(&config);
 
     Pipeline::ShaderPaths shaderPaths{
-      .vert = m_device.assetsPath().string() + "/build/shaders/pointLight.vert.spv",
+      .vert = m_device.assetsPath().string() + (m_bindless ? "/build/shaders/pointLightBindless.vert.spv" : "/build/shaders/pointLight.vert.spv"),
       .frag = m_device.assetsPath().string() + "/build/shaders/pointLight.frag.spv",
     };
 
@@ -48,30 +69,69 @@ namespace vke
     config.subpass = 0;
     config.pipelineLayout = m_pipelineLayout;
 
-    m_pipeline = std::make_unique<Pipeline>(m_device, shaderPaths, config);
+    // compiled in the background, render() draws nothing until it's ready
+    m_pipeline = m_pipelineRegistry.request(shaderPaths, config, PipelineRegistry::Mode::async);
   }
 
   void PointLightSystem::recreateGraphicsPipeline(event::InvalidPipeline& event)
   {
-    createGraphicsPipeline(event.renderPass, event.extent);
+    createGraphicsPipeline(event.renderPass);
   }
 
   void PointLightSystem::render(FrameInfo info)
   {
-    m_pipeline->bind(info.commandBuffer);
-    /*m_pipeline->bindDescriptorSets(commandBuffer, &m_descriptorSets[imageIndex], m_pipelineLayout);*/
+    VKE_PROFILE_FUNCTION();
+    GpuProfiler::Scope gpuScope{info.gpuProfiler, info.commandBuffer, "PointLightSystem"};
+
+    if(info.lights.empty() || !m_pipelineRegistry.bind(info.commandBuffer, m_pipeline))
+      return;
+
+    m_instances.clear();
+    for(EntityID entity : info.lights) {
+      const auto& light{info.ecs.getComponent<cmp::PointLight>(entity)};
+      m_instances.push_back({
+        .position = {light.position, billboardRadius * light.intensity},
+        .color = {light.color, 1.f},
+      });
+    }
+
+    // the frame's fence was waited on, its buffer (and its bindless slot) is free to be rewritten or replaced
+    uint32_t frame{info.frameIndex % static_cast<uint32_t>(m_instanceBuffers.size())};
+    auto& buffer{m_instanceBuffers[frame]};
+    auto count{static_cast<uint32_t>(m_instances.size())};
+    if(!buffer || buffer->elementCount() < count) {
+      buffer = std::make_unique<Buffer>(m_device, std::max(initialInstances, std::bit_ceil(count)), sizeof(Instance), VK_BUFFER_USAGE_STORAGE_BUFFER_BIT, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+      buffer->mapMemory();
+
+      if(m_bindless && m_instanceSlots[frame] == BindlessTable::invalidSlot)
+        m_instanceSlots[frame] = m_bindless->addBuffer(buffer->descriptorInfo());
+      else if(m_bindless)
+        m_bindless->setBuffer(m_instanceSlots[frame], buffer->descriptorInfo());
+    }
+
+    buffer->write(m_instances.data(), sizeof(Instance) * count);
+    buffer->flush();
 
-    // each object will use the same projectionView, so we calculate it once outside the loop
-    // auto const& projectionView{info.camera.projection() * info.camera.view()}; //
+    VkDescriptorSet instanceSet{};
+    if(m_bindless) {
+      instanceSet = m_bindless->descriptorSet();
+      vkCmdPushConstants(info.commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT, 0, sizeof(uint32_t), &m_instanceSlots[frame]);
+    } else {
+      auto bufferInfo{buffer->descriptorInfo()};
+      DescriptorWriter{m_instanceSetLayout, info.descriptors}
+        .addBuffer(0, &bufferInfo)
+        .allocAndUpdate(&instanceSet);
+    }
 
+    std::array descriptorSets{info.globalDescriptorSet, instanceSet};
     vkCmdBindDescriptorSets(
       info.commandBuffer,
       VK_PIPELINE_BIND_POINT_GRAPHICS,
       m_pipelineLayout,
-      0, 1,
-      &info.globalDescriptorSet,
+      0, static_cast<uint32_t>(descriptorSets.size()),
+      descriptorSets.data(),
       0, nullptr);
 
-    vkCmdDraw(info.commandBuffer, 6, 1, 0, 0);
+    vkCmdDraw(info.commandBuffer, 6, count, 0, 0);
   }
 } // namespace vke
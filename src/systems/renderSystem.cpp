@@ -4,13 +4,18 @@ namespace vke
 {
   RenderSystem::RenderSystem(Device& device, RenderSystemContext context) :
     m_device{device},
-    m_eventRelayer{context.eventRelayer}
+    m_eventRelayer{context.eventRelayer},
+    m_pipelineRegistry{context.pipelineRegistry},
+    m_materials{context.materials}
   // m_modelManager{context.modelManager}
   {
     m_eventRelayer.setCallback(this, &RenderSystem::recreateGraphicsPipeline);
 
-    createPipelineLayout(context.globalDescriptorSetLayout);
-    createGraphicsPipeline(context.renderPass, context.extent);
+    m_indirectBuffers.resize(std::max(context.framesInFlight, 1u));
+    m_depthPrepass = context.depthPrepass;
+
+    createPipelineLayout(context.globalDescriptorSetLayout, context.lightDescriptorSetLayout, context.materials.descriptorSetLayout());
+    createGraphicsPipeline(context.renderPass, context.depthRenderPass);
   }
 
   RenderSystem::~RenderSystem()
@@ -18,7 +23,10 @@ namespace vke
     vkDestroyPipelineLayout(m_device, m_pipelineLayout, nullptr);
   }
 
-  void RenderSystem::createPipelineLayout(VkDescriptorSetLayout globalDescriptorSetLayout)
+  void RenderSystem::createPipelineLayout(
+    VkDescriptorSetLayout globalDescriptorSetLayout,
+    VkDescriptorSetLayout lightDescriptorSetLayout,
+    VkDescriptorSetLayout materialDescriptorSetLayout)
   {
     VkPushConstantRange pushConstantRange{
       .stageFlags = VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT,
@@ -26,7 +34,7 @@ namespace vke
       .size = sizeof(SimplePushConstantData),
     };
 
-    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalDescriptorSetLayout};
+    std::vector<VkDescriptorSetLayout> descriptorSetLayouts{globalDescriptorSetLayout, lightDescriptorSetLayout, materialDescriptorSetLayout};
 
     VkPipelineLayoutCreateInfo createInfo{
       .sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO,
@@ -40,71 +48,321 @@ namespace vke
       throw std::runtime_error("Failed to create pipelineLayout");
   }
 
-  void RenderSystem::createGraphicsPipeline(VkRenderPass renderPass, VkExtent2D extent)
+  void RenderSystem::createGraphicsPipeline(VkRenderPass renderPass, VkRenderPass depthRenderPass)
   {
     Pipeline::Config config{};
-    Pipeline::defaultConfig(extent, false, &config);
-
-    Pipeline::ShaderPaths shaderPaths{
-      .vert = m_device.assetsPath().string() + "/build/shaders/shader.vert.spv",
-      .frag = m_device.assetsPath().string() + "/build/shaders/shader.frag.spv",
-    };
+    Pipeline::defaultConfig(&config);
 
-    config.bindingDescriptions = Model::Vertex::getVertexInputBindingDescription();
-    config.attributeDescriptions = Model::Vertex::getVertexInputAttributeDescription();
     config.renderPass = renderPass;
     config.subpass = 0;
     config.pipelineLayout = m_pipelineLayout;
 
-    m_pipeline = std::make_unique<Pipeline>(m_device, shaderPaths, config);
+    // after the pre-pass the depth is final, only the fragments matching it pass
+    if(m_depthPrepass) {
+      config.depthStencil.depthWriteEnable = VK_FALSE;
+      config.depthStencil.depthCompareOp = VK_COMPARE_OP_LESS_OR_EQUAL;
+    }
+
+    for(auto format : {Model::VertexFormat::standard, Model::VertexFormat::compact}) {
+      Pipeline::ShaderPaths shaderPaths{
+        .vert = m_device.assetsPath().string() + (format == Model::VertexFormat::compact ? "/build/shaders/shaderCompact.vert.spv" : "/build/shaders/shader.vert.spv"),
+        .frag = m_device.assetsPath().string() + "/build/shaders/shader.frag.spv",
+      };
+
+      for(auto layout : {Model::VertexLayout::interleaved, Model::VertexLayout::split}) {
+        config.bindingDescriptions = Model::vertexBindings(format, layout);
+        config.attributeDescriptions = Model::vertexAttributes(format, layout);
+
+        // compiled in the background, render() skips the models whose pipeline isn't ready
+        m_pipelines[pipelineIndex(format, layout)] = m_pipelineRegistry.request(shaderPaths, config, PipelineRegistry::Mode::async);
+      }
+    }
+
+    if(!m_depthPrepass)
+      return;
+
+    Pipeline::Config depthConfig{};
+    Pipeline::defaultConfig(&depthConfig);
+
+    depthConfig.renderPass = depthRenderPass;
+    depthConfig.subpass = 0;
+    depthConfig.pipelineLayout = m_pipelineLayout;
+    depthConfig.colorBlend.attachmentCount = 0;
+
+    // one shader for both formats, the positions only differ in their attribute format
+    Pipeline::ShaderPaths depthShaderPaths{.vert = m_device.assetsPath().string() + "/build/shaders/depth.vert.spv"};
+
+    for(auto format : {Model::VertexFormat::standard, Model::VertexFormat::compact}) {
+      for(auto layout : {Model::VertexLayout::interleaved, Model::VertexLayout::split}) {
+        depthConfig.bindingDescriptions = Model::vertexBindings(format, layout, true);
+        depthConfig.attributeDescriptions = Model::vertexAttributes(format, layout, true);
+
+        m_depthPipelines[pipelineIndex(format, layout)] = m_pipelineRegistry.request(depthShaderPaths, depthConfig, PipelineRegistry::Mode::async);
+      }
+    }
+  }
+
+  auto RenderSystem::pipelineIndex(Model::VertexFormat format, Model::VertexLayout layout) -> size_t
+  {
+    return static_cast<size_t>(format) * 2 + static_cast<size_t>(layout);
+  }
+
+  // the simplification error of a lod is in object space, the bounding sphere's nearest point tells how many
+  // pixels an object space unit covers at most
+  auto RenderSystem::selectLod(const FrameInfo& info, const cmp::Transform3D& transform, cmp::Common& common) -> uint32_t
+  {
+    const Model& model{*common.model()};
+    if(model.lodCount() == 1)
+      return 0;
+
+    float scale{std::max({glm::abs(transform.scale.x), glm::abs(transform.scale.y), glm::abs(transform.scale.z)})};
+    glm::vec4 sphere{model.boundingSphere()};
+    glm::vec3 center{transform.mat4() * glm::vec4{sphere.x, sphere.y, sphere.z, 1.f}};
+
+    float distance{glm::length(center - info.camera.position()) - sphere.w * scale};
+    float pixelsPerUnit{scale * 0.5f * info.extent.height * glm::abs(info.camera.projection()[1][1]) / std::max(distance, 1e-3f)};
+
+    uint32_t lod{model.selectLod(pixelsPerUnit, common.lod(), lodPixelError, lodHysteresis)};
+    common.setLod(lod);
+    return lod;
+  }
+
+  // Gribb, Hartmann: every plane is a sum of rows of the matrix. vulkan's depth is [0, 1], so near is row 2 alone
+  auto RenderSystem::frustumPlanes(const glm::mat4& projectionView) -> Frustum
+  {
+    auto row = [&](int i) { return glm::vec4{projectionView[0][i], projectionView[1][i], projectionView[2][i], projectionView[3][i]}; };
+
+    Frustum frustum{
+      row(3) + row(0),
+      row(3) - row(0),
+      row(3) + row(1),
+      row(3) - row(1),
+      row(2),
+      row(3) - row(2),
+    };
+
+    for(glm::vec4& plane : frustum)
+      plane /= glm::length(glm::vec3{plane});
+
+    return frustum;
+  }
+
+  bool RenderSystem::cullMeshlets(cmp::Transform3D& transform, const Model& model, const Frustum& frustum, const glm::vec3& camera, Draw* draw)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    // the meshlets are in the mesh's space, the compact dequantization doesn't apply
+    glm::mat4 modelMatrix{transform.mat4()};
+    glm::mat3 normalMatrix{transform.normalMatrix()};
+    glm::vec3 scale{glm::abs(transform.scale)};
+    float maxScale{std::max({scale.x, scale.y, scale.z})};
+
+    // a non uniform scale bends the cones, such models only get the frustum test
+    bool cones{maxScale - std::min({scale.x, scale.y, scale.z}) <= maxScale * 1e-3f};
+
+    m_drawCommands.clear();
+    for(const Model::Meshlet& meshlet : model.meshlets()) {
+      glm::vec3 center{modelMatrix * glm::vec4{meshlet.center, 1.f}};
+      float radius{meshlet.radius * maxScale};
+      if(std::ranges::any_of(frustum, [&](const glm::vec4& plane) { return glm::dot(glm::vec3{plane}, center) + plane.w < -radius; }))
+        continue;
+
+      if(cones && meshlet.coneCutoff < 1.f) {
+        glm::vec3 apex{modelMatrix * glm::vec4{meshlet.coneApex, 1.f}};
+        glm::vec3 axis{glm::normalize(normalMatrix * meshlet.coneAxis)};
+        if(glm::dot(glm::normalize(apex - camera), axis) >= meshlet.coneCutoff)
+          continue;
+      }
+
+      m_drawCommands.push_back({
+        .indexCount = meshlet.triangleCount * 3,
+        .instanceCount = 1,
+        .firstIndex = meshlet.firstIndex,
+        .vertexOffset = meshlet.vertexOffset,
+        .firstInstance = 0,
+      });
+    }
+
+    auto count{static_cast<uint32_t>(m_drawCommands.size())};
+    if(m_indirectDraws + count > m_indirectBuffer->elementCount()) {
+      m_indirectCapacity = std::max(m_indirectCapacity, std::bit_ceil(m_indirectDraws + count));
+      return false;
+    }
+
+    draw->firstCommand = m_indirectDraws;
+    draw->commandCount = count;
+
+    constexpr uint32_t stride{sizeof(VkDrawIndexedIndirectCommand)};
+    m_indirectBuffer->write(m_drawCommands.data(), VkDeviceSize{count} * stride, VkDeviceSize{m_indirectDraws} * stride);
+    m_indirectDraws += count;
+
+    return true;
   }
 
   void RenderSystem::recreateGraphicsPipeline(event::InvalidPipeline& event)
   {
-    createGraphicsPipeline(event.renderPass, event.extent);
+    createGraphicsPipeline(event.renderPass, event.depthRenderPass);
   }
 
-  void RenderSystem::render(FrameInfo info)
+  void RenderSystem::prepare(const FrameInfo& info)
   {
-    m_pipeline->bind(info.commandBuffer);
-    /*m_pipeline->bindDescriptorSets(commandBuffer, &m_descriptorSets[imageIndex], m_pipelineLayout);*/
+    VKE_PROFILE_FUNCTION();
 
-    // each object will use the same projectionView, so we calculate it once outside the loop
-    // auto const& projectionView{info.camera.projection() * info.camera.view()}; //
+    // the frame's fence was waited on, its indirect buffer is free to be rewritten or replaced
+    auto& indirectBuffer{m_indirectBuffers[info.frameIndex % m_indirectBuffers.size()]};
+    if(!indirectBuffer || indirectBuffer->elementCount() < m_indirectCapacity) {
+      indirectBuffer = std::make_unique<Buffer>(
+        m_device,
+        m_indirectCapacity,
+        sizeof(VkDrawIndexedIndirectCommand),
+        VK_BUFFER_USAGE_INDIRECT_BUFFER_BIT,
+        VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT);
+      indirectBuffer->mapMemory();
+    }
 
-    vkCmdBindDescriptorSets(
-      info.commandBuffer,
-      VK_PIPELINE_BIND_POINT_GRAPHICS,
-      m_pipelineLayout,
-      0, 1,
-      &info.globalDescriptorSet,
-      0, nullptr);
+    m_indirectBuffer = indirectBuffer.get();
+    m_indirectDraws = 0;
+    m_draws.clear();
+    m_queue.clear();
+    m_meshes.clear();
 
-    // auto projectionView{info.camera.projection() * info.camera.view()};
+    auto frustum{frustumPlanes(info.camera.projection() * info.camera.view())};
+    glm::vec3 camera{info.camera.position()};
 
     for(auto& entity : info.entities) {
       using namespace cmp;
       Transform3D& transform{info.ecs.getComponent<Transform3D>(entity)};
       Common& common{info.ecs.getComponent<cmp::Common>(entity)};
+      uint32_t material{info.ecs.getComponent<cmp::Material>(entity).id};
+
+      // released, see ModelManager::release
+      if(!common.model())
+        continue;
 
-      // auto modelMatrix{transform.mat4()};
-      SimplePushConstantData push{
-        //.transform = projectionView * modelMatrix,
-        .modelMatrix = transform.mat4(),
-        .normalMatrix = transform.normalMatrix(), // glm automatically converts the mat3 to mat4
+      Model& model{*common.model()};
+      Draw draw{
+        .model = &model,
+        .pipeline = pipelineIndex(model.vertexFormat(), model.vertexLayout()),
+        .material = material,
+        .push = {
+          // compact positions are unorm16 inside the bounds, scaled back here instead of in the shader
+          .modelMatrix = transform.mat4() * model.dequantization(),
+          .normalMatrix = transform.normalMatrix(), // glm automatically converts the mat3 to mat4
+        },
+        .lod = selectLod(info, transform, common),
+        .firstCommand = 0,
+        .commandCount = 0,
       };
 
-      vkCmdPushConstants(info.commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &push);
+      // only lod 0 is clustered, the coarser ones are already cheap. when the meshlets don't fit in the
+      // indirect buffer the whole model is drawn
+      if(draw.lod == 0 && !model.meshlets().empty() && cullMeshlets(transform, model, frustum, camera, &draw) && !draw.commandCount)
+        continue;
 
-      // model.model->bindBuffers(commandBuffer);
-      // model.model->drawIndexed(commandBuffer);
+      // front to back inside a state, the distance of the bounding sphere's center over the far plane
+      glm::vec4 sphere{model.boundingSphere()};
+      glm::vec3 center{transform.mat4() * glm::vec4{sphere.x, sphere.y, sphere.z, 1.f}};
+      float depth{glm::length(center - camera) / info.camera.farPlane()};
 
-      if(!common.model())
-        throw std::runtime_error("fix-me non-existent-model on-rendersystem-renderEntities()");
+      auto mesh{m_meshes.try_emplace(&model, static_cast<uint32_t>(m_meshes.size())).first->second};
+      m_queue.push(RenderQueue::makeKey(0, static_cast<uint32_t>(draw.pipeline), draw.material, mesh, depth), static_cast<uint32_t>(m_draws.size()));
+      m_draws.push_back(draw);
+    }
+
+    m_queue.sort();
+
+    if(m_indirectDraws)
+      m_indirectBuffer->flush();
+  }
+
+  void RenderSystem::record(const FrameInfo& info, std::span<const PipelineRegistry::Handle> pipelines, bool positionsOnly)
+  {
+    std::array descriptorSets{info.globalDescriptorSet, info.lightDescriptorSet};
+    vkCmdBindDescriptorSets(
+      info.commandBuffer,
+      VK_PIPELINE_BIND_POINT_GRAPHICS,
+      m_pipelineLayout,
+      0, static_cast<uint32_t>(descriptorSets.size()),
+      descriptorSets.data(),
+      0, nullptr);
+
+    // without multiDrawIndirect every command is its own call, still no cpu side index ranges to walk
+    constexpr uint32_t stride{sizeof(VkDrawIndexedIndirectCommand)};
+    uint32_t maxCount{m_device.enabledFeatures().multiDrawIndirect ? m_device.physicalInfo().deviceProperties.limits.maxDrawIndirectCount : 1};
+
+    // models pick the pipeline matching their vertex format and layout. sorted, each pipeline, material and
+    // mesh is bound once per run of draws sharing it; pipelines share the layout, the sets stay bound across them
+    std::optional<uint32_t> boundPipeline;
+    std::optional<uint32_t> boundMaterial;
+    const Model* boundModel{};
+    bool drawable{};
+
+    for(const RenderQueue::Entry& entry : m_queue.entries()) {
+      const Draw& draw{m_draws[entry.item]};
+
+      if(RenderQueue::pipeline(entry.key) != boundPipeline) {
+        boundPipeline = RenderQueue::pipeline(entry.key);
+        drawable = m_pipelineRegistry.bind(info.commandBuffer, pipelines[draw.pipeline]);
+
+        // the pre-pass skipped these, there's no depth for them to match
+        if(m_depthPrepass && !positionsOnly)
+          drawable = drawable && m_pipelineRegistry.isReady(m_depthPipelines[draw.pipeline]);
+      }
+
+      if(!drawable)
+        continue;
+
+      // the depth shader doesn't read the material
+      if(!positionsOnly && draw.material != boundMaterial) {
+        boundMaterial = draw.material;
+        VkDescriptorSet materialSet{m_materials.get(draw.material).descriptorSet};
+        assert(materialSet && "The material wasn't uploaded");
+        vkCmdBindDescriptorSets(info.commandBuffer, VK_PIPELINE_BIND_POINT_GRAPHICS, m_pipelineLayout, 2, 1, &materialSet, 0, nullptr);
+      }
+
+      vkCmdPushConstants(info.commandBuffer, m_pipelineLayout, VK_SHADER_STAGE_VERTEX_BIT | VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(SimplePushConstantData), &draw.push);
+
+      // the mesh field only orders the draws, the model itself tells whether the buffers changed
+      if(draw.model != boundModel) {
+        boundModel = draw.model;
+        if(positionsOnly)
+          draw.model->bindPositions(info.commandBuffer);
+        else
+          draw.model->bindBuffers(info.commandBuffer);
+      }
+
+      if(!draw.commandCount) {
+        draw.model->draw(info.commandBuffer, draw.lod);
+        continue;
+      }
 
-      common.model()->bindBuffers(info.commandBuffer);
-      common.model()->draw(info.commandBuffer);
-      // model.bindIndexBuffer(commandBuffer);
+      for(uint32_t first{}; first < draw.commandCount; first += maxCount) {
+        VkDeviceSize offset{VkDeviceSize{draw.firstCommand + first} * stride};
+        vkCmdDrawIndexedIndirect(info.commandBuffer, m_indirectBuffer->handle(), offset, std::min(maxCount, draw.commandCount - first), stride);
+      }
     }
   }
+
+  void RenderSystem::render(FrameInfo info)
+  {
+    VKE_PROFILE_FUNCTION();
+    GpuProfiler::Scope gpuScope{info.gpuProfiler, info.commandBuffer, "RenderSystem"};
+
+    // with the pre-pass, renderDepth() prepared the frame
+    if(!m_depthPrepass)
+      prepare(info);
+
+    record(info, m_pipelines, false);
+  }
+
+  void RenderSystem::renderDepth(FrameInfo info)
+  {
+    VKE_PROFILE_FUNCTION();
+    GpuProfiler::Scope gpuScope{info.gpuProfiler, info.commandBuffer, "RenderSystem::depth"};
+
+    assert(m_depthPrepass && "The depth pre-pass pipelines weren't created");
+
+    prepare(info);
+    record(info, m_depthPipelines, true);
+  }
 } // namespace vke
@@ -0,0 +1,342 @@
+#define STB_IMAGE_IMPLEMENTATION
+#include "texture.hpp"
+
+#include "meshCache.hpp"
+#include "uploadBatch.hpp"
+
+#include <stb_image.h>
+
+namespace vke
+{
+  namespace
+  {
+    // the ktx2 header, 80 bytes, then the level index (https://registry.khronos.org/KTX/specs/2.0/ktxspec.v2.html)
+    constexpr std::array<uint8_t, 12> ktx2Identifier{0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    constexpr size_t ktx2HeaderSize{80};
+    constexpr size_t ktx2LevelSize{24}; // byteOffset, byteLength, uncompressedByteLength
+
+    template<typename T>
+    auto read(std::span<const std::byte> bytes, size_t offset) -> T
+    {
+      T value;
+      std::memcpy(&value, bytes.data() + offset, sizeof(T));
+      return value;
+    }
+
+    bool isSrgb(VkFormat format)
+    {
+      return format == VK_FORMAT_R8G8B8A8_SRGB || format == VK_FORMAT_B8G8R8A8_SRGB;
+    }
+
+    bool isBlockCompressed(VkFormat format)
+    {
+      return format >= VK_FORMAT_BC1_RGB_UNORM_BLOCK && format <= VK_FORMAT_BC7_SRGB_BLOCK;
+    }
+
+    auto srgbToLinear(float value) -> float
+    {
+      return value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+    }
+
+    auto linearToSrgb(float value) -> float
+    {
+      return value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+    }
+  } // namespace
+
+  Texture::Texture(Device& device, const Builder& builder, UploadBatch* upload) :
+    m_device{device},
+    m_format{builder.format},
+    m_extent{builder.width, builder.height},
+    m_mipLevels{static_cast<uint32_t>(builder.levels.size())}
+  {
+    assert(m_mipLevels && "Texture without levels");
+
+    VkImageCreateInfo createInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO,
+      .imageType = VK_IMAGE_TYPE_2D,
+      .format = m_format,
+      .extent = {m_extent.width, m_extent.height, 1},
+      .mipLevels = m_mipLevels,
+      .arrayLayers = 1,
+      .samples = VK_SAMPLE_COUNT_1_BIT,
+      .tiling = VK_IMAGE_TILING_OPTIMAL,
+      .usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
+      .sharingMode = VK_SHARING_MODE_EXCLUSIVE,
+      .initialLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+    };
+
+    // written on the transfer queue, sampled on the graphics one, like the buffers
+    uint32_t indices[]{device.queues().graphicsFamily, device.queues().transferFamily};
+    if(device.queues().graphicsFamily != device.queues().transferFamily) {
+      createInfo.sharingMode = VK_SHARING_MODE_CONCURRENT;
+      createInfo.queueFamilyIndexCount = std::size(indices);
+      createInfo.pQueueFamilyIndices = indices;
+    }
+
+    MemAllocator::createImage(m_device, createInfo, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, &m_memory, &m_image);
+
+    VkMemoryRequirements requirements;
+    vkGetImageMemoryRequirements(m_device, m_image, &requirements);
+    m_memorySize = requirements.size;
+
+    VkImageViewCreateInfo viewInfo{
+      .sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO,
+      .image = m_image,
+      .viewType = VK_IMAGE_VIEW_TYPE_2D,
+      .format = m_format,
+      .subresourceRange = {
+        .aspectMask = VK_IMAGE_ASPECT_COLOR_BIT,
+        .baseMipLevel = 0,
+        .levelCount = m_mipLevels,
+        .baseArrayLayer = 0,
+        .layerCount = 1,
+      },
+    };
+
+    if(vkCreateImageView(m_device, &viewInfo, nullptr, &m_view) != VK_SUCCESS)
+      throw std::runtime_error("Failed to create texture image view");
+
+    // only the span covering the levels goes to the staging buffer, not a ktx2 file's header
+    VkDeviceSize first{builder.levels.front().offset};
+    VkDeviceSize last{};
+    for(const Level& level : builder.levels) {
+      first = std::min(first, level.offset);
+      last = std::max(last, level.offset + level.size);
+    }
+
+    std::vector<VkBufferImageCopy> copies;
+    for(uint32_t i{}; i < m_mipLevels; ++i) {
+      const Level& level{builder.levels[i]};
+      copies.push_back({
+        .bufferOffset = level.offset - first,
+        .bufferRowLength = 0, // tightly packed
+        .bufferImageHeight = 0,
+        .imageSubresource = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT, .mipLevel = i, .baseArrayLayer = 0, .layerCount = 1},
+        .imageOffset = {0, 0, 0},
+        .imageExtent = {level.width, level.height, 1},
+      });
+    }
+
+    upload->add(m_image, builder.data().subspan(first, last - first), copies);
+  }
+
+  Texture::~Texture()
+  {
+    vkDestroyImageView(m_device, m_view, nullptr);
+    vkDestroyImage(m_device, m_image, nullptr);
+    vkFreeMemory(m_device, m_memory, nullptr);
+  }
+
+  bool Texture::isSupported(Device& device, VkFormat format)
+  {
+    if(!blockSize(format) || (isBlockCompressed(format) && !device.enabledFeatures().textureCompressionBC))
+      return false;
+
+    VkFormatProperties properties;
+    vkGetPhysicalDeviceFormatProperties(device.physical(), format, &properties);
+
+    constexpr VkFormatFeatureFlags required{VK_FORMAT_FEATURE_SAMPLED_IMAGE_BIT | VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT};
+    return (properties.optimalTilingFeatures & required) == required;
+  }
+
+  auto Texture::blockSize(VkFormat format) -> std::optional<std::pair<uint32_t, uint32_t>>
+  {
+    switch(format) {
+      case VK_FORMAT_R8G8B8A8_UNORM:
+      case VK_FORMAT_R8G8B8A8_SRGB:
+      case VK_FORMAT_B8G8R8A8_UNORM:
+      case VK_FORMAT_B8G8R8A8_SRGB:
+        return std::pair{4u, 1u};
+      default:
+        break;
+    }
+
+    if(!isBlockCompressed(format))
+      return std::nullopt;
+
+    // bc1 and bc4 pack a 4x4 block in 8 bytes, the others in 16
+    bool halfBlock{format <= VK_FORMAT_BC1_RGBA_SRGB_BLOCK || format == VK_FORMAT_BC4_UNORM_BLOCK || format == VK_FORMAT_BC4_SNORM_BLOCK};
+    return std::pair{halfBlock ? 8u : 16u, 4u};
+  }
+
+  auto Texture::mipCount(uint32_t width, uint32_t height) -> uint32_t
+  {
+    return std::bit_width(std::max({width, height, 1u}));
+  }
+
+  void Texture::Builder::load(const std::filesystem::path& path, bool srgb)
+  {
+    VKE_PROFILE_FUNCTION();
+
+    auto mapping{std::make_shared<const MappedFile>(path)};
+
+    // pre-compressed, uploaded straight from the mapping
+    if(path.extension() == ".ktx2") {
+      parseKtx2(mapping->bytes());
+      m_mapping = std::move(mapping);
+      return;
+    }
+
+    decode(mapping->bytes(), srgb);
+    generateMips();
+  }
+
+  void Texture::Builder::setPixels(std::span<const std::byte> rgba, uint32_t width, uint32_t height, bool srgb)
+  {
+    assert(rgba.size() == VkDeviceSize{width} * height * 4 && "Not width * height rgba8 pixels");
+
+    m_mapping.reset();
+    m_mappedData = {};
+
+    format = srgb ? VK_FORMAT_R8G8B8A8_SRGB : VK_FORMAT_R8G8B8A8_UNORM;
+    this->width = width;
+    this->height = height;
+    pixels.assign(rgba.begin(), rgba.end());
+    levels = {{.offset = 0, .size = rgba.size(), .width = width, .height = height}};
+  }
+
+  void Texture::Builder::decode(std::span<const std::byte> encoded, bool srgb)
+  {
+    int w{};
+    int h{};
+    int channels{};
+    stbi_uc* decoded{stbi_load_from_memory(reinterpret_cast<const stbi_uc*>(encoded.data()), static_cast<int>(encoded.size()), &w, &h, &channels, 4)};
+    if(!decoded)
+      throw std::runtime_error(std::string{"Failed to decode image: "} + stbi_failure_reason());
+
+    auto bytes{std::as_bytes(std::span{decoded, static_cast<size_t>(w) * h * 4})};
+    setPixels(bytes, w, h, srgb);
+    stbi_image_free(decoded);
+  }
+
+  void Texture::Builder::parseKtx2(std::span<const std::byte> file)
+  {
+    if(file.size() < ktx2HeaderSize || !std::ranges::equal(file.first(ktx2Identifier.size()), std::as_bytes(std::span{ktx2Identifier})))
+      throw std::runtime_error("Failed to parse ktx2, not a ktx2 file");
+
+    auto field = [&](uint32_t index) { return read<uint32_t>(file, ktx2Identifier.size() + index * sizeof(uint32_t)); };
+    auto vkFormat{static_cast<VkFormat>(field(0))};
+    uint32_t pixelWidth{field(2)};
+    uint32_t pixelHeight{field(3)};
+    uint32_t pixelDepth{field(4)};
+    uint32_t layerCount{field(5)};
+    uint32_t faceCount{field(6)};
+    uint32_t levelCount{std::max(field(7), 1u)};
+    uint32_t supercompression{field(8)};
+
+    // basis universal (format undefined) and zstd would need a transcoder, which is what ktx2 avoids here
+    auto block{blockSize(vkFormat)};
+    if(!block)
+      throw std::runtime_error("Failed to parse ktx2, unsupported format " + std::to_string(vkFormat));
+    if(supercompression)
+      throw std::runtime_error("Failed to parse ktx2, supercompression isn't supported");
+    if(!pixelWidth || !pixelHeight || pixelDepth > 1 || layerCount > 1 || faceCount != 1)
+      throw std::runtime_error("Failed to parse ktx2, only 2d textures are supported");
+    if(levelCount > mipCount(pixelWidth, pixelHeight) || ktx2HeaderSize + levelCount * ktx2LevelSize > file.size())
+      throw std::runtime_error("Failed to parse ktx2, bad level count");
+
+    auto [blockBytes, blockWidth]{*block};
+    std::vector<Level> parsed;
+    for(uint32_t i{}; i < levelCount; ++i) {
+      size_t entry{ktx2HeaderSize + i * ktx2LevelSize};
+      auto offset{read<uint64_t>(file, entry)};
+      auto size{read<uint64_t>(file, entry + sizeof(uint64_t))};
+
+      uint32_t w{std::max(pixelWidth >> i, 1u)};
+      uint32_t h{std::max(pixelHeight >> i, 1u)};
+      uint64_t expected{uint64_t{(w + blockWidth - 1) / blockWidth} * ((h + blockWidth - 1) / blockWidth) * blockBytes};
+
+      if(offset > file.size() || size > file.size() - offset || size < expected || offset % std::lcm(blockBytes, 4u))
+        throw std::runtime_error("Failed to parse ktx2, level " + std::to_string(i) + " is out of the file or misaligned");
+
+      parsed.push_back({.offset = offset, .size = expected, .width = w, .height = h});
+    }
+
+    format = vkFormat;
+    width = pixelWidth;
+    height = pixelHeight;
+    levels = std::move(parsed);
+    pixels.clear();
+    m_mapping.reset();
+    m_mappedData = file;
+  }
+
+  void Texture::Builder::generateMips()
+  {
+    VKE_PROFILE_FUNCTION();
+
+    assert(levels.size() == 1 && m_mappedData.empty() && blockSize(format) == std::pair(4u, 1u) && "Mips are generated from a single rgba8 level");
+
+    bool srgb{isSrgb(format)};
+    std::array<float, 256> toLinear;
+    for(uint32_t i{}; i < 256; ++i)
+      toLinear[i] = srgb ? srgbToLinear(i / 255.f) : i / 255.f;
+
+    // the previous level, in linear space, alpha is never srgb. a texel's weight is how many texels of level 0
+    // it covers, so the folded rows and columns don't count for less further down the chain
+    std::vector<glm::vec4> source(size_t{width} * height);
+    std::vector<float> sourceWeights(source.size(), 1.f);
+    for(size_t i{}; i < source.size(); ++i) {
+      const auto* texel{reinterpret_cast<const uint8_t*>(pixels.data()) + i * 4};
+      source[i] = {toLinear[texel[0]], toLinear[texel[1]], toLinear[texel[2]], texel[3] / 255.f};
+    }
+
+    uint32_t count{mipCount(width, height)};
+    VkDeviceSize size{levels.front().size};
+    for(uint32_t i{1}; i < count; ++i) {
+      uint32_t w{std::max(width >> i, 1u)};
+      uint32_t h{std::max(height >> i, 1u)};
+      levels.push_back({.offset = size, .size = VkDeviceSize{w} * h * 4, .width = w, .height = h});
+      size += levels.back().size;
+    }
+
+    pixels.resize(size);
+
+    auto quantize = [](float value) { return static_cast<uint8_t>(std::clamp(value, 0.f, 1.f) * 255.f + 0.5f); };
+
+    std::vector<glm::vec4> target;
+    std::vector<float> targetWeights;
+    for(uint32_t i{1}; i < count; ++i) {
+      const Level& previous{levels[i - 1]};
+      const Level& level{levels[i]};
+      target.assign(size_t{level.width} * level.height, glm::vec4{0.f});
+      targetWeights.assign(target.size(), 0.f);
+
+      auto* out{reinterpret_cast<uint8_t*>(pixels.data() + level.offset)};
+      for(uint32_t y{}; y < level.height; ++y) {
+        uint32_t y1{y + 1 == level.height ? previous.height : std::min(2 * y + 2, previous.height)};
+        for(uint32_t x{}; x < level.width; ++x) {
+          uint32_t x1{x + 1 == level.width ? previous.width : std::min(2 * x + 2, previous.width)};
+
+          glm::vec4 sum{0.f};
+          float weight{};
+          for(uint32_t sy{2 * y}; sy < y1; ++sy) {
+            for(uint32_t sx{2 * x}; sx < x1; ++sx) {
+              size_t index{size_t{sy} * previous.width + sx};
+              sum += source[index] * sourceWeights[index];
+              weight += sourceWeights[index];
+            }
+          }
+
+          glm::vec4 texel{sum / weight};
+          target[size_t{y} * level.width + x] = texel;
+          targetWeights[size_t{y} * level.width + x] = weight;
+
+          uint8_t* result{out + (size_t{y} * level.width + x) * 4};
+          for(int c{}; c < 3; ++c)
+            result[c] = quantize(srgb ? linearToSrgb(texel[c]) : texel[c]);
+          result[3] = quantize(texel.w);
+        }
+      }
+
+      source.swap(target);
+      sourceWeights.swap(targetWeights);
+    }
+  }
+
+  auto Texture::Builder::data() const -> std::span<const std::byte>
+  {
+    return m_mappedData.empty() ? std::span<const std::byte>{pixels} : m_mappedData;
+  }
+} // namespace vke
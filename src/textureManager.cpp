@@ -0,0 +1,163 @@
+#include "textureManager.hpp"
+
+namespace vke
+{
+  TextureManager::TextureManager(Device& device, ThreadPool& threadPool) :
+      m_device{device},
+      m_threadPool{threadPool},
+      m_samplers{device}
+  {
+    constexpr std::array<uint8_t, 4> white{255, 255, 255, 255};
+
+    Texture::Builder builder{};
+    builder.setPixels(std::as_bytes(std::span{white}), 1, 1);
+
+    UploadBatch upload{m_device};
+    m_placeholder = std::make_unique<Texture>(m_device, builder, &upload);
+    upload.submit();
+    upload.wait();
+  }
+
+  TextureManager::~TextureManager()
+  {
+    for(auto& task : m_tasks)
+      task.wait();
+
+    m_upload.reset(); // waits for its fence
+    m_slots.clear();
+  }
+
+  auto TextureManager::load(std::filesystem::path path, bool srgb) -> Handle
+  {
+    auto key{std::filesystem::weakly_canonical(path).string() + (srgb ? "" : "#linear")};
+
+    if(auto it{m_pathSlots.find(key)}; it != m_pathSlots.end())
+      return {it->second};
+
+    Handle handle{static_cast<uint32_t>(m_slots.size())};
+    m_slots.push_back({.path = std::move(path), .srgb = srgb});
+    m_pathSlots.emplace(std::move(key), handle.index);
+
+    startLoad(handle.index);
+    return handle;
+  }
+
+  void TextureManager::startLoad(uint32_t slot)
+  {
+    m_slots[slot].loading = true;
+
+    m_tasks.push_back(m_threadPool.submit([this, path = m_slots[slot].path, srgb = m_slots[slot].srgb, slot]() {
+      std::optional<Texture::Builder> builder;
+
+      try {
+        builder.emplace(path, srgb);
+      } catch(const std::exception& e) {
+        // stays on the placeholder
+        std::cerr << clr::red << "[TextureManager] " << clr::white << path.string() << ": " << e.what() << std::endl;
+        builder.reset();
+      }
+
+      std::lock_guard lock{m_mutex};
+      m_loaded.push_back({slot, std::move(builder)});
+    }));
+  }
+
+  void TextureManager::update()
+  {
+    VKE_PROFILE_FUNCTION();
+
+    std::erase_if(m_tasks, [](const std::future<void>& task) {
+      return task.wait_for(std::chrono::seconds{0}) == std::future_status::ready;
+    });
+
+    // a single batch in flight, whatever finished meanwhile goes into the next one
+    if(m_upload && m_upload->batch->isComplete())
+      finishUpload();
+
+    if(!m_upload)
+      startUpload();
+  }
+
+  void TextureManager::startUpload()
+  {
+    std::vector<Loaded> loaded;
+    {
+      std::lock_guard lock{m_mutex};
+      loaded.swap(m_loaded);
+    }
+
+    if(loaded.empty())
+      return;
+
+    Upload upload{.batch = std::make_unique<UploadBatch>(m_device)};
+
+    for(auto& [index, builder] : loaded) {
+      Slot& slot{m_slots[index]};
+      if(builder && !Texture::isSupported(m_device, builder->format)) {
+        std::cerr << clr::red << "[TextureManager] " << clr::white << slot.path.string() << ": format " << builder->format << " can't be sampled on this device" << std::endl;
+        builder.reset();
+      }
+
+      if(!builder) {
+        slot.loading = false;
+        continue;
+      }
+
+      auto texture{std::make_unique<Texture>(m_device, *builder, upload.batch.get())};
+      m_residentMemory += texture->memorySize();
+      upload.textures.emplace_back(index, std::move(texture));
+    }
+
+    // the builders (and their mapped files) can go once the data sits in the staging buffer
+    upload.batch->submit();
+    m_upload = std::move(upload);
+  }
+
+  void TextureManager::finishUpload()
+  {
+    for(auto& [index, texture] : m_upload->textures) {
+      Slot& slot{m_slots[index]};
+      slot.texture = std::move(texture);
+      slot.loading = false;
+    }
+
+    m_upload.reset();
+  }
+
+  void TextureManager::waitIdle()
+  {
+    for(auto& task : m_tasks)
+      task.wait();
+    m_tasks.clear();
+
+    while(true) {
+      if(m_upload)
+        m_upload->batch->wait();
+
+      update();
+
+      if(!m_upload)
+        break;
+    }
+  }
+
+  bool TextureManager::isReady(Handle handle) const
+  {
+    return m_slots[handle.index].texture != nullptr;
+  }
+
+  auto TextureManager::get(Handle handle) -> Texture&
+  {
+    Texture* texture{handle.isValid() ? m_slots[handle.index].texture.get() : nullptr};
+    return texture ? *texture : *m_placeholder;
+  }
+
+  auto TextureManager::descriptorInfo(Handle handle, const SamplerState& sampler) -> VkDescriptorImageInfo
+  {
+    return {
+      .sampler = m_samplers.get(sampler),
+      .imageView = get(handle).view(),
+      .imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+    };
+  }
+} // namespace vke
@@ -0,0 +1,102 @@
+#include "threadPool.hpp"
+
+namespace vke
+{
+  ThreadPool::ThreadPool(uint32_t threadCount)
+  {
+    m_workers.reserve(threadCount);
+    for(uint32_t i{}; i < threadCount; ++i)
+      m_workers.emplace_back(&ThreadPool::work, this);
+  }
+
+  ThreadPool::~ThreadPool()
+  {
+    {
+      std::lock_guard lock{m_mutex};
+      m_stopping = true;
+    }
+
+    m_condition.notify_all();
+
+    for(auto& worker : m_workers)
+      worker.join();
+  }
+
+  // leaves a core for the main thread
+  auto ThreadPool::defaultThreadCount() -> uint32_t
+  {
+    uint32_t cores{std::thread::hardware_concurrency()};
+    return cores > 2 ? cores - 1 : 1;
+  }
+
+  void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& body)
+  {
+    struct State
+    {
+      const std::function<void(uint32_t)>* body;
+      uint32_t count;
+      std::atomic<uint32_t> next{};
+      std::atomic<uint32_t> done{};
+      std::mutex mutex;
+      std::condition_variable finished;
+      std::exception_ptr exception;
+    };
+
+    if(!count)
+      return;
+
+    auto state{std::make_shared<State>()};
+    state->body = &body;
+    state->count = count;
+
+    // helpers that start late find nothing left and never touch body
+    auto drain{[](State& state) {
+      for(uint32_t i{state.next++}; i < state.count; i = state.next++) {
+        try {
+          (*state.body)(i);
+        } catch(...) {
+          std::lock_guard lock{state.mutex};
+          if(!state.exception)
+            state.exception = std::current_exception();
+        }
+
+        if(++state.done == state.count) {
+          std::lock_guard lock{state.mutex};
+          state.finished.notify_all();
+        }
+      }
+    }};
+
+    uint32_t helpers{std::min(size(), count - 1)};
+    for(uint32_t i{}; i < helpers; ++i)
+      submit([state, drain]() { drain(*state); });
+
+    drain(*state);
+
+    std::unique_lock lock{state->mutex};
+    state->finished.wait(lock, [&state]() { return state->done == state->count; });
+
+    if(state->exception)
+      std::rethrow_exception(state->exception);
+  }
+
+  void ThreadPool::work()
+  {
+    while(true) {
+      std::function<void()> task;
+
+      {
+        std::unique_lock lock{m_mutex};
+        m_condition.wait(lock, [this]() { return m_stopping || !m_tasks.empty(); });
+
+        if(m_tasks.empty())
+          return; // stopping and drained
+
+        task = std::move(m_tasks.front());
+        m_tasks.pop();
+      }
+
+      task(); // exceptions end up in the task's future
+    }
+  }
+} // namespace vke
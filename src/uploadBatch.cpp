@@ -0,0 +1,197 @@
+#include "uploadBatch.hpp"
+
+namespace vke
+{
+  UploadBatch::UploadBatch(Device& device) :
+    m_device{device}
+  {
+  }
+
+  UploadBatch::~UploadBatch()
+  {
+    if(m_fence) {
+      wait();
+      vkDestroyFence(m_device, m_fence, nullptr);
+    }
+
+    if(m_commandBuffer)
+      vkFreeCommandBuffers(m_device, m_device.commandPools().transfer, 1, &m_commandBuffer);
+  }
+
+  void UploadBatch::add(VkBuffer destination, std::span<const std::byte> data, VkDeviceSize destinationOffset)
+  {
+    assert("Batch already submitted" && !m_fence);
+
+    if(data.empty())
+      return;
+
+    m_regions.push_back({
+      .destination = destination,
+      .data = data,
+      .stagingOffset = m_size,
+      .destinationOffset = destinationOffset,
+    });
+
+    m_size += data.size();
+  }
+
+  void UploadBatch::add(VkImage destination, std::span<const std::byte> data, std::span<const VkBufferImageCopy> copies)
+  {
+    assert("Batch already submitted" && !m_fence);
+
+    if(data.empty() || copies.empty())
+      return;
+
+    VkDeviceSize stagingOffset{(m_size + imageAlignment - 1) / imageAlignment * imageAlignment};
+
+    ImageRegion region{
+      .destination = destination,
+      .data = data,
+      .stagingOffset = stagingOffset,
+      .copies = {copies.begin(), copies.end()},
+      .range = {.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT},
+    };
+
+    for(VkBufferImageCopy& copy : region.copies) {
+      assert("Image copy outside its data" && copy.bufferOffset < data.size());
+      copy.bufferOffset += stagingOffset;
+
+      const auto& layers{copy.imageSubresource};
+      region.range.levelCount = std::max(region.range.levelCount, layers.mipLevel + 1);
+      region.range.layerCount = std::max(region.range.layerCount, layers.baseArrayLayer + layers.layerCount);
+    }
+
+    m_images.push_back(std::move(region));
+    m_size = stagingOffset + data.size();
+  }
+
+  // every image in one barrier to the transfer layout and one out of it. the second waits on nothing past the
+  // copies, a dedicated transfer queue has no shader stages, the fence orders them before their first use
+  void UploadBatch::recordImageCopies()
+  {
+    if(m_images.empty())
+      return;
+
+    std::vector<VkImageMemoryBarrier> barriers;
+    for(const ImageRegion& region : m_images) {
+      barriers.push_back({
+        .sType = VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER,
+        .srcAccessMask = 0,
+        .dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT,
+        .oldLayout = VK_IMAGE_LAYOUT_UNDEFINED,
+        .newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .image = region.destination,
+        .subresourceRange = region.range,
+      });
+    }
+
+    vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr, barriers.size(), barriers.data());
+
+    for(const ImageRegion& region : m_images)
+      vkCmdCopyBufferToImage(m_commandBuffer, m_staging->handle(), region.destination, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, region.copies.size(), region.copies.data());
+
+    for(VkImageMemoryBarrier& barrier : barriers) {
+      barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+      barrier.dstAccessMask = 0;
+      barrier.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+      barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    }
+
+    vkCmdPipelineBarrier(m_commandBuffer, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0, 0, nullptr, 0, nullptr, barriers.size(), barriers.data());
+  }
+
+  void UploadBatch::submit()
+  {
+    VKE_PROFILE_FUNCTION();
+
+    assert("Batch already submitted" && !m_fence);
+
+    VkFenceCreateInfo fenceInfo{
+      .sType = VK_STRUCTURE_TYPE_FENCE_CREATE_INFO,
+      .flags = empty() ? VK_FENCE_CREATE_SIGNALED_BIT : VkFenceCreateFlags{},
+    };
+
+    if(vkCreateFence(m_device, &fenceInfo, nullptr, &m_fence) != VK_SUCCESS)
+      throw std::runtime_error("Failed to create upload fence");
+
+    if(empty())
+      return;
+
+    m_staging = std::make_unique<Buffer>(
+      m_device,
+      1,
+      m_size,
+      VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+      VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
+
+    m_staging->mapMemory();
+    for(const Region& region : m_regions)
+      m_staging->write(region.data.data(), region.data.size(), region.stagingOffset);
+    for(const ImageRegion& region : m_images)
+      m_staging->write(region.data.data(), region.data.size(), region.stagingOffset);
+    m_staging->unmapMemory();
+
+    VkCommandBufferAllocateInfo allocInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO,
+      .commandPool = m_device.commandPools().transfer,
+      .level = VK_COMMAND_BUFFER_LEVEL_PRIMARY,
+      .commandBufferCount = 1,
+    };
+
+    if(vkAllocateCommandBuffers(m_device, &allocInfo, &m_commandBuffer) != VK_SUCCESS)
+      throw std::runtime_error("Failed to allocate upload command buffer");
+
+    VkCommandBufferBeginInfo beginInfo{
+      .sType = VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO,
+      .flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT,
+    };
+
+    vkBeginCommandBuffer(m_commandBuffer, &beginInfo);
+
+    // one vkCmdCopyBuffer per destination, consecutive regions usually share it
+    std::vector<VkBufferCopy> copies;
+    for(size_t i{}; i < m_regions.size(); ++i) {
+      const Region& region{m_regions[i]};
+      copies.push_back({
+        .srcOffset = region.stagingOffset,
+        .dstOffset = region.destinationOffset,
+        .size = region.data.size(),
+      });
+
+      if(i + 1 == m_regions.size() || m_regions[i + 1].destination != region.destination) {
+        vkCmdCopyBuffer(m_commandBuffer, m_staging->handle(), region.destination, copies.size(), copies.data());
+        copies.clear();
+      }
+    }
+
+    recordImageCopies();
+
+    vkEndCommandBuffer(m_commandBuffer);
+
+    VkSubmitInfo submitInfo{
+      .sType = VK_STRUCTURE_TYPE_SUBMIT_INFO,
+      .commandBufferCount = 1,
+      .pCommandBuffers = &m_commandBuffer,
+    };
+
+    if(vkQueueSubmit(m_device.queues().transfer, 1, &submitInfo, m_fence) != VK_SUCCESS)
+      throw std::runtime_error("Failed to submit upload batch");
+
+    // the sources are in the staging buffer now
+    m_regions.clear();
+    m_images.clear();
+  }
+
+  bool UploadBatch::isComplete() const
+  {
+    return m_fence && vkGetFenceStatus(m_device, m_fence) == VK_SUCCESS;
+  }
+
+  void UploadBatch::wait() const
+  {
+    if(m_fence)
+      vkWaitForFences(m_device, 1, &m_fence, VK_TRUE, std::numeric_limits<uint64_t>::max());
+  }
+} // namespace vke
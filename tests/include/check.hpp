@@ -0,0 +1,22 @@
+#pragma once
+
+#include <iostream>
+
+// what every test binary reports with: a line per check, and main returns result()
+namespace vke::test
+{
+  inline int failures{};
+
+  inline void check(bool condition, const char* what)
+  {
+    std::cout << (condition ? "[ OK ] " : "[FAIL] ") << what << '\n';
+    failures += !condition;
+  }
+
+  // prints the verdict, the exit code
+  inline auto result() -> int
+  {
+    std::cout << (failures ? "FAILED" : "PASSED") << '\n';
+    return failures ? 1 : 0;
+  }
+} // namespace vke::test
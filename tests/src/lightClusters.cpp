@@ -0,0 +1,88 @@
+#include "lightClusters.hpp"
+#include "check.hpp"
+
+#include <random>
+
+// cpu only checks of the light binning: every point inside the frustum finds each light reaching it in its
+// froxel, and the froxels stay tight enough to be worth it.
+//   xmake run lightClustersTest
+
+using vke::test::check;
+
+int main()
+{
+  using vke::LightClusters;
+
+  constexpr float near{0.1f};
+  constexpr float far{50.f};
+
+  vke::Camera camera{};
+  camera.setPerspectiveProjection(glm::radians(50.f), 16.f / 9.f, near, far);
+  camera.setViewTarget({2.f, -1.f, -6.f}, {0.f, 0.f, 0.f});
+
+  std::mt19937 random{42};
+  std::uniform_real_distribution<float> unit{0.f, 1.f};
+
+  // lights spread around the origin, many of them reaching out of the view
+  std::vector<LightClusters::Light> lights;
+  for(int i{}; i < 500; ++i) {
+    glm::vec3 position{unit(random) * 30.f - 15.f, unit(random) * 6.f - 3.f, unit(random) * 30.f - 15.f};
+    lights.push_back({.position = {position, 0.3f + unit(random) * 2.f}, .color = {1.f, 1.f, 1.f, 1.f}});
+  }
+
+  std::vector<LightClusters::Cluster> clusters;
+  std::vector<uint32_t> indices;
+  LightClusters::assign(lights, camera.view(), camera.projection(), near, far, &clusters, &indices);
+
+  bool ranges{clusters.size() == LightClusters::clusterCount};
+  uint32_t next{};
+  for(const auto& cluster : clusters) {
+    ranges &= cluster.offset == next;
+    next += cluster.count;
+  }
+  ranges &= next == indices.size();
+  check(ranges, "froxel ranges are consecutive and cover the indices");
+
+  // points in front of the camera, inside the frustum
+  glm::mat4 inverseView{glm::inverse(camera.view())};
+  uint32_t samples{};
+  uint32_t reached{};
+  bool complete{true};
+  for(int i{}; i < 20000; ++i) {
+    float z{near + unit(random) * unit(random) * 20.f};
+    glm::vec3 view{(unit(random) * 2.f - 1.f) * z / camera.projection()[0][0], (unit(random) * 2.f - 1.f) * z / camera.projection()[1][1], z};
+    glm::vec3 world{inverseView * glm::vec4{view, 1.f}};
+
+    const auto& cluster{clusters[LightClusters::clusterIndex(view, camera.projection(), near, far)]};
+    std::span<const uint32_t> listed{indices.data() + cluster.offset, cluster.count};
+
+    ++samples;
+    for(uint32_t light{}; light < lights.size(); ++light) {
+      if(glm::length(glm::vec3{lights[light].position} - world) >= lights[light].position.w)
+        continue;
+
+      ++reached;
+      complete &= std::ranges::find(listed, light) != listed.end();
+    }
+  }
+
+  check(complete, "every light reaching a point is in its froxel");
+
+  // lights listed per shaded point against the ones actually reaching it
+  double listedPerSample{};
+  for(const auto& cluster : clusters)
+    listedPerSample += cluster.count;
+  listedPerSample /= clusters.size();
+
+  std::cout << lights.size() << " lights, " << indices.size() << " froxel entries, " << static_cast<double>(reached) / samples
+            << " lights reach a point, " << listedPerSample << " listed per froxel\n";
+  check(listedPerSample < lights.size() * 0.05, "a froxel lists a small part of the lights");
+
+  {
+    std::vector<LightClusters::Light> behind{{.position = {glm::vec3{inverseView * glm::vec4{0.f, 0.f, -3.f, 1.f}}, 1.f}, .color = {}}};
+    LightClusters::assign(behind, camera.view(), camera.projection(), near, far, &clusters, &indices);
+    check(indices.empty(), "a light behind the camera is in no froxel");
+  }
+
+  return vke::test::result();
+}
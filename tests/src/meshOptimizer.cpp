@@ -0,0 +1,130 @@
+#include "meshOptimizer.hpp"
+#include "check.hpp"
+
+#include <random>
+
+// cpu only checks of the import time mesh optimizer: the triangles survive every stage unchanged (same
+// corners, same winding), the cache order beats a shuffled one, and the fetch order is first use order.
+//   xmake run meshOptimizerTest
+
+using vke::test::check;
+
+namespace
+{
+  // quads of two triangles, triangles shuffled so the input order is as bad as it gets
+  auto shuffledGrid(uint32_t size) -> vke::Model::Builder
+  {
+    vke::Model::Builder builder{};
+
+    for(uint32_t y{}; y <= size; ++y) {
+      for(uint32_t x{}; x <= size; ++x)
+        builder.vertices.push_back({.position = {x * 0.1f, 0.f, y * 0.1f}, .color = {1.f, 1.f, 1.f}, .normal = {0.f, 1.f, 0.f}, .uv = {x / float(size), y / float(size)}});
+    }
+
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for(uint32_t y{}; y < size; ++y) {
+      for(uint32_t x{}; x < size; ++x) {
+        uint32_t a{y * (size + 1) + x};
+        uint32_t b{a + size + 1};
+        triangles.push_back({a, b, a + 1});
+        triangles.push_back({a + 1, b, b + 1});
+      }
+    }
+
+    std::shuffle(triangles.begin(), triangles.end(), std::mt19937{42});
+    for(const auto& triangle : triangles)
+      builder.indices.insert(builder.indices.end(), triangle.begin(), triangle.end());
+
+    // a vertex nobody uses, the fetch stage drops it
+    builder.vertices.push_back({.position = {-1.f, -1.f, -1.f}});
+
+    return builder;
+  }
+
+  // the triangles as position triples, rotated to start at their smallest corner so the winding is kept
+  auto triangleSet(const vke::Model::Builder& builder) -> std::vector<std::array<float, 9>>
+  {
+    std::vector<std::array<float, 9>> triangles;
+
+    for(size_t i{}; i < builder.indices.size(); i += 3) {
+      std::array<std::array<float, 3>, 3> corners{};
+      for(size_t j{}; j < 3; ++j) {
+        const glm::vec3& position{builder.vertices[builder.indices[i + j]].position};
+        corners[j] = {position.x, position.y, position.z};
+      }
+
+      std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+
+      std::array<float, 9> triangle{};
+      for(size_t j{}; j < 3; ++j)
+        std::copy(corners[j].begin(), corners[j].end(), triangle.begin() + j * 3);
+
+      triangles.push_back(triangle);
+    }
+
+    std::ranges::sort(triangles);
+    return triangles;
+  }
+
+  bool isFirstUseOrder(const vke::Model::Builder& builder)
+  {
+    uint32_t next{};
+    for(uint32_t index : builder.indices) {
+      if(index > next)
+        return false;
+
+      next += index == next;
+    }
+
+    return next == builder.vertices.size();
+  }
+} // namespace
+
+int main()
+{
+  using vke::MeshOptimizer;
+
+  {
+    std::vector<uint32_t> triangle{0, 1, 2};
+    check(MeshOptimizer::acmr(triangle, 3) == 3.f, "acmr of a single triangle is 3");
+
+    std::vector<uint32_t> twice{0, 1, 2, 2, 1, 0};
+    check(MeshOptimizer::acmr(twice, 3) == 1.5f, "acmr counts cache hits");
+  }
+
+  {
+    auto builder{shuffledGrid(64)};
+    auto reference{triangleSet(builder)};
+
+    auto report{MeshOptimizer::optimize(&builder)};
+    std::cout << "grid 64x64: ACMR " << report.acmrBefore << " -> " << report.acmrAfter << ", ATVR " << report.atvrBefore << " -> " << report.atvrAfter << '\n';
+
+    check(triangleSet(builder) == reference, "optimize keeps every triangle and its winding");
+    check(report.acmrAfter < report.acmrBefore, "optimize lowers the ACMR");
+    check(report.acmrAfter < 0.85f, "optimized grid ACMR below 0.85");
+    check(isFirstUseOrder(builder), "vertices in first use order, unused dropped");
+    check(builder.vertices.size() == 65 * 65, "unused vertex dropped");
+  }
+
+  {
+    auto builder{shuffledGrid(32)};
+    auto reference{triangleSet(builder)};
+    auto vertexCount{static_cast<uint32_t>(builder.vertices.size())};
+
+    MeshOptimizer::optimizeVertexCache(builder.indices, vertexCount);
+    float cacheAcmr{MeshOptimizer::acmr(builder.indices, vertexCount)};
+    check(triangleSet(builder) == reference, "vertex cache stage keeps the triangles");
+
+    MeshOptimizer::optimizeOverdraw(builder.indices, builder.vertices, 1.05f);
+    check(triangleSet(builder) == reference, "overdraw stage keeps the triangles");
+    check(MeshOptimizer::acmr(builder.indices, vertexCount) <= cacheAcmr * 1.05f + 1e-4f, "overdraw stage stays within its threshold");
+  }
+
+  {
+    vke::Model::Builder empty{};
+    auto report{MeshOptimizer::optimize(&empty)};
+    check(report.acmrBefore == 0.f && empty.indices.empty(), "empty builder is left alone");
+  }
+
+  return vke::test::result();
+}
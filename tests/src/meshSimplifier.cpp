@@ -0,0 +1,149 @@
+#include "meshSimplifier.hpp"
+#include "check.hpp"
+
+// cpu only checks of the lod generation: the simplified lists are valid and smaller, stay close to the
+// surface, keep open borders in place, and the lod errors only grow.
+//   xmake run meshSimplifierTest
+
+using vke::test::check;
+
+namespace
+{
+  // latitude/longitude sphere, closed and welded (the poles and the wrap share their vertices)
+  auto sphere(uint32_t rings, uint32_t segments) -> vke::Model::Builder
+  {
+    vke::Model::Builder builder{};
+
+    auto vertex = [&](glm::vec3 position) {
+      builder.vertices.push_back({.position = position, .color = {1.f, 1.f, 1.f}, .normal = position, .uv = {}});
+      return static_cast<uint32_t>(builder.vertices.size() - 1);
+    };
+
+    uint32_t top{vertex({0.f, 1.f, 0.f})};
+    for(uint32_t ring{1}; ring < rings; ++ring) {
+      float theta{glm::pi<float>() * ring / rings};
+      for(uint32_t segment{}; segment < segments; ++segment) {
+        float phi{2.f * glm::pi<float>() * segment / segments};
+        vertex({std::sin(theta) * std::cos(phi), std::cos(theta), std::sin(theta) * std::sin(phi)});
+      }
+    }
+    uint32_t bottom{vertex({0.f, -1.f, 0.f})};
+
+    auto ringVertex = [&](uint32_t ring, uint32_t segment) { return 1 + (ring - 1) * segments + segment % segments; };
+    auto triangle = [&](uint32_t a, uint32_t b, uint32_t c) { builder.indices.insert(builder.indices.end(), {a, b, c}); };
+
+    for(uint32_t segment{}; segment < segments; ++segment) {
+      triangle(top, ringVertex(1, segment + 1), ringVertex(1, segment));
+      triangle(bottom, ringVertex(rings - 1, segment), ringVertex(rings - 1, segment + 1));
+
+      for(uint32_t ring{1}; ring + 1 < rings; ++ring) {
+        uint32_t a{ringVertex(ring, segment)};
+        uint32_t b{ringVertex(ring, segment + 1)};
+        uint32_t c{ringVertex(ring + 1, segment)};
+        uint32_t d{ringVertex(ring + 1, segment + 1)};
+        triangle(a, b, c);
+        triangle(b, d, c);
+      }
+    }
+
+    return builder;
+  }
+
+  bool isValid(std::span<const uint32_t> indices, size_t vertexCount)
+  {
+    for(size_t i{}; i < indices.size(); i += 3) {
+      uint32_t a{indices[i]}, b{indices[i + 1]}, c{indices[i + 2]};
+      if(a >= vertexCount || b >= vertexCount || c >= vertexCount || a == b || b == c || a == c)
+        return false;
+    }
+
+    return indices.size() % 3 == 0;
+  }
+} // namespace
+
+int main()
+{
+  using vke::MeshSimplifier;
+
+  {
+    auto builder{sphere(64, 128)};
+    size_t target{builder.indices.size() / 4 / 3 * 3};
+
+    float error{};
+    auto simplified{MeshSimplifier::simplify(builder.indices, builder.vertices, target, std::numeric_limits<float>::max(), &error)};
+    std::cout << "sphere: " << builder.indices.size() / 3 << " -> " << simplified.size() / 3 << " triangles, error " << error << '\n';
+
+    check(isValid(simplified, builder.vertices.size()), "simplified sphere has valid, non degenerate triangles");
+    check(simplified.size() <= target, "simplified sphere reaches its target");
+    check(error > 0.f && error < 0.05f, "simplified sphere stays within 5% of its radius");
+
+    // every kept vertex is an original one, still on the unit sphere
+    bool onSurface{true};
+    for(uint32_t index : simplified)
+      onSurface &= std::abs(glm::length(builder.vertices[index].position) - 1.f) < 1e-4f;
+    check(onSurface, "lods only index original vertices");
+  }
+
+  {
+    auto builder{sphere(16, 32)};
+    float error{};
+    auto simplified{MeshSimplifier::simplify(builder.indices, builder.vertices, 3, 1e-6f, &error)};
+    check(simplified.size() == builder.indices.size() && error <= 1e-6f, "maxError stops the simplification");
+  }
+
+  {
+    // a flat open grid: the inside collapses for free, the border stays where it is
+    vke::Model::Builder grid{};
+    constexpr uint32_t size{16};
+    for(uint32_t y{}; y <= size; ++y) {
+      for(uint32_t x{}; x <= size; ++x)
+        grid.vertices.push_back({.position = {float(x), 0.f, float(y)}});
+    }
+    for(uint32_t y{}; y < size; ++y) {
+      for(uint32_t x{}; x < size; ++x) {
+        uint32_t a{y * (size + 1) + x};
+        uint32_t b{a + size + 1};
+        grid.indices.insert(grid.indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+      }
+    }
+
+    float error{};
+    auto simplified{MeshSimplifier::simplify(grid.indices, grid.vertices, 3, std::numeric_limits<float>::max(), &error)};
+
+    std::vector<bool> used(grid.vertices.size());
+    for(uint32_t index : simplified)
+      used[index] = true;
+
+    bool bordersKept{true};
+    for(uint32_t i{}; i <= size; ++i) {
+      bordersKept &= used[i] && used[size * (size + 1) + i];
+      bordersKept &= used[i * (size + 1)] && used[i * (size + 1) + size];
+    }
+
+    check(isValid(simplified, grid.vertices.size()) && simplified.size() < grid.indices.size(), "flat grid simplifies");
+    check(bordersKept, "open borders are kept");
+    check(error < 1e-4f, "flat grid simplifies without error");
+  }
+
+  {
+    auto builder{sphere(64, 128)};
+    builder.generateLods(4, 0.5f);
+
+    check(builder.lods.size() == 4, "sphere gets 4 lods");
+
+    bool shrinking{true};
+    bool monotonic{true};
+    for(size_t i{1}; i < builder.lods.size(); ++i) {
+      const auto& lod{builder.lods[i]};
+      const auto& previous{builder.lods[i - 1]};
+      shrinking &= lod.indexCount < previous.indexCount && lod.firstIndex == previous.firstIndex + previous.indexCount;
+      monotonic &= lod.error >= previous.error;
+      shrinking &= isValid(std::span{builder.indices}.subspan(lod.firstIndex, lod.indexCount), builder.vertices.size());
+    }
+
+    check(shrinking, "lods are consecutive, valid and smaller each time");
+    check(monotonic, "lod errors only grow");
+  }
+
+  return vke::test::result();
+}
@@ -0,0 +1,133 @@
+#include "meshletBuilder.hpp"
+#include "check.hpp"
+
+// cpu only checks of the meshlet partition: every triangle lands in exactly one meshlet within the limits,
+// the bounds hold their triangles, a camera inside a cone only sees back faces, and submeshes never cut one.
+//   xmake run meshletBuilderTest
+
+using vke::test::check;
+
+namespace
+{
+  // a height field, smooth enough for the cones to be narrow
+  auto terrain(uint32_t size) -> vke::Model::Builder
+  {
+    vke::Model::Builder builder{};
+    for(uint32_t y{}; y <= size; ++y) {
+      for(uint32_t x{}; x <= size; ++x) {
+        float height{0.5f * std::sin(x * 0.05f) * std::cos(y * 0.05f)};
+        builder.vertices.push_back({.position = {float(x), height, float(y)}, .color = {1.f, 1.f, 1.f}, .normal = {0.f, 1.f, 0.f}, .uv = {}});
+      }
+    }
+    for(uint32_t y{}; y < size; ++y) {
+      for(uint32_t x{}; x < size; ++x) {
+        uint32_t a{y * (size + 1) + x};
+        uint32_t b{a + size + 1};
+        builder.indices.insert(builder.indices.end(), {a, b, a + 1, a + 1, b, b + 1});
+      }
+    }
+
+    return builder;
+  }
+
+  auto sortedTriangles(std::span<const uint32_t> indices) -> std::vector<std::array<uint32_t, 3>>
+  {
+    std::vector<std::array<uint32_t, 3>> triangles;
+    for(size_t i{}; i < indices.size(); i += 3) {
+      // rotated so the smallest index leads, the winding stays
+      std::array<uint32_t, 3> triangle{indices[i], indices[i + 1], indices[i + 2]};
+      std::ranges::rotate(triangle, std::ranges::min_element(triangle));
+      triangles.push_back(triangle);
+    }
+
+    std::ranges::sort(triangles);
+    return triangles;
+  }
+} // namespace
+
+int main()
+{
+  using vke::MeshletBuilder;
+
+  {
+    auto builder{terrain(128)};
+    auto original{builder.indices};
+    auto meshlets{MeshletBuilder::build(builder.indices, builder.vertices)};
+
+    check(sortedTriangles(original) == sortedTriangles(builder.indices), "the triangles are only reordered");
+
+    bool contiguous{true};
+    bool withinLimits{true};
+    bool bounded{true};
+    uint32_t next{};
+    for(const auto& meshlet : meshlets) {
+      contiguous &= meshlet.firstIndex == next;
+      next = meshlet.firstIndex + meshlet.triangleCount * 3;
+
+      std::vector<uint32_t> used{builder.indices.begin() + meshlet.firstIndex, builder.indices.begin() + next};
+      for(uint32_t v : used)
+        bounded &= glm::length(builder.vertices[v].position - meshlet.center) <= meshlet.radius * 1.0001f;
+
+      std::ranges::sort(used);
+      withinLimits &= std::ranges::unique(used).begin() - used.begin() == meshlet.vertexCount;
+      withinLimits &= meshlet.vertexCount <= MeshletBuilder::maxVertices && meshlet.triangleCount <= MeshletBuilder::maxTriangles;
+    }
+    contiguous &= next == builder.indices.size();
+
+    float fill{static_cast<float>(builder.indices.size() / 3) / meshlets.size()};
+    std::cout << "terrain: " << builder.indices.size() / 3 << " triangles, " << meshlets.size() << " meshlets, " << fill << " triangles each\n";
+
+    check(contiguous, "meshlets are consecutive and cover every index");
+    check(withinLimits, "meshlets stay within 64 vertices and 124 triangles");
+    check(bounded, "bounding spheres hold their vertices");
+    check(fill > 80.f, "meshlets are mostly full");
+
+    // from a point inside the cone, beyond the apex, every triangle of the meshlet faces away
+    bool culledAreBackFacing{true};
+    uint32_t cullable{};
+    for(const auto& meshlet : meshlets) {
+      if(meshlet.coneCutoff >= 1.f)
+        continue;
+
+      ++cullable;
+      glm::vec3 camera{meshlet.coneApex - meshlet.coneAxis * 10.f};
+      if(glm::dot(glm::normalize(meshlet.coneApex - camera), meshlet.coneAxis) < meshlet.coneCutoff)
+        continue;
+
+      for(uint32_t i{meshlet.firstIndex}; i < meshlet.firstIndex + meshlet.triangleCount * 3; i += 3) {
+        const glm::vec3& p0{builder.vertices[builder.indices[i]].position};
+        const glm::vec3& p1{builder.vertices[builder.indices[i + 1]].position};
+        const glm::vec3& p2{builder.vertices[builder.indices[i + 2]].position};
+        culledAreBackFacing &= glm::dot(glm::cross(p1 - p0, p2 - p0), camera - p0) <= 0.f;
+      }
+    }
+
+    check(cullable == meshlets.size(), "a smooth surface gets a cone for every meshlet");
+    check(culledAreBackFacing, "cone culling only drops back facing meshlets");
+  }
+
+  {
+    // more than 65536 vertices: the submesh cuts fall between meshlets
+    auto builder{terrain(300)};
+    builder.buildMeshlets();
+    builder.shortenIndices();
+
+    check(builder.submeshes.size() > 1, "big terrain is split into submeshes");
+
+    bool uncut{true};
+    for(const auto& meshlet : builder.meshlets) {
+      auto holder{std::ranges::find_if(builder.submeshes, [&](const auto& range) { return meshlet.firstIndex < range.firstIndex + range.indexCount; })};
+      uncut &= meshlet.firstIndex + meshlet.triangleCount * 3 <= holder->firstIndex + holder->indexCount;
+      uncut &= meshlet.vertexOffset == holder->vertexOffset;
+    }
+    check(uncut, "meshlets never straddle two submeshes");
+  }
+
+  {
+    auto builder{terrain(16)};
+    builder.buildMeshlets();
+    check(builder.meshlets.empty(), "small meshes aren't clustered");
+  }
+
+  return vke::test::result();
+}
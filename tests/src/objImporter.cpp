@@ -0,0 +1,84 @@
+#include "objImporter.hpp"
+
+// throughput of the parallel importer against the tinyobjloader path it replaces, and a check
+// that both produce the same vertices and indices.
+//   xmake run objImporterBenchmark [file.obj] [repetitions]
+// without a file a large grid mesh is generated in the temp directory.
+
+namespace
+{
+  auto generateGrid(uint32_t size) -> std::filesystem::path
+  {
+    auto path{std::filesystem::temp_directory_path() / "vke_objImporterBenchmark.obj"};
+    std::ofstream file{path};
+
+    for(uint32_t y{}; y <= size; ++y) {
+      for(uint32_t x{}; x <= size; ++x) {
+        file << "v " << x * 0.01f << ' ' << ((x * y) % 7) * 0.1f << ' ' << y * 0.01f << '\n';
+        file << "vt " << x / float(size) << ' ' << y / float(size) << '\n';
+      }
+    }
+
+    file << "vn 0 1 0\n";
+
+    // quads, shared corners get welded
+    for(uint32_t y{}; y < size; ++y) {
+      for(uint32_t x{}; x < size; ++x) {
+        uint32_t a{y * (size + 1) + x + 1};
+        uint32_t b{a + size + 1};
+        file << "f " << a << '/' << a << "/1 " << a + 1 << '/' << a + 1 << "/1 " << b + 1 << '/' << b + 1 << "/1 " << b << '/' << b << "/1\n";
+      }
+    }
+
+    return path;
+  }
+
+  template<typename F>
+  auto measure(F&& function, uint32_t repetitions) -> double
+  {
+    double best{std::numeric_limits<double>::max()};
+    for(uint32_t i{}; i < repetitions; ++i) {
+      auto begin{std::chrono::steady_clock::now()};
+      function();
+      best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count());
+    }
+
+    return best;
+  }
+} // namespace
+
+int main(int argc, char** argv)
+{
+  auto path{argc > 1 ? std::filesystem::path{argv[1]} : generateGrid(2000)};
+  uint32_t repetitions{argc > 2 ? static_cast<uint32_t>(std::stoul(argv[2])) : 3u};
+  double megabytes{std::filesystem::file_size(path) / (1024.0 * 1024.0)};
+
+  vke::ThreadPool threadPool;
+  vke::Model::Builder reference, serial, parallel;
+
+  double referenceTime{measure([&]() { vke::ObjImporter::importReference(path, &reference); }, repetitions)};
+  double serialTime{measure([&]() { vke::ObjImporter{}.import(path, &serial); }, repetitions)};
+  double parallelTime{measure([&]() { vke::ObjImporter{&threadPool}.import(path, &parallel); }, repetitions)};
+
+  std::cout << path.string() << ": " << std::fixed << std::setprecision(1) << megabytes << " MB, "
+            << reference.vertices.size() << " vertices, " << reference.indices.size() / 3 << " triangles\n";
+
+  auto report{[megabytes, referenceTime](const char* name, double seconds) {
+    std::cout << "  " << std::left << std::setw(22) << name << std::right
+              << std::setw(9) << seconds * 1000.0 << " ms "
+              << std::setw(9) << megabytes / seconds << " MB/s "
+              << std::setw(6) << referenceTime / seconds << "x\n";
+  }};
+
+  report("tinyobjloader", referenceTime);
+  report("importer, 1 thread", serialTime);
+  report(("importer, " + std::to_string(threadPool.size() + 1) + " threads").c_str(), parallelTime);
+
+  bool identical{
+    serial.vertices == reference.vertices && serial.indices == reference.indices &&
+    parallel.vertices == reference.vertices && parallel.indices == reference.indices,
+  };
+
+  std::cout << (identical ? "output matches tinyobjloader\n" : "output DIFFERS from tinyobjloader\n");
+  return identical ? 0 : 1;
+}
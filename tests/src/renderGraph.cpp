@@ -0,0 +1,86 @@
+#include "renderGraph.hpp"
+#include "check.hpp"
+
+// cpu only checks of the render graph's barrier planning: every read waits for the write before it, even in
+// the stages it was written in, and reads that were already synchronized (or only follow reads) don't.
+//   xmake run renderGraphTest
+
+using vke::test::check;
+
+namespace
+{
+  using Graph = vke::RenderGraph;
+
+  constexpr VkPipelineStageFlags compute{VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT};
+  constexpr VkPipelineStageFlags fragment{VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT};
+
+  auto write(VkPipelineStageFlags stages) -> Graph::Access
+  {
+    return {.usage = Graph::Usage::buffer, .stages = stages, .access = VK_ACCESS_SHADER_WRITE_BIT, .write = true};
+  }
+
+  auto read(VkPipelineStageFlags stages) -> Graph::Access
+  {
+    return {.usage = Graph::Usage::buffer, .stages = stages, .access = VK_ACCESS_SHADER_READ_BIT};
+  }
+
+  auto texture(VkImageLayout layout, VkPipelineStageFlags stages, bool write) -> Graph::Access
+  {
+    return {.usage = Graph::Usage::sampled, .layout = layout, .stages = stages, .access = write ? VK_ACCESS_SHADER_WRITE_BIT : VK_ACCESS_SHADER_READ_BIT, .write = write};
+  }
+} // namespace
+
+int main()
+{
+  {
+    // a compute pass writes a buffer the next compute pass reads
+    Graph::State state{};
+    std::vector<Graph::Barrier> barriers;
+    Graph::synchronize(&state, write(compute), false, &barriers);
+    barriers.clear();
+
+    Graph::synchronize(&state, read(compute), false, &barriers);
+    check(barriers.size() == 1, "a read in the stages of the write before it waits for it");
+    check(!barriers.empty() && barriers[0].srcStages == compute && barriers[0].dstStages == compute &&
+            barriers[0].srcAccess == VK_ACCESS_SHADER_WRITE_BIT && barriers[0].dstAccess == VK_ACCESS_SHADER_READ_BIT,
+          "the barrier makes the shader write visible to the shader read");
+
+    barriers.clear();
+    Graph::synchronize(&state, read(compute), false, &barriers);
+    check(barriers.empty(), "a second read in the same stages needs nothing more");
+
+    Graph::synchronize(&state, read(fragment), false, &barriers);
+    check(barriers.size() == 1 && barriers[0].dstStages == fragment, "a read in other stages waits for the write too");
+
+    barriers.clear();
+    Graph::synchronize(&state, write(compute), false, &barriers);
+    check(barriers.size() == 1 && barriers[0].srcStages == (compute | fragment), "a write waits for every reader before it");
+  }
+
+  {
+    // reads of a buffer nobody wrote during the frame
+    Graph::State state{};
+    std::vector<Graph::Barrier> barriers;
+    Graph::synchronize(&state, read(compute), false, &barriers);
+    Graph::synchronize(&state, read(fragment), false, &barriers);
+    check(barriers.empty(), "reads after reads don't wait");
+  }
+
+  {
+    // a storage image written then sampled in the same layout and stage
+    Graph::State state{};
+    std::vector<Graph::Barrier> barriers;
+    Graph::synchronize(&state, texture(VK_IMAGE_LAYOUT_GENERAL, compute, true), true, &barriers);
+    barriers.clear();
+
+    Graph::synchronize(&state, texture(VK_IMAGE_LAYOUT_GENERAL, compute, false), true, &barriers);
+    check(barriers.size() == 1 && barriers[0].oldLayout == barriers[0].newLayout, "an image read waits for the write without a transition");
+
+    barriers.clear();
+    Graph::synchronize(&state, texture(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, fragment, false), true, &barriers);
+    Graph::synchronize(&state, texture(VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, fragment, false), true, &barriers);
+    check(barriers.size() == 1 && barriers[0].newLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL, "a transition is made visible to the stages it's done for");
+  }
+
+  return vke::test::result();
+}
@@ -0,0 +1,85 @@
+#include "renderQueue.hpp"
+#include "check.hpp"
+
+#include <random>
+
+// cpu only checks of the render queue: the radix sort matches a stable std::sort, the key fields round trip
+// and order the draws by pipeline, then material, then mesh, then depth.
+//   xmake run renderQueueTest
+
+using vke::test::check;
+
+int main()
+{
+  using vke::RenderQueue;
+
+  std::mt19937 random{42};
+  std::uniform_int_distribution<uint32_t> pipelines{0, 7};
+  std::uniform_int_distribution<uint32_t> materials{0, 40};
+  std::uniform_int_distribution<uint32_t> meshes{0, 200};
+  std::uniform_real_distribution<float> depths{0.f, 1.f};
+
+  // a frame worth of draws, few pipelines, more materials and meshes, every depth
+  std::vector<RenderQueue::Entry> entries;
+  for(uint32_t i{}; i < 20000; ++i)
+    entries.push_back({RenderQueue::makeKey(0, pipelines(random), materials(random), meshes(random), depths(random)), i});
+
+  {
+    auto expected{entries};
+    std::ranges::stable_sort(expected, {}, &RenderQueue::Entry::key);
+
+    std::vector<RenderQueue::Entry> scratch;
+    auto sorted{entries};
+    RenderQueue::radixSort(&sorted, &scratch);
+
+    check(std::ranges::equal(sorted, expected, [](auto& a, auto& b) { return a.key == b.key && a.item == b.item; }), "radix sort matches a stable std::sort");
+  }
+
+  {
+    // only the depth differs, the passes over the higher bytes are skipped
+    std::vector<RenderQueue::Entry> scratch;
+    std::vector<RenderQueue::Entry> sameState;
+    for(uint32_t i{}; i < 1000; ++i)
+      sameState.push_back({RenderQueue::makeKey(1, 3, 7, 9, depths(random)), i});
+
+    RenderQueue::radixSort(&sameState, &scratch);
+    check(std::ranges::is_sorted(sameState, {}, &RenderQueue::Entry::key), "keys sharing all but the depth are sorted");
+  }
+
+  {
+    auto key{RenderQueue::makeKey(5, 200, 40000, 1234, 0.5f)};
+    check(RenderQueue::pass(key) == 5 && RenderQueue::pipeline(key) == 200 && RenderQueue::material(key) == 40000 && RenderQueue::mesh(key) == 1234,
+      "the key fields round trip");
+
+    check(RenderQueue::makeKey(0, 1, 0, 0, 0.f) > RenderQueue::makeKey(0, 0, 0xffff, 0xffff, 1.f), "the pipeline outweighs the material, mesh and depth");
+    check(RenderQueue::makeKey(0, 0, 1, 0, 0.f) > RenderQueue::makeKey(0, 0, 0, 0xffff, 1.f), "the material outweighs the mesh and depth");
+    check(RenderQueue::makeKey(0, 0, 0, 0, 0.25f) < RenderQueue::makeKey(0, 0, 0, 0, 0.5f), "nearer draws come first");
+    check(RenderQueue::depth(RenderQueue::makeKey(0, 0, 0, 0, 2.f)) == RenderQueue::depth(RenderQueue::makeKey(0, 0, 0, 0, 1.f)), "the depth is clamped");
+  }
+
+  {
+    // the state changes left after sorting, against the shuffled order
+    RenderQueue queue;
+    for(const auto& entry : entries)
+      queue.push(entry.key, entry.item);
+
+    auto changes = [](std::span<const RenderQueue::Entry> sorted) {
+      uint32_t count{};
+      std::optional<uint32_t> material;
+      for(const auto& entry : sorted) {
+        count += RenderQueue::material(entry.key) != material;
+        material = RenderQueue::material(entry.key);
+      }
+      return count;
+    };
+
+    uint32_t before{changes(queue.entries())};
+    queue.sort();
+    uint32_t after{changes(queue.entries())};
+
+    std::cout << queue.size() << " draws, " << before << " material changes unsorted, " << after << " sorted\n";
+    check(after <= 8 * 41, "sorted, a material is bound at most once per pipeline");
+  }
+
+  return vke::test::result();
+}
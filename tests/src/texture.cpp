@@ -0,0 +1,132 @@
+#include "texture.hpp"
+#include "check.hpp"
+
+// cpu only checks of the texture loading: the generated mip chain is complete and keeps the average color
+// (in linear space for srgb), and ktx2 files are parsed, or refused when they can't be uploaded as they are.
+//   xmake run textureTest
+
+using vke::test::check;
+
+namespace
+{
+  // a 2d ktx2 file without supercompression, its levels (finest first) after the level index
+  auto ktx2(VkFormat format, uint32_t width, uint32_t height, std::span<const uint64_t> levelSizes, uint32_t supercompression = 0) -> std::vector<std::byte>
+  {
+    std::vector<std::byte> file(80 + 24 * levelSizes.size());
+    auto put = [&](size_t offset, auto value) { std::memcpy(file.data() + offset, &value, sizeof(value)); };
+
+    constexpr std::array<uint8_t, 12> identifier{0xAB, 'K', 'T', 'X', ' ', '2', '0', 0xBB, '\r', '\n', 0x1A, '\n'};
+    std::memcpy(file.data(), identifier.data(), identifier.size());
+
+    std::array<uint32_t, 9> header{static_cast<uint32_t>(format), 1, width, height, 0, 0, 1, static_cast<uint32_t>(levelSizes.size()), supercompression};
+    for(size_t i{}; i < header.size(); ++i)
+      put(12 + i * 4, header[i]);
+
+    for(size_t i{}; i < levelSizes.size(); ++i) {
+      uint64_t offset{(file.size() + 15) / 16 * 16};
+      put(80 + i * 24, offset);
+      put(80 + i * 24 + 8, levelSizes[i]);
+      put(80 + i * 24 + 16, levelSizes[i]);
+      file.resize(offset + levelSizes[i], std::byte{static_cast<uint8_t>(i)});
+    }
+
+    return file;
+  }
+} // namespace
+
+int main()
+{
+  using vke::Texture;
+
+  check(Texture::mipCount(256, 256) == 9 && Texture::mipCount(300, 17) == 9 && Texture::mipCount(1, 1) == 1, "mip counts down to 1x1");
+
+  {
+    // a non power of two image, half black half white
+    constexpr uint32_t width{37};
+    constexpr uint32_t height{10};
+    std::vector<uint8_t> rgba(width * height * 4);
+    for(uint32_t y{}; y < height; ++y) {
+      for(uint32_t x{}; x < width; ++x) {
+        uint8_t value{x < width / 2 ? uint8_t{0} : uint8_t{255}};
+        std::array<uint8_t, 4> texel{value, value, value, 255};
+        std::memcpy(rgba.data() + (y * width + x) * 4, texel.data(), 4);
+      }
+    }
+
+    Texture::Builder linear{};
+    linear.setPixels(std::as_bytes(std::span{rgba}), width, height, false);
+    linear.generateMips();
+
+    bool chain{linear.levels.size() == Texture::mipCount(width, height)};
+    VkDeviceSize offset{};
+    for(size_t i{}; i < linear.levels.size(); ++i) {
+      const auto& level{linear.levels[i]};
+      chain &= level.offset == offset && level.width == std::max(width >> i, 1u) && level.height == std::max(height >> i, 1u);
+      chain &= level.size == VkDeviceSize{level.width} * level.height * 4;
+      offset += level.size;
+    }
+    chain &= offset == linear.data().size();
+    check(chain, "the mip chain is complete and packed");
+
+    // every source texel lands in the last level, 18 of 37 columns are black
+    const auto* last{reinterpret_cast<const uint8_t*>(linear.data().data() + linear.levels.back().offset)};
+    check(std::abs(last[0] - 255.f * 19 / 37) <= 1.f && last[3] == 255, "the 1x1 level is the image's average");
+
+    Texture::Builder srgb{};
+    srgb.setPixels(std::as_bytes(std::span{rgba}), width, height, true);
+    srgb.generateMips();
+    const auto* lastSrgb{reinterpret_cast<const uint8_t*>(srgb.data().data() + srgb.levels.back().offset)};
+    check(lastSrgb[0] > last[0] + 30, "srgb levels are averaged in linear space");
+  }
+
+  {
+    // bc7: 16 bytes per 4x4 block, the 2x2 and 1x1 levels still take a whole block
+    std::array<uint64_t, 4> sizes{4 * 4 * 16, 2 * 2 * 16, 16, 16};
+    auto file{ktx2(VK_FORMAT_BC7_SRGB_BLOCK, 16, 16, sizes)};
+
+    Texture::Builder builder{};
+    builder.parseKtx2(file);
+
+    bool parsed{builder.format == VK_FORMAT_BC7_SRGB_BLOCK && builder.width == 16 && builder.height == 16 && builder.levels.size() == 4};
+    for(size_t i{}; i < builder.levels.size() && parsed; ++i) {
+      const auto& level{builder.levels[i]};
+      parsed &= level.width == 16u >> i && level.size == sizes[i] && level.offset % 16 == 0;
+      parsed &= builder.data()[level.offset] == std::byte{static_cast<uint8_t>(i)};
+    }
+    check(parsed, "a bc7 ktx2 maps its levels in place");
+    check(builder.pixels.empty(), "a ktx2 isn't decoded");
+  }
+
+  auto refused = [](std::vector<std::byte> file) {
+    try {
+      Texture::Builder builder{};
+      builder.parseKtx2(file);
+    } catch(const std::runtime_error&) {
+      return true;
+    }
+    return false;
+  };
+
+  std::array<uint64_t, 1> level{4 * 4 * 16};
+  check(refused(ktx2(VK_FORMAT_BC7_UNORM_BLOCK, 16, 16, level, 2)), "a supercompressed ktx2 is refused");
+  check(refused(ktx2(VK_FORMAT_UNDEFINED, 16, 16, level)), "a basis ktx2 (no vkFormat) is refused");
+
+  std::array<uint64_t, 1> truncated{100};
+  check(refused(ktx2(VK_FORMAT_BC7_UNORM_BLOCK, 16, 16, truncated)), "a level smaller than its blocks is refused");
+
+  {
+    auto file{ktx2(VK_FORMAT_R8G8B8A8_UNORM, 2, 2, std::array<uint64_t, 1>{16})};
+    file[0] = std::byte{0};
+    check(refused(file), "a file without the ktx2 identifier is refused");
+  }
+
+  {
+    // offset + size wraps around to a small value
+    auto file{ktx2(VK_FORMAT_BC7_UNORM_BLOCK, 16, 16, level)};
+    uint64_t offset{~uint64_t{} - 15};
+    std::memcpy(file.data() + 80, &offset, sizeof(offset));
+    check(refused(file), "a level offset past the end of the file is refused, even when it overflows");
+  }
+
+  return vke::test::result();
+}
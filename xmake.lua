@@ -6,7 +6,7 @@ set_languages "c++20"
 set_defaultmode "debug"
 set_policy("build.warning", true)
 
-add_requires("vulkansdk", "glm", "tinyobjloader")
+add_requires("vulkansdk", "glm", "tinyobjloader", "stb")
 add_requires("glfw", { system = false })
 add_requires("glslang", { configs = { binaryonly = true } })
 
@@ -20,21 +20,63 @@ if is_mode "debug" then
   -- add_ldflags(sanitize, "-lubsan")
 end
 
+option "profiler"
+  set_default(false)
+  set_showmenu(true)
+  set_description("Enable the CPU profiler zones, a chrome trace is written to build/trace.json on exit")
+  add_defines "VKE_ENABLE_PROFILER"
+option_end()
+
 -- Get the project root
 local project_root = os.projectdir()
 
+-- everything but main, shared by the program and the tests
+target "engine"
+  set_kind "static"
+  add_defines("GLM_ENABLE_EXPERIMENTAL", { public = true })
+  add_packages("vulkansdk", "glfw", "glm", "tinyobjloader", "stb", { public = true })
+  add_options "profiler"
+  if is_plat "linux" then
+    add_syslinks("pthread", { public = true })
+  end
+  add_includedirs("include", { public = true })
+  add_files "src/**.cpp|main.cpp"
+
 target "program"
   set_default(true)
   set_kind "binary"
-  add_defines "GLM_ENABLE_EXPERIMENTAL"
-  add_packages("vulkansdk", "glfw", "glm", "tinyobjloader")
-  add_includedirs "include"
-  add_files "src/**.cpp"
+  add_deps "engine"
+  add_options "profiler"
+  add_files "src/main.cpp"
   on_load(function (target)
       -- Export environment variable
       os.setenv("ROOT_PATH", project_root)
   end)
 
+-- benchmarks and tests, one binary per tests/src file: xmake build -g tests
+local tests = {
+  { "objImporterBenchmark", "objImporter" },
+  { "meshOptimizerTest", "meshOptimizer" },
+  { "meshSimplifierTest", "meshSimplifier" },
+  { "meshletBuilderTest", "meshletBuilder" },
+  { "lightClustersTest", "lightClusters" },
+  { "renderQueueTest", "renderQueue" },
+  { "textureTest", "texture" },
+  { "renderGraphTest", "renderGraph" },
+}
+
+for _, test in ipairs(tests) do
+  target(test[1])
+    set_default(false)
+    set_group "tests"
+    set_kind "binary"
+    add_deps "engine"
+    add_options "profiler"
+    add_includedirs "tests/include"
+    add_files("tests/src/" .. test[2] .. ".cpp")
+  target_end()
+end
+
 -- Custom shader compilation rule
 rule("shader_compile")
     set_extensions(".vert", ".frag", ".comp", ".geom", ".tesc", ".tese")